@@ -11,11 +11,13 @@ namespace Xen::Shaders {
         static cstr Vertex = R""(#version 460 core
 layout (location = 0) in vec4 aVertex;
 uniform mat4 uMVP;
+uniform vec4 uQuad = vec4(0.0, 0.0, 1.0, 1.0);
+uniform vec4 uUV = vec4(0.0, 0.0, 1.0, 1.0);
 out vec2 TexCoord;
 
 void main() {
-    vec2 position = aVertex.xy;
-    vec2 texCoord = aVertex.zw;
+    vec2 position = uQuad.xy + aVertex.xy * uQuad.zw;
+    vec2 texCoord = mix(uUV.xy, uUV.zw, aVertex.zw);
     gl_Position = uMVP * vec4(position, 0.0, 1.0);
     TexCoord = texCoord;
 }
@@ -31,4 +33,53 @@ void main() {
 }
 )"";
     }  // namespace SpriteShader
+
+    namespace BatchShader {
+        static cstr Vertex = R""(#version 460 core
+layout (location = 0) in vec4 aVertex;
+layout (location = 1) in vec4 aTransform;
+layout (location = 2) in vec4 aUV;
+layout (location = 3) in vec4 aColor;
+uniform mat4 uVP;
+out vec2 TexCoord;
+out vec4 Color;
+
+void main() {
+    vec2 position = aTransform.xy + aVertex.xy * aTransform.zw;
+    gl_Position = uVP * vec4(position, 0.0, 1.0);
+    TexCoord = mix(aUV.xy, aUV.zw, aVertex.zw);
+    Color = aColor;
+}
+)"";
+
+        static cstr Fragment = R""(#version 460 core
+out vec4 FragColor;
+in vec2 TexCoord;
+in vec4 Color;
+uniform sampler2D uSprite;
+
+void main() {
+    FragColor = texture(uSprite, TexCoord) * Color;
+}
+)"";
+    }  // namespace BatchShader
+
+    /// Fragment stage for SDF text, used with BatchShader::Vertex. The atlas stores distance with
+    /// 0.5 on the glyph edge; fwidth keeps the antialiased band about one screen pixel wide at
+    /// any scale.
+    namespace SdfTextShader {
+        static cstr Fragment = R""(#version 460 core
+out vec4 FragColor;
+in vec2 TexCoord;
+in vec4 Color;
+uniform sampler2D uSprite;
+
+void main() {
+    float distance = texture(uSprite, TexCoord).r;
+    float width = max(fwidth(distance) * 0.5, 1e-4);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    FragColor = vec4(Color.rgb, Color.a * alpha);
+}
+)"";
+    }  // namespace SdfTextShader
 }  // namespace Xen::Shaders
\ No newline at end of file
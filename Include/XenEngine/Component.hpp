@@ -12,10 +12,17 @@
 #include "VertexArray.hpp"
 #include "Camera.hpp"
 #include "ContentManager.hpp"
+#include "Font.hpp"
+#include "ParticleSystem.hpp"
 #include "Primitives.hpp"
+#include "SpriteBatch.hpp"
+#include "TextureAtlas.hpp"
 
 #include <glm/glm.hpp>
 #include <Types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <type_traits>
 #include <glad/glad.h>
 #include <glm/ext/matrix_transform.hpp>
@@ -128,16 +135,22 @@ namespace Xen {
         }
     };
 
+    /// @brief Draws a single sprite, either a whole texture asset or a named region of an atlas
+    /// asset. Sprites drawn from the same atlas share its page textures.
     class SpriteRenderer final : public IComponent {
     public:
         SpriteRenderer() : mTexture(0) {};
         explicit SpriteRenderer(const Shared<Asset>& spriteAsset) : mTexture(0) {
             Initialize(spriteAsset);
         }
+        SpriteRenderer(const Shared<Asset>& atlasAsset, const str& region) : mTexture(0) {
+            Initialize(atlasAsset, region);
+        }
 
         ~SpriteRenderer() override {
             mShader.reset();
             mVAO.reset();
+            mAtlas.reset();
             Texture::Delete(mTexture);
         }
 
@@ -149,6 +162,13 @@ namespace Xen {
         Unique<VertexArray> mVAO;
         Unique<Shader> mShader;
         u32 mTexture;
+        Shared<TextureAtlas> mAtlas;
+        str mRegionName;
+        // Copied out of the atlas, and again by Draw() after the atlas is reloaded
+        mutable AtlasRegion mRegion {0,
+                                     glm::vec4(0.f, 0.f, 1.f, 1.f),
+                                     glm::vec4(0.f, 0.f, 1.f, 1.f)};
+        mutable u32 mAtlasVersion = 0;
 
         void Initialize(const Shared<Asset>& spriteAsset) {
             if (!spriteAsset->Metadata.contains("width") ||
@@ -158,13 +178,29 @@ namespace Xen {
                 return;
             }
 
-            const auto data   = spriteAsset->Data;
-            const auto width  = ToInt(spriteAsset->Metadata.at("width"));
-            const auto height = ToInt(spriteAsset->Metadata.at("height"));
-            mTexture          = Texture::LoadFromMemory(data, width, height);
-            mShader           = std::make_unique<Shader>(Shaders::SpriteShader::Vertex,
+            mTexture = Texture::LoadFromAsset(*spriteAsset);
+            CreateQuad();
+        }
+
+        void Initialize(const Shared<Asset>& atlasAsset, const str& region) {
+            mAtlas             = TextureAtlas::Get(atlasAsset);
+            const auto* found  = mAtlas->GetRegion(region);
+            if (!found) {
+                std::cerr << "ERROR: Atlas '" << atlasAsset->Name << "' has no region named '"
+                          << region << "'." << std::endl;
+                mAtlas.reset();
+                return;
+            }
+            mRegion       = *found;
+            mRegionName   = region;
+            mAtlasVersion = mAtlas->GetVersion();
+            CreateQuad();
+        }
+
+        void CreateQuad() {
+            mShader = std::make_unique<Shader>(Shaders::SpriteShader::Vertex,
                                                Shaders::SpriteShader::Fragment);
-            mVAO              = std::make_unique<VertexArray>();
+            mVAO    = std::make_unique<VertexArray>();
             std::vector<VertexAttribute> attributes = {
               {"aVertex", 0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(f32), (void*)nullptr},
             };
@@ -174,6 +210,381 @@ namespace Xen {
         }
     };
 
+    /// @brief Renders a grid of tiles from a single tileset texture. Tiles are grouped into
+    /// square chunks whose vertex data is built once and only rebuilt when one of their tiles
+    /// changes, so a large map costs one draw call per visible chunk instead of one per tile.
+    ///
+    /// Tile index 0 is empty; index N maps to the (N-1)th cell of the tileset, read left to right,
+    /// top to bottom. Map row 0 is the top row.
+    class Tilemap final : public IComponent {
+    public:
+        static constexpr u32 kChunkSize = 64;
+
+        Tilemap() = default;
+        Tilemap(const Shared<Asset>& mapAsset, const Shared<Asset>& tilesetAsset) {
+            Initialize(mapAsset, tilesetAsset);
+        }
+
+        ~Tilemap() override {
+            mShader.reset();
+            mChunks.clear();
+            Texture::Delete(mTexture);
+        }
+
+        [[nodiscard]] u32 GetWidth() const {
+            return mWidth;
+        }
+
+        [[nodiscard]] u32 GetHeight() const {
+            return mHeight;
+        }
+
+        [[nodiscard]] u16 GetTile(u32 x, u32 y) const {
+            if (x >= mWidth || y >= mHeight) { return 0; }
+            return mTiles[y * mWidth + x];
+        }
+
+        void SetTile(u32 x, u32 y, u16 tile) {
+            if (x >= mWidth || y >= mHeight) { return; }
+            auto& current = mTiles[y * mWidth + x];
+            if (current == tile) { return; }
+            current = tile;
+            mChunks[(y / kChunkSize) * mChunksX + (x / kChunkSize)].Dirty = true;
+        }
+
+        void Draw(const Transform* transform, const OrthoCamera* camera);
+
+        static void RegisterType(sol::state& state) {
+            state.new_usertype<Tilemap>("Tilemap",
+                                        "GetWidth",
+                                        &Tilemap::GetWidth,
+                                        "GetHeight",
+                                        &Tilemap::GetHeight,
+                                        "GetTile",
+                                        &Tilemap::GetTile,
+                                        "SetTile",
+                                        &Tilemap::SetTile);
+        }
+
+    private:
+        struct Chunk {
+            Unique<VertexArray> VAO;
+            i32 VertexCount = 0;
+            bool Dirty      = true;
+        };
+
+        Unique<Shader> mShader;
+        std::vector<Chunk> mChunks;
+        std::vector<u16> mTiles;
+        u32 mTexture = 0;
+        u32 mWidth   = 0;
+        u32 mHeight  = 0;
+        u32 mColumns = 1;
+        u32 mRows    = 1;
+        u32 mChunksX = 0;
+        u32 mChunksY = 0;
+
+        void Initialize(const Shared<Asset>& mapAsset, const Shared<Asset>& tilesetAsset) {
+            const auto& meta = mapAsset->Metadata;
+            if (!meta.contains("width") || !meta.contains("height") || !meta.contains("columns") ||
+                !meta.contains("rows")) {
+                std::cerr << "ERROR: Invalid tilemap metadata (missing "
+                             "'width'/'height'/'columns'/'rows' properties)."
+                          << std::endl;
+                return;
+            }
+            if (!tilesetAsset->Metadata.contains("width") ||
+                !tilesetAsset->Metadata.contains("height")) {
+                std::cerr << "ERROR: Invalid tileset metadata (missing 'width'/'height')."
+                          << std::endl;
+                return;
+            }
+
+            mWidth   = ToUInt(meta.at("width"));
+            mHeight  = ToUInt(meta.at("height"));
+            mColumns = std::max(1u, ToUInt(meta.at("columns")));
+            mRows    = std::max(1u, ToUInt(meta.at("rows")));
+
+            const auto tileCount = CAST<size_t>(mWidth) * mHeight;
+            const auto mapData   = mapAsset->GetData();
+            if (mapData.size() < tileCount * sizeof(u16)) {
+                std::cerr << "ERROR: Tilemap data is smaller than 'width' * 'height'." << std::endl;
+                mWidth = mHeight = 0;
+                return;
+            }
+            mTiles.resize(tileCount);
+            memcpy(mTiles.data(), mapData.data(), tileCount * sizeof(u16));
+
+            mChunksX = (mWidth + kChunkSize - 1) / kChunkSize;
+            mChunksY = (mHeight + kChunkSize - 1) / kChunkSize;
+            mChunks.resize(CAST<size_t>(mChunksX) * mChunksY);
+
+            mTexture = Texture::LoadFromAsset(*tilesetAsset);
+            mShader  = std::make_unique<Shader>(Shaders::SpriteShader::Vertex,
+                                               Shaders::SpriteShader::Fragment);
+        }
+
+        /// @brief Regenerates the vertex data for a single chunk. Each non-empty tile emits two
+        /// triangles in map-local space, one unit per tile, with the map's top-left corner at
+        /// (0, height).
+        void RebuildChunk(u32 cx, u32 cy) {
+            auto& chunk     = mChunks[cy * mChunksX + cx];
+            const u32 x0    = cx * kChunkSize;
+            const u32 y0    = cy * kChunkSize;
+            const u32 x1    = std::min(x0 + kChunkSize, mWidth);
+            const u32 y1    = std::min(y0 + kChunkSize, mHeight);
+            const f32 cellU = 1.f / CAST<f32>(mColumns);
+            const f32 cellV = 1.f / CAST<f32>(mRows);
+
+            std::vector<f32> vertices;
+            vertices.reserve(CAST<size_t>(x1 - x0) * (y1 - y0) * 6 * 4);
+            for (u32 y = y0; y < y1; ++y) {
+                for (u32 x = x0; x < x1; ++x) {
+                    const u16 tile = mTiles[y * mWidth + x];
+                    if (tile == 0) { continue; }
+
+                    const u32 cell = tile - 1u;
+                    const f32 u0   = CAST<f32>(cell % mColumns) * cellU;
+                    const f32 u1   = u0 + cellU;
+                    // Textures are flipped on load, so the tileset's top row is at v = 1
+                    const f32 v1 = 1.f - CAST<f32>((cell / mColumns) % mRows) * cellV;
+                    const f32 v0 = v1 - cellV;
+
+                    const f32 px0 = CAST<f32>(x);
+                    const f32 px1 = px0 + 1.f;
+                    const f32 py1 = CAST<f32>(mHeight - y);
+                    const f32 py0 = py1 - 1.f;
+
+                    const f32 quad[] = {
+                      px0, py1, u0, v1, px0, py0, u0, v0, px1, py1, u1, v1,
+                      px1, py1, u1, v1, px0, py0, u0, v0, px1, py0, u1, v0,
+                    };
+                    vertices.insert(vertices.end(), std::begin(quad), std::end(quad));
+                }
+            }
+
+            if (!chunk.VAO) {
+                chunk.VAO = std::make_unique<VertexArray>();
+                std::vector<VertexAttribute> attributes = {
+                  {"aVertex", 0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(f32), (void*)nullptr},
+                };
+                chunk.VAO->Bind();
+                chunk.VAO->CreateVertexBuffer<f32>(vertices, attributes);
+                VertexArray::Unbind();
+            } else {
+                chunk.VAO->UpdateVertexBuffer<f32>(0, vertices);
+            }
+
+            chunk.VertexCount = CAST<i32>(vertices.size() / 4);
+            chunk.Dirty       = false;
+        }
+    };
+
+    /// @brief Emits particles from its GameObject's position. Particles live in world space in a
+    /// structure-of-arrays ParticlePool and are drawn as instances through a SpriteBatch, so
+    /// spawning them never touches the Scene.
+    class ParticleEmitter final : public IComponent {
+    public:
+        ParticleSettings Settings;
+        bool Emitting = true;
+
+        ParticleEmitter() : ParticleEmitter(ParticleSettings {}) {}
+        explicit ParticleEmitter(const ParticleSettings& settings,
+                                 const Shared<Asset>& textureAsset = nullptr)
+            : Settings(settings), mPool(settings.MaxParticles) {
+            Initialize(textureAsset);
+        }
+
+        ~ParticleEmitter() override {
+            mBatch.reset();
+            Texture::Delete(mTexture);
+        }
+
+        void Update(const Transform* transform, f32 dT) {
+            if (transform) {
+                mEmitX = transform->X;
+                mEmitY = transform->Y;
+            }
+            if (mPool.GetCapacity() != Settings.MaxParticles) {
+                mPool.Resize(Settings.MaxParticles);
+            }
+
+            mPool.Simulate(dT, Settings);
+            if (!Emitting) { return; }
+
+            mEmitAccumulator += Settings.Rate * dT;
+            const auto count = CAST<u32>(mEmitAccumulator);
+            mEmitAccumulator -= CAST<f32>(count);
+            mPool.Emit(count, mEmitX, mEmitY, Settings);
+        }
+
+        /// @brief Immediately spawns `count` particles at the emitter's last known position.
+        void Burst(u32 count) {
+            mPool.Emit(count, mEmitX, mEmitY, Settings);
+        }
+
+        [[nodiscard]] u32 GetCount() const {
+            return mPool.GetCount();
+        }
+
+        void Draw(const OrthoCamera* camera);
+
+        static void RegisterType(sol::state& state) {
+            state.new_usertype<ParticleEmitter>("ParticleEmitter",
+                                                "Emitting",
+                                                &ParticleEmitter::Emitting,
+                                                "Burst",
+                                                &ParticleEmitter::Burst,
+                                                "GetCount",
+                                                &ParticleEmitter::GetCount);
+        }
+
+    private:
+        ParticlePool mPool;
+        Unique<SpriteBatch> mBatch;
+        u32 mTexture         = 0;
+        f32 mEmitAccumulator = 0.f;
+        f32 mEmitX           = 0.f;
+        f32 mEmitY           = 0.f;
+
+        void Initialize(const Shared<Asset>& textureAsset) {
+            mBatch = std::make_unique<SpriteBatch>();
+            if (textureAsset && textureAsset->Metadata.contains("width") &&
+                textureAsset->Metadata.contains("height")) {
+                mTexture = Texture::LoadFromAsset(*textureAsset);
+            } else {
+                // Untextured particles sample a single white texel so the tint is the color
+                mTexture = Texture::LoadFromMemory({0xFF, 0xFF, 0xFF, 0xFF}, 1, 1);
+            }
+        }
+    };
+
+    /// @brief Draws a string with an SDF font. Glyph quads are laid out once into a cached
+    /// instance list and only rebuilt when the text, size or color changes, then drawn in a single
+    /// instanced call through a SpriteBatch.
+    ///
+    /// Size is the font's em height in world units. The first line's baseline sits at the
+    /// GameObject's origin and lines advance downward.
+    class TextRenderer final : public IComponent {
+    public:
+        TextRenderer() = default;
+        explicit TextRenderer(const Shared<Asset>& fontAsset, str text = {}, f32 size = 1.f)
+            : mText(std::move(text)), mSize(size) {
+            Initialize(fontAsset);
+        }
+
+        ~TextRenderer() override {
+            mBatch.reset();
+            mFont.reset();
+        }
+
+        void SetText(const str& text) {
+            if (text == mText) { return; }
+            mText  = text;
+            mDirty = true;
+        }
+
+        [[nodiscard]] const str& GetText() const {
+            return mText;
+        }
+
+        void SetSize(f32 size) {
+            mSize  = size;
+            mDirty = true;
+        }
+
+        [[nodiscard]] f32 GetSize() const {
+            return mSize;
+        }
+
+        void SetColor(const glm::vec4& color) {
+            mColor = color;
+            mDirty = true;
+        }
+
+        [[nodiscard]] const glm::vec4& GetColor() const {
+            return mColor;
+        }
+
+        [[nodiscard]] const Font* GetFont() const {
+            return mFont.get();
+        }
+
+        void Draw(const Transform* transform, const OrthoCamera* camera);
+
+        static void RegisterType(sol::state& state) {
+            state.new_usertype<TextRenderer>(
+              "TextRenderer",
+              "Text",
+              sol::property(&TextRenderer::GetText, &TextRenderer::SetText),
+              "Size",
+              sol::property(&TextRenderer::GetSize, &TextRenderer::SetSize),
+              "SetColor",
+              [](TextRenderer& self, f32 r, f32 g, f32 b, f32 a) {
+                  self.SetColor(glm::vec4(r, g, b, a));
+              });
+        }
+
+    private:
+        static constexpr u32 kBatchCapacity = 1024;
+
+        Unique<Font> mFont;
+        Unique<SpriteBatch> mBatch;
+        std::vector<SpriteInstance> mLayout;
+        str mText;
+        f32 mSize        = 1.f;
+        glm::vec4 mColor = glm::vec4(1.f);
+        bool mDirty      = true;
+        u32 mFontVersion = 0;  // Of mFont when mLayout was built
+
+        void Initialize(const Shared<Asset>& fontAsset) {
+            mFont  = std::make_unique<Font>(fontAsset);
+            mBatch = std::make_unique<SpriteBatch>(kBatchCapacity,
+                                                   Shaders::BatchShader::Vertex,
+                                                   Shaders::SdfTextShader::Fragment);
+        }
+
+        void Layout() {
+            mLayout.clear();
+            mDirty = false;
+            if (!mFont) { return; }
+            mFontVersion = mFont->GetVersion();
+
+            const f32 scale = mSize / mFont->GetSize();
+            f32 penX = 0.f, penY = 0.f;
+            for (size_t offset = 0; offset < mText.size();) {
+                const u32 codepoint = Font::NextCodepoint(mText, offset);
+                if (codepoint == '\n') {
+                    penX = 0.f;
+                    penY -= mFont->GetLineHeight() * scale;
+                    continue;
+                }
+
+                const auto* glyph = mFont->GetGlyph(codepoint);
+                if (!glyph) { glyph = mFont->GetGlyph('?'); }
+                if (!glyph) { continue; }
+
+                if (glyph->Width > 0.f && glyph->Height > 0.f) {
+                    const f32 halfWidth  = glyph->Width * 0.5f * scale;
+                    const f32 halfHeight = glyph->Height * 0.5f * scale;
+                    mLayout.push_back({penX + glyph->OffsetX * scale + halfWidth,
+                                       penY + glyph->OffsetY * scale - halfHeight,
+                                       halfWidth,
+                                       halfHeight,
+                                       glyph->U0,
+                                       glyph->V0,
+                                       glyph->U1,
+                                       glyph->V1,
+                                       mColor.r,
+                                       mColor.g,
+                                       mColor.b,
+                                       mColor.a});
+                }
+                penX += glyph->Advance * scale;
+            }
+        }
+    };
+
     class Rigidbody final : public IComponent {
     public:
         Rigidbody() = default;
@@ -236,7 +647,21 @@ namespace Xen {
             } else if (name == "Behavior") {
                 return std::make_unique<Behavior>();
             } else if (name == "Sprite Renderer") {
-                return std::make_unique<SpriteRenderer>(std::forward<Args>(args)...);
+                if constexpr (std::is_constructible_v<SpriteRenderer, Args...>) {
+                    return std::make_unique<SpriteRenderer>(std::forward<Args>(args)...);
+                }
+            } else if (name == "Tilemap") {
+                if constexpr (std::is_constructible_v<Tilemap, Args...>) {
+                    return std::make_unique<Tilemap>(std::forward<Args>(args)...);
+                }
+            } else if (name == "Particle Emitter") {
+                if constexpr (std::is_constructible_v<ParticleEmitter, Args...>) {
+                    return std::make_unique<ParticleEmitter>(std::forward<Args>(args)...);
+                }
+            } else if (name == "Text Renderer") {
+                if constexpr (std::is_constructible_v<TextRenderer, Args...>) {
+                    return std::make_unique<TextRenderer>(std::forward<Args>(args)...);
+                }
             } else if (name == "Rigidbody") {
                 return std::make_unique<Rigidbody>();
             } else if (name == "Box Collider") {
@@ -256,16 +681,111 @@ namespace Xen {
     };
 
     inline void SpriteRenderer::Draw(const Transform* transform, const OrthoCamera* camera) const {
+        if (!mShader) { return; }
         mShader->Bind();
         mShader->SetInt("uSprite", 0);
         const auto model = transform->GetMatrix();
         const auto mvp   = camera->GetViewProjection() * model;
         mShader->SetMat4("uMVP", mvp);
-        Texture::Bind(mTexture, 0);
+        if (mAtlas && mAtlas->GetVersion() != mAtlasVersion) {
+            mAtlasVersion = mAtlas->GetVersion();
+            if (const auto* found = mAtlas->GetRegion(mRegionName)) {
+                mRegion = *found;
+            } else {
+                std::cerr << "ERROR: Reloaded atlas has no region named '" << mRegionName
+                          << "'." << std::endl;
+            }
+        }
+        mShader->SetVec4("uQuad", mRegion.Quad);
+        mShader->SetVec4("uUV", mRegion.UV);
+        Texture::Bind(mAtlas ? mAtlas->GetTexture(mRegion.Page) : mTexture, 0);
         mVAO->Bind();
         mVAO->Draw(GL_TRIANGLE_STRIP);
         VertexArray::Unbind();
         Texture::Unbind();
         Shader::Unbind();
     }
+
+    inline void Tilemap::Draw(const Transform* transform, const OrthoCamera* camera) {
+        if (!mShader || mChunks.empty()) { return; }
+
+        const auto mvp = camera->GetViewProjection() * transform->GetMatrix();
+
+        // Project the NDC corners back into map space to find which chunks are on screen.
+        const auto inverse = glm::inverse(mvp);
+        f32 minX = std::numeric_limits<f32>::max(), minY = std::numeric_limits<f32>::max();
+        f32 maxX = std::numeric_limits<f32>::lowest(), maxY = std::numeric_limits<f32>::lowest();
+        for (const auto& corner : {glm::vec4(-1, -1, 0, 1),
+                                   glm::vec4(1, -1, 0, 1),
+                                   glm::vec4(-1, 1, 0, 1),
+                                   glm::vec4(1, 1, 0, 1)}) {
+            const auto local = inverse * corner;
+            minX             = std::min(minX, local.x / local.w);
+            maxX             = std::max(maxX, local.x / local.w);
+            minY             = std::min(minY, local.y / local.w);
+            maxY             = std::max(maxY, local.y / local.w);
+        }
+
+        // Convert the visible map-space rect to tile rows/columns (row 0 is at the top).
+        const auto clampTile = [](f32 v, u32 limit) {
+            return CAST<u32>(std::clamp(v, 0.f, CAST<f32>(limit)));
+        };
+        const u32 tileX0 = clampTile(std::floor(minX), mWidth);
+        const u32 tileX1 = clampTile(std::ceil(maxX), mWidth);
+        const u32 tileY0 = clampTile(std::floor(CAST<f32>(mHeight) - maxY), mHeight);
+        const u32 tileY1 = clampTile(std::ceil(CAST<f32>(mHeight) - minY), mHeight);
+        if (tileX0 >= tileX1 || tileY0 >= tileY1) { return; }
+
+        const u32 chunkX0 = tileX0 / kChunkSize;
+        const u32 chunkX1 = (tileX1 + kChunkSize - 1) / kChunkSize;
+        const u32 chunkY0 = tileY0 / kChunkSize;
+        const u32 chunkY1 = (tileY1 + kChunkSize - 1) / kChunkSize;
+
+        mShader->Bind();
+        mShader->SetInt("uSprite", 0);
+        mShader->SetMat4("uMVP", mvp);
+        Texture::Bind(mTexture, 0);
+        for (u32 cy = chunkY0; cy < chunkY1; ++cy) {
+            for (u32 cx = chunkX0; cx < chunkX1; ++cx) {
+                auto& chunk = mChunks[cy * mChunksX + cx];
+                if (chunk.Dirty) { RebuildChunk(cx, cy); }
+                if (chunk.VertexCount == 0) { continue; }
+                chunk.VAO->Bind();
+                chunk.VAO->Draw(GL_TRIANGLES, chunk.VertexCount);
+            }
+        }
+        VertexArray::Unbind();
+        Texture::Unbind();
+        Shader::Unbind();
+    }
+
+    inline void ParticleEmitter::Draw(const OrthoCamera* camera) {
+        const u32 count = mPool.GetCount();
+        if (count == 0 || !mBatch) { return; }
+
+        // Particles write their instance data straight into the batch's staging storage
+        const u32 capacity = mBatch->GetCapacity();
+        mBatch->Begin(camera->GetViewProjection(), mTexture);
+        for (u32 first = 0; first < count; first += capacity) {
+            const u32 batchCount = std::min(capacity, count - first);
+            mPool.WriteInstances(mBatch->Reserve(batchCount), first, batchCount, Settings.Size);
+        }
+        mBatch->End();
+    }
+
+    inline void TextRenderer::Draw(const Transform* transform, const OrthoCamera* camera) {
+        if (!mBatch) { return; }
+        if (mDirty || mFont->GetVersion() != mFontVersion) { Layout(); }
+        if (mLayout.empty()) { return; }
+
+        // Glyph quads are laid out in local space, so the transform goes into the batch's VP
+        const auto mvp   = camera->GetViewProjection() * transform->GetMatrix();
+        const auto total = CAST<u32>(mLayout.size());
+        mBatch->Begin(mvp, mFont->GetTexture());
+        for (u32 first = 0; first < total; first += kBatchCapacity) {
+            const u32 count = std::min(kBatchCapacity, total - first);
+            std::copy_n(mLayout.data() + first, count, mBatch->Reserve(count));
+        }
+        mBatch->End();
+    }
 }  // namespace Xen
\ No newline at end of file
@@ -4,8 +4,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
 #include <optional>
+#include <queue>
+#include <shared_mutex>
+#include <span>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -13,34 +23,311 @@
 
 #define MAX_ASSET_SIZE 1e10
 
+class DictionarySet;
+class ReloadChannel;
+
 namespace Xen {
+    /// @brief A loaded asset. The payload is either a buffer the asset owns (decompressed or read
+    /// payloads) or a region of a memory-mapped archive that the asset keeps alive, so payloads
+    /// are never copied after they reach their final location.
+    ///
+    /// Assets of GPU-resident types (textures, atlases, fonts) drop their owned buffer after
+    /// OnUploaded() reports that the GPU has a copy. GetData() transparently reloads it from the
+    /// pak if the CPU needs it again. Assets with identical content (same "hash" metadata) share
+    /// one buffer; it is freed once every asset sharing it has released it.
     class Asset {
     public:
+        using Reloader = std::function<std::optional<std::vector<u8>>()>;
+
         str Name;
-        std::vector<u8> Data;
         std::unordered_map<str, str> Metadata;
 
-        Asset() = default;
-        Asset(str name, const std::vector<u8>& data, const std::unordered_map<str, str>& metadata)
-            : Name(std::move(name)), Data(data), Metadata(metadata) {}
+        Asset(str name, std::vector<u8> data, std::unordered_map<str, str> metadata)
+            : Name(std::move(name)), Metadata(std::move(metadata)),
+              mStorage(std::make_shared<const std::vector<u8>>(std::move(data))) {
+            mData = *mStorage;
+        }
+
+        /// @brief Views memory owned by `owner`, which is kept alive as long as the asset.
+        Asset(str name,
+              std::span<const u8> data,
+              Shared<const void> owner,
+              std::unordered_map<str, str> metadata)
+            : Name(std::move(name)), Metadata(std::move(metadata)), mData(data),
+              mOwner(std::move(owner)) {}
+
+        // Use Share() instead, which also carries the reloader
+        Asset(const Asset&)            = delete;
+        Asset& operator=(const Asset&) = delete;
+
+        /// @brief The payload, reloaded first if it was released. The span stays valid until the
+        /// asset is uploaded again and ContentManager::Update() releases it.
+        [[nodiscard]] std::span<const u8> GetData() const;
+
+        /// @brief Bytes of payload currently held in memory by this asset.
+        [[nodiscard]] size_t GetResidentSize() const;
+
+        /// @brief Tells the asset its payload now lives on the GPU. The CPU copy is released at
+        /// the next ContentManager::Update(), so everything created in the same frame can still
+        /// read it. Views into an archive mapping are kept; the OS can drop clean pages itself.
+        void OnUploaded() const;
+
+    private:
+        friend class ContentManager;
+
+        // Mutable so a released payload can be reloaded behind a const asset
+        mutable std::mutex mMutex;
+        mutable std::span<const u8> mData;
+        mutable Shared<const std::vector<u8>> mStorage;
+        mutable bool mUploaded = false;
+        mutable bool mReleased = false;
+        bool mShared           = false;  // Created by Share() rather than loaded
+        Shared<const void> mOwner;
+        Reloader mReload;  // Set by ContentManager for GPU-resident types
+
+        /// @brief Drops the payload if it was uploaded and can be reloaded.
+        void ReleaseIfUploaded() const;
+        /// @brief A new asset viewing this one's payload, or nullptr if it has been released.
+        Shared<Asset> Share(str name, std::unordered_map<str, str> metadata) const;
+    };
+
+    using AssetResult    = std::optional<Shared<Asset>>;
+    using AssetCallback  = std::function<void(const AssetResult&)>;
+    using ReloadListener = std::function<void(const Shared<Asset>&)>;
+
+    /// @brief Order in which queued asynchronous loads are served. Requests of equal priority are
+    /// served in submission order.
+    enum class LoadPriority : u8 {
+        Low,
+        Normal,
+        High,
+        Critical,
+    };
+
+    struct LoadRequest;
+    struct LoadTicket;
+
+    struct ContentStats {
+        u64 Hits           = 0;
+        u64 Misses         = 0;
+        u64 Evictions      = 0;
+        u64 LoadedBytes    = 0;  // Payload bytes read from disk or archives
+        u64 SharedBytes    = 0;  // Payload bytes reused from a loaded asset with the same hash
+        u64 ResidentBytes  = 0;
+        u64 Budget         = 0;
+        u32 ResidentAssets = 0;
+    };
+
+    /// @brief One caller's interest in an asynchronous load. Several handles may share a single
+    /// in-flight load of the same asset.
+    class AssetHandle {
+    public:
+        AssetHandle() = default;
+
+        [[nodiscard]] bool IsValid() const;
+        /// @brief Whether the load has finished (or was cancelled), i.e. Get() won't block.
+        [[nodiscard]] bool IsReady() const;
+        /// @brief Blocks until the load finishes. Empty if it failed or was cancelled.
+        [[nodiscard]] AssetResult Get() const;
+
+        /// @brief Withdraws this handle's interest and drops its callback. The load itself is
+        /// abandoned once no handle wants it, unless a worker has already started it.
+        void Cancel() const;
+
+    private:
+        friend class ContentManager;
+
+        Shared<LoadTicket> mTicket;
+
+        explicit AssetHandle(Shared<LoadTicket> ticket) : mTicket(std::move(ticket)) {}
     };
 
-    // TODO: This class currently implements a 'lazy' method of asset loading.
-    // Ideally, in a real game you would want to load everything you need for the scene in advance,
-    // but for small projects this will work for now.
+    /// @brief Loads assets from mounted archives and loose content files. Loads can be
+    /// synchronous (LoadAsset) or queued for a worker pool (LoadAssetAsync); either way there is
+    /// at most one load in flight per asset, and finished assets are cached by name.
+    ///
+    /// The cache holds a byte budget. When it is exceeded, the least recently requested assets
+    /// that nothing else references and that aren't pinned are dropped; assets still in use are
+    /// never evicted, so the budget can be overshot while they are alive.
     class ContentManager {
     public:
-        explicit ContentManager(const std::filesystem::path& contentRoot) {
-            this->mContentRoot = contentRoot;
-        }
+        static constexpr u64 kDefaultBudget = 256ull << 20;
+
+        /// @brief Mounts every .xpak archive directly under `contentRoot` (in filename order).
+        /// Assets missing from the archives fall back to loose .xpkf/.xmdf files, decoded
+        /// against the .xdict dictionaries there. `workerCount`
+        /// sizes the asynchronous loading pool, which is started on first use; 0 picks a count
+        /// from the hardware.
+        explicit ContentManager(const std::filesystem::path& contentRoot, u32 workerCount = 0);
+        ~ContentManager();
+
+        /// @brief The process-wide manager for `contentRoot`, created on first use. Scenes share
+        /// it, so assets common to several levels are loaded once and survive transitions.
+        static Shared<ContentManager> GetShared(const std::filesystem::path& contentRoot);
+
+        /// @brief Loads an asset on the calling thread. If the asset is already queued, the
+        /// request is taken over rather than loaded twice; if a worker is loading it, this waits.
+        AssetResult LoadAsset(const str& name);
+
+        /// @brief Queues an asset for the worker pool. `callback` runs on the thread that calls
+        /// Update(), after the load finishes, even when the asset was already cached. Requesting
+        /// an asset that is already queued shares the pending load and raises its priority if
+        /// `priority` is higher.
+        AssetHandle LoadAssetAsync(const str& name,
+                                   LoadPriority priority  = LoadPriority::Normal,
+                                   AssetCallback callback = {});
+
+        /// @brief Moves a queued load. Has no effect once the load has started.
+        void SetPriority(const AssetHandle& handle, LoadPriority priority);
+
+        /// @brief Delivers completion callbacks for finished asynchronous loads. Call once per
+        /// frame from the main thread.
+        void Update();
+
+        /// @brief Sets the cache budget in bytes and evicts down to it.
+        void SetBudget(u64 bytes);
+
+        /// @brief Keeps an asset cached while unreferenced, regardless of the budget. Pins are
+        /// counted and may be placed before the asset is loaded.
+        void Pin(const str& name);
+        void Unpin(const str& name);
+
+        /// @brief Groups assets (typically by scene) so they can be released together.
+        void Tag(const str& name, const str& tag);
+        /// @brief Removes `tag` from every asset. The unreferenced, unpinned ones left without
+        /// any tag are evicted at the next Update() unless they are tagged again first, so a
+        /// scene transition made within one frame only drops what the next scene doesn't use.
+        void ReleaseTag(const str& tag);
+
+        [[nodiscard]] ContentStats GetStats();
+
+        /// @brief Maps an archive for lookups and loads its compression dictionaries. Later
+        /// mounts take precedence over earlier ones, so a patch archive can override individual
+        /// assets.
+        bool Mount(const std::filesystem::path& archive);
+
+        /// @brief Subscribes to `XPak watch` on `port` (0 uses ReloadChannel::kDefaultPort).
+        /// Assets it rebuilds are reloaded in place at the next Update(). False if the socket
+        /// couldn't be opened.
+        bool EnableHotReload(u16 port = 0);
 
-        std::optional<Shared<Asset>> LoadAsset(const str& name);
+        /// @brief Replaces a cached asset's payload and metadata with its rebuilt loose files
+        /// in `directory` (empty for the content root), then runs the reload listeners.
+        /// Everything holding the asset sees the new version; spans from GetData() taken before
+        /// are invalidated. From then on the asset is read from those loose files, since the
+        /// mounted archives predate it. An asset that isn't cached is read from disk and handed
+        /// to the listeners alone. Call from the thread that calls Update(). False if nothing
+        /// was reloaded or the asset couldn't be read.
+        bool Reload(const str& name, const std::filesystem::path& directory = {});
+
+        /// @brief `listener` runs after each asset is reloaded, on the thread that calls
+        /// Update(), so copies made from the asset (such as GPU textures) can be refreshed. It
+        /// also runs for rebuilt assets that are no longer cached, with a fresh Asset read from
+        /// disk that nothing else holds.
+        void AddReloadListener(ReloadListener listener);
 
     private:
-        std::unordered_map<str, Shared<Asset>> mLoadedAssets;
+        struct MountedArchive;
+
+        /// @brief Queue entry. Re-prioritizing pushes a new entry and bumps the request's epoch,
+        /// so stale entries are skipped when popped.
+        struct QueuedLoad {
+            LoadPriority Priority;
+            u64 Sequence;
+            u64 Epoch;
+            Shared<LoadRequest> Request;
+
+            bool operator<(const QueuedLoad& other) const {
+                if (Priority != other.Priority) { return Priority < other.Priority; }
+                return Sequence > other.Sequence;
+            }
+        };
+
+        struct CacheEntry {
+            Shared<Asset> Loaded;
+            u64 Size;
+            std::list<str>::iterator LruPosition;
+        };
+
+        /// @brief Residency hints, kept independently of the cache so they can precede a load.
+        struct AssetPolicy {
+            u32 Pins = 0;
+            std::vector<str> Tags;
+        };
+
+        std::unordered_map<str, CacheEntry> mLoadedAssets;
+        std::list<str> mLru;  // Most recently requested first
+        std::unordered_map<str, AssetPolicy> mPolicies;
+        std::vector<str> mUntagged;  // Released by ReleaseTag, evicted at the next Update()
+        ContentStats mStats;
         std::filesystem::path mContentRoot;
+        std::vector<Unique<MountedArchive>> mArchives;
+        // Assets reloaded since the archives were mounted -> the directory holding their rebuilt
+        // loose files, which are read instead. Guarded by mArchiveMutex, as are the archives
+        std::unordered_map<str, std::filesystem::path> mStaleEntries;
+        mutable std::shared_mutex mArchiveMutex;
+        // Content hash -> a loaded asset with that content. Taken after mMutex when both are held
+        mutable std::mutex mContentMutex;
+        mutable std::unordered_map<str, Weak<Asset>> mContentIndex;
+        Shared<DictionarySet> mDictionaries;  // Shared with reloaders, which may outlive us
+
+        // Guards the cache, the queue, in-flight requests and finished callbacks
+        std::mutex mMutex;
+        std::condition_variable mQueueCondition;
+        std::priority_queue<QueuedLoad> mQueue;
+        std::unordered_map<str, Shared<LoadRequest>> mInFlight;
+        std::vector<Shared<LoadRequest>> mFinished;
+        std::vector<std::thread> mWorkers;
+        u32 mWorkerCount;
+        u64 mSequence  = 0;
+        bool mStopping = false;
+
+        Unique<ReloadChannel> mReloadChannel;
+        std::thread mReloadThread;
+        // Received, not yet reloaded: name and the watcher's output directory. Guarded by mMutex
+        std::vector<std::pair<str, std::filesystem::path>> mPendingReloads;
+        std::vector<ReloadListener> mReloadListeners;
+
+        void StartWorkers();
+        void WorkerLoop();
+        void Enqueue(const Shared<LoadRequest>& request);
+        /// @brief Loads a claimed request, caches the result and resolves its future.
+        void Execute(const Shared<LoadRequest>& request);
+
+        // Cache helpers, called with mMutex held
+        Shared<Asset> FindCached(const str& name);
+        void Cache(const str& name, const Shared<Asset>& asset);
+        bool IsEvictable(const str& name, const CacheEntry& entry) const;
+        void Evict(const str& name);
+        void Trim();
+        /// @brief Releases uploaded payloads and re-reads every entry's resident size, which
+        /// changes when a payload is released or reloaded.
+        void ReleaseUploaded();
+        void EvictUntagged();
+
+        /// @brief Receives reload notifications until the manager stops, subscribing again
+        /// every so often so the watcher knows this game is still running.
+        void ListenForReloads(u16 watcherPort);
+        /// @brief Loads the .xdict files under `directory`, including ones trained since the
+        /// last call.
+        void LoadDictionaries(const std::filesystem::path& directory);
+
+        /// @brief Threads one payload may decode on. Loads run on every worker at once, so each
+        /// gets an equal share of the cores rather than all of them.
+        [[nodiscard]] u32 GetDecodeThreads() const;
+
+        AssetResult ReadAsset(const str& name) const;
+        AssetResult LoadFromArchive(const str& name) const;
+        AssetResult LoadLooseFiles(const str& name, const std::filesystem::path& root) const;
+        /// @brief Shares the payload of a loaded asset with the same content hash as `metadata`
+        /// describes, so duplicates are neither read nor decoded. Null if there is none.
+        Shared<Asset> ShareLoaded(const str& name, std::unordered_map<str, str>& metadata) const;
 
-        static bool ValidatePakHeader(const std::vector<u8>& pakBytes);
+        /// @brief Multi-block LZMA payloads are decoded on up to `threads` threads.
+        static std::optional<std::vector<u8>> ReadPakFile(const std::filesystem::path& filename,
+                                                          const DictionarySet& dictionaries,
+                                                          u32 threads);
+        static bool ValidatePakHeader(std::span<const u8> header, size_t fileSize);
         static bool ReadMetadata(const std::filesystem::path& filename,
                                  std::unordered_map<str, str>& metadata);
     };
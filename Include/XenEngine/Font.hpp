@@ -0,0 +1,91 @@
+// Author: Jake Rieger
+// Created: 12/3/2024.
+//
+
+#pragma once
+
+#include "ContentManager.hpp"
+
+#include <FontFormat.hpp>
+#include <Types.hpp>
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace Xen {
+    /// @brief A signed distance field font built by XPak. Owns the glyph atlas texture and the
+    /// per-glyph metrics; all metrics are in pixels at GetSize(). Reload() refreshes live fonts
+    /// in place; holders compare GetVersion() to notice.
+    class Font {
+    public:
+        explicit Font(const Shared<Asset>& fontAsset);
+        ~Font();
+
+        Font(const Font&)            = delete;
+        Font& operator=(const Font&) = delete;
+
+        /// @brief Returns the metrics for `codepoint`, or nullptr if the font doesn't contain it.
+        [[nodiscard]] const FontFormat::GlyphMetrics* GetGlyph(u32 codepoint) const {
+            if (codepoint < kAsciiCount) {
+                const i32 index = mAscii[codepoint];
+                return index < 0 ? nullptr : &mGlyphs[index];
+            }
+            const auto it = mExtended.find(codepoint);
+            return it == mExtended.end() ? nullptr : &mGlyphs[it->second];
+        }
+
+        [[nodiscard]] const str& GetName() const {
+            return mName;
+        }
+
+        [[nodiscard]] f32 GetSize() const {
+            return mHeader.Size;
+        }
+
+        [[nodiscard]] f32 GetSpread() const {
+            return mHeader.Spread;
+        }
+
+        [[nodiscard]] f32 GetLineHeight() const {
+            return mHeader.LineHeight;
+        }
+
+        [[nodiscard]] f32 GetAscender() const {
+            return mHeader.Ascender;
+        }
+
+        [[nodiscard]] u32 GetTexture() const {
+            return mTexture;
+        }
+
+        /// @brief Changes whenever the font is reloaded, which invalidates laid out text.
+        [[nodiscard]] u32 GetVersion() const {
+            return mVersion;
+        }
+
+        /// @brief Reloads every live font loaded from an asset of the same name. Meant as a
+        /// ContentManager reload listener; does nothing for other assets.
+        static void Reload(const Asset& asset);
+
+        /// @brief Decodes the UTF-8 sequence starting at `offset` and advances `offset` past it.
+        /// Malformed sequences decode to U+FFFD one byte at a time.
+        static u32 NextCodepoint(const str& text, size_t& offset);
+
+    private:
+        static constexpr u32 kAsciiCount = 128;
+
+        str mName;
+        FontFormat::FontHeader mHeader {};
+        std::vector<FontFormat::GlyphMetrics> mGlyphs;
+        // Text is overwhelmingly ASCII, so those glyphs get a flat table and everything else
+        // falls back to a hash lookup
+        std::array<i32, kAsciiCount> mAscii {};
+        std::unordered_map<u32, u32> mExtended;
+        u32 mTexture = 0;
+        u32 mVersion = 0;
+
+        /// @brief Replaces the metrics and texture with `fontAsset`'s. Returns why it couldn't,
+        /// leaving the font as it was, or an empty string.
+        str Load(const Asset& fontAsset);
+    };
+}  // namespace Xen
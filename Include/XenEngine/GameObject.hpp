@@ -52,6 +52,10 @@ namespace Xen {
             return GetComponentAs<Transform>("Transform");
         }
 
+        [[nodiscard]] TextRenderer* GetTextRenderer() {
+            return GetComponentAs<TextRenderer>("Text Renderer");
+        }
+
         void Awake();
 
         static void RegisterType(sol::state& state);
@@ -0,0 +1,79 @@
+// Author: Jake Rieger
+// Created: 12/2/2024.
+//
+
+#pragma once
+
+#include "SpriteBatch.hpp"
+
+#include <Types.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Xen {
+    struct ParticleSettings {
+        u32 MaxParticles     = 10000;
+        f32 Rate             = 100.f;       // Particles emitted per second
+        f32 Lifetime         = 1.f;         // Seconds
+        f32 LifetimeVariance = 0.f;
+        f32 Speed            = 1.f;         // World units per second
+        f32 SpeedVariance    = 0.f;
+        f32 Direction        = 1.5707964f;  // Radians, 0 = +X
+        f32 Spread           = 6.2831855f;  // Radians, centered on Direction
+        f32 Size             = 1.f;         // World units
+        glm::vec2 Gravity    = glm::vec2(0.f);
+        glm::vec4 StartColor = glm::vec4(1.f);
+        glm::vec4 EndColor   = glm::vec4(1.f, 1.f, 1.f, 0.f);
+    };
+
+    /// @brief Structure-of-arrays particle storage and simulation. Has no dependency on the
+    /// graphics context so it can be driven (and benchmarked) on its own.
+    ///
+    /// Live particles always occupy [0, GetCount()), in no particular order. Simulate() integrates
+    /// every live particle with SIMD kernels, then compacts dead particles out with branch-free
+    /// index passes.
+    class ParticlePool {
+    public:
+        explicit ParticlePool(u32 capacity = 0, u32 seed = 0x9E3779B9u);
+
+        void Resize(u32 capacity);
+
+        /// @brief Spawns up to `count` particles at (x, y). Excess particles beyond capacity are
+        /// dropped.
+        void Emit(u32 count, f32 x, f32 y, const ParticleSettings& settings);
+
+        /// @brief Advances all live particles by `dT` seconds and removes the ones that died.
+        void Simulate(f32 dT, const ParticleSettings& settings);
+
+        /// @brief Writes `count` instances starting at particle `first` into `out`.
+        void WriteInstances(SpriteInstance* out, u32 first, u32 count, f32 size) const;
+
+        void Clear() {
+            mCount = 0;
+        }
+
+        [[nodiscard]] u32 GetCount() const {
+            return mCount;
+        }
+
+        [[nodiscard]] u32 GetCapacity() const {
+            return mCapacity;
+        }
+
+    private:
+        // Padded to a multiple of the SIMD width so kernels never need a scalar tail
+        std::vector<f32> mPosX, mPosY;
+        std::vector<f32> mVelX, mVelY;
+        std::vector<f32> mR, mG, mB, mA;
+        std::vector<f32> mDR, mDG, mDB, mDA;
+        std::vector<f32> mLife;
+        std::vector<u32> mScratch;  // Index lists for Compact()
+        u32 mCapacity = 0;
+        u32 mCount    = 0;
+        u32 mSeed;
+
+        f32 NextRandom();
+        void Integrate(f32 dT, f32 gravityX, f32 gravityY);
+        void Compact();
+    };
+}  // namespace Xen
@@ -26,7 +26,7 @@ namespace Xen {
         explicit Scene(str name) : Name(std::move(name)) {
             GameObjects.clear();
             // TODO: This should be read from the *.xproj file located in the project root
-            this->mContentManager = std::make_shared<ContentManager>("Content");
+            this->mContentManager = ContentManager::GetShared("Content");
         }
 
         static Unique<Scene> Load(const char* filename);
@@ -41,6 +41,12 @@ namespace Xen {
 
         Camera* GetMainCamera();
 
+        /// @brief For streaming assets in while the scene runs. Completion callbacks from
+        /// LoadAssetAsync are delivered during Update().
+        [[nodiscard]] const Shared<ContentManager>& GetContentManager() const {
+            return mContentManager;
+        }
+
         static void RegisterTypes(sol::state_view& sv) {
             sv.new_usertype<Scene>("Scene", "DestroyGameObject", &Scene::DestroyGameObject);
         }
@@ -0,0 +1,73 @@
+// Author: Jake Rieger
+// Created: 12/2/2024.
+//
+
+#pragma once
+
+#include "Shader.hpp"
+#include "VertexArray.hpp"
+
+#include <Types.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Xen {
+    /// @brief Per-instance data consumed by the batch shader. Layout must match the instance
+    /// attributes bound in SpriteBatch (three vec4s).
+    struct SpriteInstance {
+        f32 X, Y;                   // Center in world space
+        f32 HalfWidth, HalfHeight;  // Half extents in world space
+        f32 U0, V0, U1, V1;         // Texture rect (bottom-left, top-right)
+        f32 R, G, B, A;             // Tint
+    };
+
+    static_assert(sizeof(SpriteInstance) == 12 * sizeof(f32));
+
+    /// @brief Draws textured quads with instanced rendering. Instances are written directly into
+    /// the batch's staging storage via Reserve() and uploaded in one call per flush, so a batch
+    /// costs one draw call per `capacity` quads sharing a texture.
+    class SpriteBatch {
+    public:
+        static constexpr u32 kDefaultCapacity = 16384;
+
+        explicit SpriteBatch(u32 capacity = kDefaultCapacity,
+                             cstr vertexSource = nullptr,
+                             cstr fragmentSource = nullptr);
+
+        void Begin(const glm::mat4& viewProjection, u32 texture);
+
+        /// @brief Returns storage for `count` instances, flushing first if the batch is full. The
+        /// caller must fill every reserved instance before the next call into the batch.
+        /// `count` must not exceed GetCapacity().
+        SpriteInstance* Reserve(u32 count);
+
+        void Submit(const SpriteInstance& instance);
+        void End();
+
+        [[nodiscard]] u32 GetCapacity() const {
+            return mCapacity;
+        }
+
+        /// @brief Number of draw calls issued since the last Begin().
+        [[nodiscard]] u32 GetDrawCalls() const {
+            return mDrawCalls;
+        }
+
+        [[nodiscard]] Shader* GetShader() const {
+            return mShader.get();
+        }
+
+    private:
+        Unique<VertexArray> mVAO;
+        Unique<Shader> mShader;
+        std::vector<SpriteInstance> mInstances;
+        glm::mat4 mViewProjection = glm::mat4(1.f);
+        u32 mCapacity;
+        u32 mCount     = 0;
+        u32 mTexture   = 0;
+        u32 mDrawCalls = 0;
+        bool mDrawing  = false;
+
+        void Flush();
+    };
+}  // namespace Xen
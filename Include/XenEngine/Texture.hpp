@@ -4,10 +4,15 @@
 
 #pragma once
 
+#include "ContentManager.hpp"
+
 #include <Types.hpp>
+#include <algorithm>
 #include <glad/glad.h>
 #include <stb_image.h>
 #include <Panic.hpp>
+#include <TextureFormat.hpp>
+#include <unordered_map>
 #include <vector>
 
 namespace Xen {
@@ -64,24 +69,73 @@ namespace Xen {
         /// @brief Loads a texture from data stored in memory. Assumes RGBA color format (4 bytes
         /// per pixel). See XPak source for specific details on how textures are processed for
         /// in-memory loading.
+        ///
+        /// `data` holds `mipLevels` levels back to back, largest first. Passing 0 uploads only the
+        /// base level and generates the rest on the GPU (for paks built before XPak stored mips).
+        static u32 LoadFromMemory(const u8* data,
+                                  int width,
+                                  int height,
+                                  GLenum format = GL_RGBA,
+                                  u32 mipLevels = 1) {
+            u32 id;
+            glGenTextures(1, &id);
+            Upload(id, data, width, height, format, mipLevels);
+            return id;
+        }
+
         static u32 LoadFromMemory(const std::vector<u8>& data,
                                   int width,
                                   int height,
-                                  GLenum format = GL_RGBA) {
+                                  GLenum format = GL_RGBA,
+                                  u32 mipLevels = 1) {
+            return LoadFromMemory(data.data(), width, height, format, mipLevels);
+        }
+
+        /// @brief Uploads a mip chain in any TextureFormat (see TextureFormat.hpp for the layout).
+        /// Block-compressed chains go straight to glCompressedTexImage2D; R8 and RG8 are
+        /// swizzled to gray / gray + alpha so shaders see the same colors as the RGBA8 source.
+        static u32 LoadFromMemory(const u8* data,
+                                  int width,
+                                  int height,
+                                  TextureFormat format,
+                                  u32 mipLevels) {
             u32 id;
             glGenTextures(1, &id);
+            Upload(id, data, width, height, format, mipLevels);
+            return id;
+        }
 
+        /// @brief Replaces the contents of texture `id`, which may change its size and format,
+        /// with a mip chain laid out as for LoadFromMemory.
+        static void Upload(u32 id,
+                           const u8* data,
+                           int width,
+                           int height,
+                           GLenum format = GL_RGBA,
+                           u32 mipLevels = 1) {
             glBindTexture(GL_TEXTURE_2D, id);
-            glTexImage2D(GL_TEXTURE_2D,
-                         0,
-                         CAST<int>(format),
-                         width,
-                         height,
-                         0,
-                         format,
-                         GL_UNSIGNED_BYTE,
-                         data.data());
-            glGenerateMipmap(GL_TEXTURE_2D);
+            const int bytesPerPixel = GetBytesPerPixel(format);
+            const u32 levels        = std::max(mipLevels, 1u);
+            for (u32 level = 0; level < levels; ++level) {
+                glTexImage2D(GL_TEXTURE_2D,
+                             CAST<int>(level),
+                             CAST<int>(format),
+                             width,
+                             height,
+                             0,
+                             format,
+                             GL_UNSIGNED_BYTE,
+                             data);
+                data += CAST<size_t>(width) * height * bytesPerPixel;
+                width  = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+            }
+            if (mipLevels == 0) {
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);  // The GL default
+                glGenerateMipmap(GL_TEXTURE_2D);
+            } else {
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, CAST<int>(levels - 1));
+            }
 
             glTexParameteri(GL_TEXTURE_2D,
                             GL_TEXTURE_WRAP_S,
@@ -89,13 +143,117 @@ namespace Xen {
             glTexParameteri(GL_TEXTURE_2D,
                             GL_TEXTURE_WRAP_T,
                             format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D,
+                            GL_TEXTURE_MIN_FILTER,
+                            levels > 1 || mipLevels == 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+
+        static void Upload(u32 id,
+                           const u8* data,
+                           int width,
+                           int height,
+                           TextureFormat format,
+                           u32 mipLevels) {
+            if (format == TextureFormat::RGBA8) {
+                Upload(id, data, width, height, GL_RGBA, mipLevels);
+                return;
+            }
 
+            glBindTexture(GL_TEXTURE_2D, id);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);  // Rows are tightly packed
+            const auto layout = GetPixelLayout(format);
+            const u32 levels  = std::max(mipLevels, 1u);
+            for (u32 level = 0; level < levels; ++level) {
+                const auto size = TextureFormats::GetLevelSize(format, width, height);
+                if (TextureFormats::IsBlockCompressed(format)) {
+                    glCompressedTexImage2D(GL_TEXTURE_2D,
+                                           CAST<int>(level),
+                                           layout.InternalFormat,
+                                           width,
+                                           height,
+                                           0,
+                                           CAST<GLsizei>(size),
+                                           data);
+                } else {
+                    glTexImage2D(GL_TEXTURE_2D,
+                                 CAST<int>(level),
+                                 CAST<int>(layout.InternalFormat),
+                                 width,
+                                 height,
+                                 0,
+                                 layout.Format,
+                                 layout.Type,
+                                 data);
+                }
+                data += size;
+                width  = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, CAST<int>(levels - 1));
+            if (layout.Swizzle[0] != GL_RED || layout.Swizzle[3] != GL_ALPHA) {
+                glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, layout.Swizzle);
+            }
+
+            const int wrap = TextureFormats::HasAlpha(format) ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+            glTexParameteri(GL_TEXTURE_2D,
+                            GL_TEXTURE_MIN_FILTER,
+                            levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+
+        /// @brief Loads a texture asset produced by XPak, using its 'width', 'height', 'mips' and
+        /// 'format' metadata. The texture is refreshed by Reload() until it is deleted.
+        static u32 LoadFromAsset(const Asset& asset) {
+            u32 id;
+            glGenTextures(1, &id);
+            UploadAsset(id, asset);
+            GetAssetTextures().insert_or_assign(id, asset.Name);
             return id;
         }
 
+        /// @brief Uploads `asset` again into every texture loaded from an asset of the same name.
+        /// Meant as a ContentManager reload listener; does nothing for non-texture assets.
+        static void Reload(const Asset& asset) {
+            bool uploaded = false;
+            for (const auto& [id, name] : GetAssetTextures()) {
+                if (name != asset.Name) { continue; }
+                UploadAsset(id, asset);
+                uploaded = true;
+            }
+            if (uploaded) { glBindTexture(GL_TEXTURE_2D, 0); }
+        }
+
+        /// @brief Size in bytes of a `levels`-deep mip chain as laid out by LoadFromMemory.
+        static size_t GetMipChainSize(int width, int height, u32 levels, GLenum format = GL_RGBA) {
+            size_t size = 0;
+            for (u32 level = 0; level < std::max(levels, 1u); ++level) {
+                size += CAST<size_t>(width) * height * GetBytesPerPixel(format);
+                width  = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+            }
+            return size;
+        }
+
+        static void SetFilter(u32 id, GLenum minFilter, GLenum magFilter) {
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, CAST<int>(minFilter));
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, CAST<int>(magFilter));
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        static void SetWrap(u32 id, GLenum wrap) {
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, CAST<int>(wrap));
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, CAST<int>(wrap));
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
         static void Delete(u32 id) {
+            GetAssetTextures().erase(id);
             glDeleteTextures(1, &id);
         }
 
@@ -109,6 +267,93 @@ namespace Xen {
         }
 
     private:
-        static constexpr auto kMaxSlot = 31;
+        static constexpr auto kMaxSlot            = 31;
+        static constexpr int kIdentitySwizzle[4] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+
+        /// @brief Textures loaded from assets, so they can be reloaded. Id -> asset name.
+        static std::unordered_map<u32, str>& GetAssetTextures() {
+            static std::unordered_map<u32, str> textures;
+            return textures;
+        }
+
+        static void UploadAsset(u32 id, const Asset& asset) {
+            const auto& metadata = asset.Metadata;
+            if (!metadata.contains("width") || !metadata.contains("height")) {
+                Panic("Invalid texture metadata: %s", asset.Name.c_str());
+            }
+            const auto mips       = metadata.find("mips");
+            const auto formatName = metadata.find("format");
+            const u32 mipLevels   = mips == metadata.end() ? 0 : ToUInt(mips->second);
+            const auto format     = formatName == metadata.end()
+                                      ? TextureFormat::RGBA8
+                                      : TextureFormats::FromString(formatName->second)
+                                          .value_or(TextureFormat::RGBA8);
+            // A previous upload into the same texture may have swizzled it
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, kIdentitySwizzle);
+            Upload(id,
+                   asset.GetData().data(),
+                   ToInt(metadata.at("width")),
+                   ToInt(metadata.at("height")),
+                   format,
+                   mipLevels);
+            asset.OnUploaded();
+        }
+
+        struct PixelLayout {
+            GLenum InternalFormat;
+            GLenum Format;
+            GLenum Type;
+            int Swizzle[4];
+        };
+
+        static PixelLayout GetPixelLayout(TextureFormat format) {
+            PixelLayout layout {GL_RGBA8,
+                                GL_RGBA,
+                                GL_UNSIGNED_BYTE,
+                                {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}};
+            switch (format) {
+                case TextureFormat::R8:
+                    layout = {GL_R8, GL_RED, GL_UNSIGNED_BYTE, {GL_RED, GL_RED, GL_RED, GL_ONE}};
+                    break;
+                case TextureFormat::RG8:
+                    layout = {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, {GL_RED, GL_RED, GL_RED, GL_GREEN}};
+                    break;
+                case TextureFormat::RGB565:
+                    layout.InternalFormat = GL_RGB565;
+                    layout.Format         = GL_RGB;
+                    layout.Type           = GL_UNSIGNED_SHORT_5_6_5;
+                    break;
+                case TextureFormat::RGBA4444:
+                    layout.InternalFormat = GL_RGBA4;
+                    layout.Type           = GL_UNSIGNED_SHORT_4_4_4_4;
+                    break;
+                case TextureFormat::BC1:
+                    layout.InternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+                    break;
+                case TextureFormat::BC3:
+                    layout.InternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                    break;
+                case TextureFormat::BC7:
+                    layout.InternalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+                    break;
+                default:
+                    break;
+            }
+            return layout;
+        }
+
+        static int GetBytesPerPixel(GLenum format) {
+            switch (format) {
+                case GL_RED:
+                    return 1;
+                case GL_RG:
+                    return 2;
+                case GL_RGB:
+                    return 3;
+                default:
+                    return 4;
+            }
+        }
     };
 }  // namespace Xen
\ No newline at end of file
@@ -0,0 +1,70 @@
+// Author: Jake Rieger
+// Created: 12/4/2024.
+//
+
+#pragma once
+
+#include "ContentManager.hpp"
+
+#include <Types.hpp>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace Xen {
+    struct AtlasRegion {
+        u32 Page;
+        glm::vec4 UV;    // u0, v0, u1, v1
+        glm::vec4 Quad;  // Center offset (xy) and scale (zw) of the trimmed rect in the [-1, 1]
+                         // quad that covers the untrimmed source image
+    };
+
+    /// @brief Pages and named regions of an atlas built by XPak. Instances are shared per asset
+    /// through Get(), so every sprite drawn from the same atlas binds the same textures. Reload()
+    /// refreshes a live atlas in place; holders compare GetVersion() to notice.
+    class TextureAtlas {
+    public:
+        explicit TextureAtlas(const Shared<Asset>& atlasAsset);
+        ~TextureAtlas();
+
+        TextureAtlas(const TextureAtlas&)            = delete;
+        TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+        /// @brief Returns the atlas for `atlasAsset`, creating its textures on first use. Textures
+        /// are released once the last user lets go.
+        static Shared<TextureAtlas> Get(const Shared<Asset>& atlasAsset);
+
+        /// @brief Rebuilds the pages and regions of the live atlas loaded from an asset of the
+        /// same name, if there is one. Meant as a ContentManager reload listener; does nothing
+        /// for other assets.
+        static void Reload(const Asset& asset);
+
+        [[nodiscard]] const AtlasRegion* GetRegion(const str& name) const {
+            const auto it = mRegions.find(name);
+            return it == mRegions.end() ? nullptr : &it->second;
+        }
+
+        [[nodiscard]] u32 GetTexture(u32 page) const {
+            return mPages.at(page);
+        }
+
+        [[nodiscard]] u32 GetPageCount() const {
+            return CAST<u32>(mPages.size());
+        }
+
+        /// @brief Changes whenever the atlas is reloaded, which invalidates regions copied out
+        /// of it.
+        [[nodiscard]] u32 GetVersion() const {
+            return mVersion;
+        }
+
+    private:
+        std::vector<u32> mPages;
+        std::unordered_map<str, AtlasRegion> mRegions;
+        u32 mVersion = 0;
+
+        /// @brief Replaces the pages and regions with `atlasAsset`'s. Returns why it couldn't,
+        /// leaving the atlas as it was, or an empty string.
+        str Load(const Asset& atlasAsset);
+    };
+}  // namespace Xen
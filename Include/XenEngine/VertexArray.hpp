@@ -47,14 +47,16 @@ namespace Xen {
         // glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
         template<typename T>
         void CreateVertexBuffer(const std::vector<T>& vertices,
-                                std::vector<VertexAttribute>& attribs) {
+                                std::vector<VertexAttribute>& attribs,
+                                u32 usage = GL_STATIC_DRAW) {
             BufferDescriptor<T> vboDescriptor = {};
+            vboDescriptor.Usage               = usage;
             vboDescriptor.Data                = vertices;
             const auto vbo                    = Buffer::CreateBuffer(vboDescriptor);
             glBindBuffer(GL_ARRAY_BUFFER, vbo);
             for (auto i = 0; i < attribs.size(); ++i) {
-                glEnableVertexAttribArray(i);
                 const auto attr = attribs[i];
+                glEnableVertexAttribArray(attr.Location);
                 glVertexAttribPointer(attr.Location,
                                       attr.Size,
                                       attr.Type,
@@ -66,6 +68,26 @@ namespace Xen {
             mVBOs.push_back(vbo);
         }
 
+        /// @brief Replaces the contents of the vertex buffer at `index` (in creation order). The
+        /// buffer is reallocated, so the new data may be larger or smaller than the old.
+        template<typename T>
+        void UpdateVertexBuffer(u32 index,
+                                const std::vector<T>& vertices,
+                                u32 usage = GL_STATIC_DRAW) const {
+            UpdateVertexBuffer(index, vertices.data(), vertices.size(), usage);
+        }
+
+        template<typename T>
+        void UpdateVertexBuffer(u32 index,
+                                const T* vertices,
+                                size_t count,
+                                u32 usage = GL_STATIC_DRAW) const {
+            if (index >= mVBOs.size()) { Panic("Vertex buffer index out of range"); }
+            glBindBuffer(GL_ARRAY_BUFFER, mVBOs[index]);
+            glBufferData(GL_ARRAY_BUFFER, CAST<GLsizeiptr>(sizeof(T) * count), vertices, usage);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
         template<typename T>
         void CreateElementBuffer(const std::vector<T>& indices) {
             auto eboDescriptor = BufferDescriptor<f32>();
@@ -79,8 +101,12 @@ namespace Xen {
             glVertexAttribDivisor(index, divisor);
         }
 
-        void Draw(u32 primitive = GL_TRIANGLES) const {
-            glDrawArrays(primitive, 0, 4);
+        void Draw(u32 primitive = GL_TRIANGLES, i32 count = 4) const {
+            glDrawArrays(primitive, 0, count);
+        }
+
+        void DrawInstanced(i32 instances, u32 primitive = GL_TRIANGLES, i32 count = 4) const {
+            glDrawArraysInstanced(primitive, 0, count, instances);
         }
 
         // TODO: Implement indexed drawing
@@ -0,0 +1,134 @@
+// Author: Jake Rieger
+// Created: 12/6/2024.
+//
+
+#pragma once
+
+#include "Types.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Archive Structure (produced by XPak, consumed by Xen::ContentManager)
+//
+// +------------------+-------------------------------------+--------------------+
+// | Name             | Size                                | Offset             |
+// +------------------+-------------------------------------+--------------------+
+// | ArchiveHeader    | sizeof(ArchiveHeader)               | 0                  |
+// +------------------+-------------------------------------+--------------------+
+// | Payloads         | Dynamic, aligned as described below | kAlignment         |
+// +------------------+-------------------------------------+--------------------+
+// | Metadata blocks  | ArchiveHeader::MetadataSize         | MetadataOffset     |
+// +------------------+-------------------------------------+--------------------+
+// | ArchiveEntry[]   | EntryCount * sizeof(ArchiveEntry)   | TocOffset          |
+// +------------------+-------------------------------------+--------------------+
+//
+// One archive holds a whole content bundle so the runtime can map it once instead of opening a
+// payload and a metadata file per asset. Entries are sorted by Id (FNV-1a 64 of the asset name)
+// for binary search. The table of contents sits at the end so payloads can be streamed out as
+// they are built; the header is patched last. Stored (Codec::None) payloads are page-aligned so
+// they can be handed to the GPU straight from the mapping; compressed payloads are only read by
+// the decoder, so they are packed at kPackedAlignment instead of wasting most of a page each.
+// Entries with byte-identical payloads share one copy.
+//
+// Entries flagged kEntryDictionary hold a trained Zstd dictionary rather than an asset. The
+// runtime loads them all at mount and decodes ZstdDict payloads against them.
+//
+// A metadata block is a u32 pair count followed by (u32 key length, key, u32 value length,
+// value) for each pair. All integers are little-endian.
+namespace ArchiveFormat {
+    static constexpr char kMagic[4]       = {'X', 'A', 'R', 'C'};
+    static constexpr u32 kVersion         = 1;
+    static constexpr u64 kAlignment       = 4096;
+    static constexpr u64 kPackedAlignment = 8;
+
+    // ArchiveEntry::Flags
+    static constexpr u8 kEntryDictionary = 1 << 0;
+
+    struct ArchiveHeader {
+        char Magic[4];
+        u32 Version;
+        u32 EntryCount;
+        u32 Reserved;
+        u64 TocOffset;
+        u64 MetadataOffset;
+        u64 MetadataSize;
+    };
+
+    struct ArchiveEntry {
+        u64 Id;
+        u64 Offset;          // Payload, from the start of the archive
+        u64 Size;            // Stored (possibly compressed) payload size
+        u64 OriginalSize;    // Payload size after decoding
+        u64 MetadataOffset;  // From ArchiveHeader::MetadataOffset
+        u32 MetadataSize;
+        u8 Codec;  // A `Codec` value (Compression.hpp)
+        u8 Flags;  // kEntry* bits
+        u8 Padding[2];
+    };
+
+    static_assert(sizeof(ArchiveHeader) == 40);
+    static_assert(sizeof(ArchiveEntry) == 48);
+
+    static u64 HashName(const str& name) {
+        u64 hash = 14695981039346656037ull;
+        for (const char c : name) {
+            hash = (hash ^ CAST<u8>(c)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static u64 Align(u64 offset, u64 alignment = kAlignment) {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    static void WriteMetadata(const std::unordered_map<str, str>& metadata, std::vector<u8>& out) {
+        const auto append = [&out](const void* data, size_t size) {
+            const auto* bytes = CAST<const u8*>(data);
+            out.insert(out.end(), bytes, bytes + size);
+        };
+        // Sorted so identical metadata always produces identical bytes
+        std::vector<std::pair<str, str>> pairs(metadata.begin(), metadata.end());
+        std::ranges::sort(pairs);
+        const auto count = CAST<u32>(pairs.size());
+        append(&count, 4);
+        for (const auto& [key, value] : pairs) {
+            const auto keySize   = CAST<u32>(key.size());
+            const auto valueSize = CAST<u32>(value.size());
+            append(&keySize, 4);
+            append(key.data(), keySize);
+            append(&valueSize, 4);
+            append(value.data(), valueSize);
+        }
+    }
+
+    /// @brief Parses a metadata block, returning false if it runs past `size`.
+    static bool ReadMetadata(const u8* data, size_t size, std::unordered_map<str, str>& metadata) {
+        size_t position = 0;
+        const auto read = [&](void* target, size_t count) {
+            if (position + count > size) { return false; }
+            memcpy(target, data + position, count);
+            position += count;
+            return true;
+        };
+        const auto readString = [&](str& target) {
+            u32 length;
+            if (!read(&length, 4) || position + length > size) { return false; }
+            target.assign(RCAST<const char*>(data + position), length);
+            position += length;
+            return true;
+        };
+
+        u32 count;
+        if (!read(&count, 4)) { return false; }
+        metadata.reserve(count);
+        for (u32 i = 0; i < count; ++i) {
+            str key, value;
+            if (!readString(key) || !readString(value)) { return false; }
+            metadata.insert_or_assign(std::move(key), std::move(value));
+        }
+        return true;
+    }
+}  // namespace ArchiveFormat
@@ -5,34 +5,95 @@
 #pragma once
 
 #include "Types.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <lz4frame.h>
 #include <lzma.h>
 #include <zlib.h>
+#include <zdict.h>
+#include <zstd.h>
 
+/// @brief Payload codecs. Stored in byte 7 of .xpkf headers and in ArchiveEntry::Codec; 0 and
+/// 1 match the old "compressed" flag, so paks built before codecs were selectable still load.
+enum class Codec : u8 {
+    None = 0,
+    LZMA = 1,
+    GZip = 2,
+    LZ4  = 3,
+    Zstd = 4,
+    // Zstd against a dictionary trained per asset category; the frame carries the dictionary ID
+    ZstdDict = 5,
+};
+
+struct CodecSettings {
+    Codec Type = Codec::None;
+    i32 Level  = 0;  // Codec-specific; 0 picks the codec's default
+};
+
+/// @brief xz compression. Payloads are split into independent kBlockSize blocks, compressed by
+/// liblzma's multithreaded encoder; the stream's block index lets decoding fan the blocks out
+/// across cores. Single-block streams (small payloads, or paks built before blocking) decode
+/// sequentially as before.
 class LZMA {
 public:
-    static std::optional<std::vector<uint8_t>> Compress(const std::vector<uint8_t>& data) {
+    static constexpr size_t kBlockSize = 1 << 20;
+
+    /// @brief `threads` = 0 uses every core. Output is identical for any thread count. `level`
+    /// is the xz preset (0-9), always in its extreme variant.
+    static std::optional<std::vector<uint8_t>> Compress(const std::vector<uint8_t>& data,
+                                                        u32 threads = 0,
+                                                        u32 level   = 0) {
         if (data.empty()) { return {}; }
+
+        lzma_options_lzma options;
+        if (lzma_lzma_preset(&options, std::min(level, 9u) | LZMA_PRESET_EXTREME)) { return {}; }
+        // A dictionary larger than a block can never be filled; capping it keeps per-thread
+        // encoder memory small
+        options.dict_size = std::min<uint32_t>(options.dict_size, kBlockSize);
+        const lzma_filter filters[] = {
+          {LZMA_FILTER_LZMA2, &options},
+          {LZMA_VLI_UNKNOWN, nullptr},
+        };
+
+        lzma_mt mt {};
+        mt.threads    = ResolveThreads(threads);
+        mt.block_size = kBlockSize;
+        mt.filters    = filters;
+        mt.check      = LZMA_CHECK_CRC64;
+
         lzma_stream stream = LZMA_STREAM_INIT;
-        lzma_ret ret       = lzma_easy_encoder(&stream, LZMA_PRESET_EXTREME, LZMA_CHECK_CRC64);
+        lzma_ret ret       = lzma_stream_encoder_mt(&stream, &mt);
         if (ret != LZMA_OK) {
             std::cerr << "LZMA error: " << ret << std::endl;
             return {};
         }
 
-        std::vector<uint8_t> compressed;
-        compressed.resize(data.size() + data.size() / 3 + 128);
-
+        std::vector<uint8_t> compressed(GetCompressBound(data.size()));
         stream.next_in   = data.data();
         stream.avail_in  = data.size();
         stream.next_out  = compressed.data();
         stream.avail_out = compressed.size();
 
-        // Do the actual compression
-        ret = lzma_code(&stream, LZMA_FINISH);
+        // The threaded encoder returns whenever a block is ready, so loop until the end. The
+        // bound should leave room for everything; grow rather than fail if it ever doesn't
+        while ((ret = lzma_code(&stream, LZMA_FINISH)) == LZMA_OK) {
+            if (stream.avail_out > 0) { continue; }
+            const size_t used = compressed.size();
+            compressed.resize(used + used / 2 + 1);
+            stream.next_out  = compressed.data() + used;
+            stream.avail_out = compressed.size() - used;
+        }
         if (ret != LZMA_STREAM_END) {
             lzma_end(&stream);
             std::cerr << "LZMA error: " << ret << std::endl;
@@ -45,48 +106,194 @@ public:
     }
 
     static std::optional<std::vector<uint8_t>> Decompress(const std::vector<uint8_t>& data,
-                                                          const size_t originalSize) {
+                                                          const size_t originalSize,
+                                                          u32 threads = 0) {
         if (data.empty()) { return {}; }
+        std::vector<uint8_t> decompressed(originalSize);
+        if (!DecompressInto(data, decompressed, threads)) { return {}; }
+        return decompressed;
+    }
+
+    /// @brief Decompresses straight into `output`, which must be exactly the original size.
+    /// Multi-block streams are decoded on up to `threads` threads (0 = every core).
+    static bool DecompressInto(std::span<const uint8_t> data,
+                               std::span<uint8_t> output,
+                               u32 threads = 0) {
+        if (data.empty()) { return false; }
 
+        std::vector<BlockRange> blocks;
+        threads = ResolveThreads(threads);
+        if (threads > 1 && ReadBlockIndex(data, output.size(), blocks) && blocks.size() > 1) {
+            return DecompressBlocks(data, output, blocks, threads);
+        }
+        return DecompressStream(data, output);
+    }
+
+private:
+    struct BlockRange {
+        size_t CompressedOffset;  // Block header, from the start of the stream
+        size_t UncompressedOffset;
+        size_t UncompressedSize;
+        lzma_vli UnpaddedSize;
+        lzma_check Check;
+    };
+
+    static u32 ResolveThreads(u32 threads) {
+        if (threads != 0) { return threads; }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /// @brief Worst-case size of a blocked stream. lzma_stream_buffer_bound() assumes a single
+    /// block, but every kBlockSize block adds its own header, check and index record.
+    static size_t GetCompressBound(size_t size) {
+        const size_t blocks = std::max<size_t>(1, (size + kBlockSize - 1) / kBlockSize);
+        return blocks * (lzma_block_buffer_bound(kBlockSize) + 2 * LZMA_VLI_BYTES_MAX) +
+               lzma_stream_buffer_bound(0);
+    }
+
+    static bool DecompressStream(std::span<const uint8_t> data, std::span<uint8_t> output) {
         lzma_stream stream = LZMA_STREAM_INIT;
         lzma_ret ret       = lzma_auto_decoder(&stream, UINT64_MAX, 0);
         if (ret != LZMA_OK) {
             std::cerr << "LZMA error: " << ret << std::endl;
-            return {};
+            return false;
         }
 
-        std::vector<uint8_t> decompressed(originalSize);
-
         stream.next_in   = data.data();
         stream.avail_in  = data.size();
-        stream.next_out  = decompressed.data();
-        stream.avail_out = decompressed.size();
+        stream.next_out  = output.data();
+        stream.avail_out = output.size();
 
         // Do the actual decompression
         ret = lzma_code(&stream, LZMA_FINISH);
-        if (ret != LZMA_STREAM_END) {
+        if (ret != LZMA_STREAM_END || stream.total_out != output.size()) {
             lzma_end(&stream);
             std::cerr << "LZMA error: " << ret << std::endl;
-            return {};
+            return false;
         }
 
         lzma_end(&stream);  // Clean up
-        return decompressed;
+        return true;
+    }
+
+    /// @brief Reads the index of a single-stream .xz file. Returns false for anything else
+    /// (e.g. legacy .lzma data or concatenated streams), which then decodes sequentially.
+    static bool ReadBlockIndex(std::span<const uint8_t> data,
+                               size_t outputSize,
+                               std::vector<BlockRange>& blocks) {
+        if (data.size() < 2 * LZMA_STREAM_HEADER_SIZE) { return false; }
+        const size_t footerOffset = data.size() - LZMA_STREAM_HEADER_SIZE;
+        lzma_stream_flags header, footer;
+        if (lzma_stream_header_decode(&header, data.data()) != LZMA_OK ||
+            lzma_stream_footer_decode(&footer, data.data() + footerOffset) != LZMA_OK ||
+            lzma_stream_flags_compare(&header, &footer) != LZMA_OK ||
+            footer.backward_size > footerOffset - LZMA_STREAM_HEADER_SIZE) {
+            return false;
+        }
+        const size_t indexOffset = footerOffset - footer.backward_size;
+
+        lzma_index* index    = nullptr;
+        uint64_t memoryLimit = UINT64_MAX;
+        size_t position      = indexOffset;
+        if (lzma_index_buffer_decode(&index,
+                                     &memoryLimit,
+                                     nullptr,
+                                     data.data(),
+                                     &position,
+                                     footerOffset) != LZMA_OK) {
+            return false;
+        }
+
+        bool valid = lzma_index_uncompressed_size(index) == outputSize;
+        lzma_index_iter iter;
+        lzma_index_iter_init(&iter, index);
+        while (valid && !lzma_index_iter_next(&iter, LZMA_INDEX_ITER_NONEMPTY_BLOCK)) {
+            const auto& block = iter.block;
+            valid = block.compressed_file_offset + block.total_size <= indexOffset;
+            blocks.push_back({CAST<size_t>(block.compressed_file_offset),
+                              CAST<size_t>(block.uncompressed_file_offset),
+                              CAST<size_t>(block.uncompressed_size),
+                              block.unpadded_size,
+                              header.check});
+        }
+        lzma_index_end(index, nullptr);
+        return valid;
+    }
+
+    static bool DecompressBlock(std::span<const uint8_t> data,
+                                std::span<uint8_t> output,
+                                const BlockRange& range) {
+        lzma_filter filters[LZMA_FILTERS_MAX + 1];
+        lzma_block block {};
+        block.version     = 0;
+        block.check       = range.Check;
+        block.filters     = filters;
+        block.header_size = lzma_block_header_size_decode(data[range.CompressedOffset]);
+        if (range.CompressedOffset + block.header_size > data.size() ||
+            lzma_block_header_decode(&block, nullptr, data.data() + range.CompressedOffset) !=
+              LZMA_OK) {
+            return false;
+        }
+
+        lzma_stream stream = LZMA_STREAM_INIT;
+        bool success       = lzma_block_compressed_size(&block, range.UnpaddedSize) == LZMA_OK;
+        success            = success && lzma_block_decoder(&stream, &block) == LZMA_OK;
+        for (u32 i = 0; filters[i].id != LZMA_VLI_UNKNOWN; ++i) {
+            free(filters[i].options);  // Allocated by lzma_block_header_decode
+        }
+        if (!success) { return false; }
+
+        const size_t start = range.CompressedOffset + block.header_size;
+        stream.next_in     = data.data() + start;
+        stream.avail_in    = data.size() - start;
+        stream.next_out    = output.data() + range.UncompressedOffset;
+        stream.avail_out   = range.UncompressedSize;
+        success = lzma_code(&stream, LZMA_FINISH) == LZMA_STREAM_END &&
+                  stream.total_out == range.UncompressedSize;
+        lzma_end(&stream);
+        return success;
+    }
+
+    static bool DecompressBlocks(std::span<const uint8_t> data,
+                                 std::span<uint8_t> output,
+                                 const std::vector<BlockRange>& blocks,
+                                 u32 threads) {
+        std::atomic<size_t> next = 0;
+        std::atomic<bool> failed = false;
+        const auto worker        = [&] {
+            for (size_t i = next++; i < blocks.size() && !failed; i = next++) {
+                if (!DecompressBlock(data, output, blocks[i])) { failed = true; }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        const size_t helpers = std::min<size_t>(threads, blocks.size()) - 1;
+        for (size_t i = 0; i < helpers; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        if (failed) { std::cerr << "LZMA error: corrupt block" << std::endl; }
+        return !failed;
     }
 };
 
 class GZip {
 public:
-    static std::optional<std::vector<uint8_t>> Compress(const std::vector<uint8_t>& input) {
+    static std::optional<std::vector<uint8_t>> Compress(const std::vector<uint8_t>& input,
+                                                        i32 level = Z_DEFAULT_COMPRESSION) {
         if (input.empty()) { return {}; }
 
         uLongf compressedSize = compressBound(input.size());
         std::vector<uint8_t> compressedData(compressedSize);
 
-        const auto result = compress(compressedData.data(),
-                                     &compressedSize,
-                                     RCAST<const Bytef*>(input.data()),
-                                     input.size());
+        const auto result = compress2(compressedData.data(),
+                                      &compressedSize,
+                                      RCAST<const Bytef*>(input.data()),
+                                      input.size(),
+                                      level);
 
         if (result != Z_OK) {
             std::cerr << "Compression error: " << result << std::endl;
@@ -99,37 +306,527 @@ public:
 
     static std::optional<std::vector<uint8_t>> Decompress(const std::vector<uint8_t>& data,
                                                           const size_t originalSize) {
-        if (data.empty() || originalSize <= 0) { return {}; }
+        if (data.empty()) { return {}; }
+        std::vector<uint8_t> decompressed(originalSize);
+        if (!DecompressInto(data, decompressed)) { return {}; }
+        return decompressed;
+    }
 
-        // Initial guess for decompressed size (can be adjusted later if needed)
-        uLongf decompressedSize = data.size() * 4;  // Start with a larger buffer
-        std::vector<uint8_t> decompressedData(decompressedSize);
+    /// @brief Decompresses straight into `output`, which must be exactly the original size.
+    static bool DecompressInto(std::span<const uint8_t> data, std::span<uint8_t> output) {
+        if (data.empty()) { return false; }
+        uLongf size       = output.size();
+        const auto result = uncompress(output.data(), &size, data.data(), data.size());
+        if (result != Z_OK || size != output.size()) {
+            std::cerr << "Decompression error: " << result << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
 
-        // Attempt to decompress the data
-        int result =
-          uncompress(reinterpret_cast<Bytef*>(decompressedData.data()),  // Destination buffer
-                     &decompressedSize,                                  // Decompressed size
-                     data.data(),                                        // Input data
-                     data.size()                                         // Input size
-          );
+/// @brief LZ4 frames: modest ratios, but decodes at several GB/s. Levels of 3 and above use
+/// the high-compression encoder (LZ4HC), which costs build time only. Frames rather than raw
+/// blocks so payloads can also be decoded incrementally (see StreamDecoder).
+class LZ4 {
+public:
+    static std::optional<std::vector<uint8_t>> Compress(const std::vector<uint8_t>& input,
+                                                        i32 level = 0) {
+        if (input.empty()) { return {}; }
+        const auto preferences = Preferences(input.size(), level);
+        std::vector<uint8_t> compressed(LZ4F_compressFrameBound(input.size(), &preferences));
+        const size_t written = LZ4F_compressFrame(compressed.data(),
+                                                  compressed.size(),
+                                                  input.data(),
+                                                  input.size(),
+                                                  &preferences);
+        if (LZ4F_isError(written)) {
+            std::cerr << "LZ4 error: " << LZ4F_getErrorName(written) << std::endl;
+            return {};
+        }
+        compressed.resize(written);
+        return compressed;
+    }
+
+    /// @brief Decompresses straight into `output`, which must be exactly the original size.
+    static bool DecompressInto(std::span<const uint8_t> data, std::span<uint8_t> output) {
+        if (data.empty()) { return false; }
+        LZ4F_dctx* context = nullptr;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION))) {
+            return false;
+        }
+        // The whole output is in place, so blocks decode into it without a staging copy
+        LZ4F_decompressOptions_t options {};
+        options.stableDst = 1;
+        size_t outputSize = output.size();
+        size_t inputSize  = data.size();
+        const size_t result =
+          LZ4F_decompress(context, output.data(), &outputSize, data.data(), &inputSize, &options);
+        LZ4F_freeDecompressionContext(context);
+        if (LZ4F_isError(result) || result != 0 || outputSize != output.size() ||
+            inputSize != data.size()) {
+            std::cerr << "LZ4 error: "
+                      << (LZ4F_isError(result) ? LZ4F_getErrorName(result) : "size mismatch")
+                      << std::endl;
+            return false;
+        }
+        return true;
+    }
 
-        // If the buffer was too small, resize and retry
-        if (result == Z_BUF_ERROR) {
-            decompressedSize *= 2;  // Double the buffer size and retry
-            decompressedData.resize(decompressedSize);
+private:
+    static LZ4F_preferences_t Preferences(size_t size, i32 level) {
+        LZ4F_preferences_t preferences {};
+        preferences.frameInfo.blockSizeID = LZ4F_max4MB;
+        preferences.frameInfo.blockMode   = LZ4F_blockIndependent;
+        preferences.frameInfo.contentSize = size;
+        preferences.compressionLevel      = level;
+        preferences.favorDecSpeed         = 1;
+        return preferences;
+    }
+};
 
-            result = uncompress(reinterpret_cast<Bytef*>(decompressedData.data()),
-                                &decompressedSize,
-                                data.data(),
-                                data.size());
+/// @brief Zstandard: ratios close to LZMA at high levels while decoding around 1 GB/s.
+/// Decode speed doesn't depend on the level, so build-time content defaults to a high one.
+class Zstd {
+public:
+    static constexpr i32 kDefaultLevel = 19;
+    /// @brief Only this much of each training sample is used; a dictionary mostly captures
+    /// headers and boilerplate, which sit near the start of an asset.
+    static constexpr size_t kMaxSampleSize = 128 * 1024;
+
+    static std::optional<std::vector<uint8_t>> Compress(const std::vector<uint8_t>& input,
+                                                        i32 level = kDefaultLevel) {
+        return CompressWithDictionary(input, {}, level);
+    }
+
+    /// @brief Compresses against `dictionary` (as produced by Train). The frame records the
+    /// dictionary's ID so the decoder can find it.
+    static std::optional<std::vector<uint8_t>>
+    CompressWithDictionary(const std::vector<uint8_t>& input,
+                           std::span<const uint8_t> dictionary,
+                           i32 level = kDefaultLevel) {
+        if (input.empty()) { return {}; }
+        thread_local const std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(
+          ZSTD_createCCtx(),
+          &ZSTD_freeCCtx);
+        std::vector<uint8_t> compressed(ZSTD_compressBound(input.size()));
+        const size_t written = ZSTD_compress_usingDict(context.get(),
+                                                       compressed.data(),
+                                                       compressed.size(),
+                                                       input.data(),
+                                                       input.size(),
+                                                       dictionary.data(),
+                                                       dictionary.size(),
+                                                       std::min(level, ZSTD_maxCLevel()));
+        if (ZSTD_isError(written)) {
+            std::cerr << "Zstd error: " << ZSTD_getErrorName(written) << std::endl;
+            return {};
         }
+        compressed.resize(written);
+        return compressed;
+    }
 
-        // Check if decompression was successful
-        if (result != Z_OK) {
-            throw std::runtime_error("Decompression failed with error code " +
-                                     std::to_string(result));
+    /// @brief Trains a dictionary of at most `capacity` bytes. Fails (returning nullopt) when
+    /// the samples are too few or too small to learn from; zstd wants roughly 100x the
+    /// dictionary size in sample data for good results.
+    static std::optional<std::vector<uint8_t>>
+    Train(const std::vector<std::span<const uint8_t>>& samples, size_t capacity) {
+        std::vector<uint8_t> buffer;
+        std::vector<size_t> sizes;
+        sizes.reserve(samples.size());
+        for (const auto& sample : samples) {
+            const auto used = sample.first(std::min(sample.size(), kMaxSampleSize));
+            buffer.insert(buffer.end(), used.begin(), used.end());
+            sizes.push_back(used.size());
+        }
+        if (sizes.empty() || buffer.empty()) { return {}; }
+
+        std::vector<uint8_t> dictionary(capacity);
+        const size_t size = ZDICT_trainFromBuffer(dictionary.data(),
+                                                  dictionary.size(),
+                                                  buffer.data(),
+                                                  sizes.data(),
+                                                  CAST<unsigned>(sizes.size()));
+        if (ZDICT_isError(size)) { return {}; }
+        dictionary.resize(size);
+        return dictionary;
+    }
+
+    /// @brief Decompresses straight into `output`, which must be exactly the original size.
+    /// Frames compressed against a dictionary need its digested form in `dictionary`.
+    static bool DecompressInto(std::span<const uint8_t> data,
+                               std::span<uint8_t> output,
+                               const ZSTD_DDict* dictionary = nullptr) {
+        if (data.empty()) { return false; }
+        // Reusing a context per thread skips re-initializing its tables for every asset
+        thread_local const std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(
+          ZSTD_createDCtx(),
+          &ZSTD_freeDCtx);
+        const size_t written = ZSTD_decompress_usingDDict(context.get(),
+                                                          output.data(),
+                                                          output.size(),
+                                                          data.data(),
+                                                          data.size(),
+                                                          dictionary);
+        if (ZSTD_isError(written) || written != output.size()) {
+            std::cerr << "Zstd error: "
+                      << (ZSTD_isError(written) ? ZSTD_getErrorName(written) : "size mismatch")
+                      << std::endl;
+            return false;
         }
+        return true;
+    }
+};
+
+/// @brief A trained Zstd dictionary, digested once for decoding. Read-only after construction,
+/// so any number of threads can decode against it.
+class ZstdDictionary {
+public:
+    explicit ZstdDictionary(std::span<const uint8_t> data)
+        : mDictionary(ZSTD_createDDict(data.data(), data.size())),
+          mId(ZSTD_getDictID_fromDict(data.data(), data.size())) {}
+
+    ~ZstdDictionary() {
+        ZSTD_freeDDict(mDictionary);
+    }
 
-        return decompressedData;
+    ZstdDictionary(const ZstdDictionary&)            = delete;
+    ZstdDictionary& operator=(const ZstdDictionary&) = delete;
+
+    /// @brief False for data that isn't a trained dictionary; raw content has no ID.
+    [[nodiscard]] bool IsValid() const {
+        return mDictionary != nullptr && mId != 0;
+    }
+
+    [[nodiscard]] u32 GetId() const {
+        return mId;
+    }
+
+    [[nodiscard]] const ZSTD_DDict* Get() const {
+        return mDictionary;
+    }
+
+private:
+    ZSTD_DDict* mDictionary;
+    u32 mId;
+};
+
+/// @brief Dictionaries available to the decoder, keyed by the ID Zstd writes into each frame.
+/// Thread-safe.
+class DictionarySet {
+public:
+    bool Add(std::span<const uint8_t> data) {
+        auto dictionary = std::make_shared<const ZstdDictionary>(data);
+        if (!dictionary->IsValid()) { return false; }
+        std::unique_lock lock(mMutex);
+        mDictionaries.insert_or_assign(dictionary->GetId(), std::move(dictionary));
+        return true;
+    }
+
+    /// @brief The dictionary `frame` was compressed against, if it is loaded.
+    [[nodiscard]] Shared<const ZstdDictionary> Find(std::span<const uint8_t> frame) const {
+        const u32 id = ZSTD_getDictID_fromFrame(frame.data(), frame.size());
+        std::shared_lock lock(mMutex);
+        const auto it = mDictionaries.find(id);
+        return it != mDictionaries.end() ? it->second : nullptr;
+    }
+
+    [[nodiscard]] size_t Size() const {
+        std::shared_lock lock(mMutex);
+        return mDictionaries.size();
+    }
+
+private:
+    mutable std::shared_mutex mMutex;
+    std::unordered_map<u32, Shared<const ZstdDictionary>> mDictionaries;
+};
+
+/// @brief Incremental decoder for any codec: feed compressed chunks in order and each call
+/// decodes as far as it can into `output`, which must be exactly the original size. The output
+/// is never reallocated and no input is buffered, so reading a pak through a fixed-size chunk
+/// holds at most one chunk on top of the decoded asset. Zstd keeps one window-sized buffer,
+/// allocated with the first chunk. ZstdDict input is matched against `dictionaries` by the
+/// dictionary ID in the frame header, so the first chunk must hold the whole header.
+class StreamDecoder {
+public:
+    StreamDecoder(Codec codec,
+                  std::span<uint8_t> output,
+                  const DictionarySet* dictionaries = nullptr)
+        : mCodec(codec), mOutput(output), mDictionaries(dictionaries) {
+        switch (mCodec) {
+            case Codec::None:
+                break;
+            case Codec::LZMA:
+                mFailed = lzma_auto_decoder(&mLzma, UINT64_MAX, 0) != LZMA_OK;
+                break;
+            case Codec::GZip:
+                mFailed = inflateInit(&mZlib) != Z_OK;
+                break;
+            case Codec::LZ4:
+                mFailed =
+                  LZ4F_isError(LZ4F_createDecompressionContext(&mLz4, LZ4F_VERSION)) != 0;
+                break;
+            case Codec::Zstd:
+            case Codec::ZstdDict:
+                mZstd   = ZSTD_createDCtx();
+                mFailed = mZstd == nullptr || (mCodec == Codec::ZstdDict && !mDictionaries);
+                break;
+            default:
+                mFailed = true;
+                break;
+        }
+    }
+
+    ~StreamDecoder() {
+        switch (mCodec) {
+            case Codec::LZMA:
+                lzma_end(&mLzma);
+                break;
+            case Codec::GZip:
+                inflateEnd(&mZlib);
+                break;
+            case Codec::LZ4:
+                LZ4F_freeDecompressionContext(mLz4);
+                break;
+            case Codec::Zstd:
+            case Codec::ZstdDict:
+                ZSTD_freeDCtx(mZstd);
+                break;
+            default:
+                break;
+        }
+    }
+
+    StreamDecoder(const StreamDecoder&)            = delete;
+    StreamDecoder& operator=(const StreamDecoder&) = delete;
+
+    /// @brief Decodes the next chunk of compressed input. Returns the output it produced, or
+    /// nullopt once the data turns out corrupt, overruns the output or continues past its end.
+    std::optional<std::span<const uint8_t>> Feed(std::span<const uint8_t> input) {
+        const size_t start = mProduced;
+        if (!mFailed && !input.empty()) {
+            mFailed = mFinished || !Decode(input);
+            if (mFinished && mProduced != mOutput.size()) { mFailed = true; }
+        }
+        if (mFailed) { return std::nullopt; }
+        return std::span<const uint8_t>(mOutput.data() + start, mProduced - start);
+    }
+
+    /// @brief True once the stream has ended with the output exactly filled.
+    [[nodiscard]] bool Finished() const {
+        return mFinished && !mFailed;
+    }
+
+    [[nodiscard]] size_t Produced() const {
+        return mProduced;
+    }
+
+private:
+    Codec mCodec;
+    std::span<uint8_t> mOutput;
+    const DictionarySet* mDictionaries;
+    Shared<const ZstdDictionary> mDictionary;  // Referenced by mZstd
+    size_t mProduced  = 0;
+    bool mFinished    = false;
+    bool mFailed      = false;
+    lzma_stream mLzma = LZMA_STREAM_INIT;
+    z_stream mZlib    = {};
+    LZ4F_dctx* mLz4   = nullptr;
+    ZSTD_DCtx* mZstd  = nullptr;
+
+    /// @brief Consumes all of `input` unless the stream ends or fails first; trailing input
+    /// after the end counts as failure.
+    bool Decode(std::span<const uint8_t> input) {
+        uint8_t* out           = mOutput.data() + mProduced;
+        const size_t available = mOutput.size() - mProduced;
+        switch (mCodec) {
+            case Codec::None: {
+                if (input.size() > available) { return false; }
+                std::ranges::copy(input, out);
+                mProduced += input.size();
+                mFinished = mProduced == mOutput.size();
+                return true;
+            }
+            case Codec::LZMA: {
+                mLzma.next_in   = input.data();
+                mLzma.avail_in  = input.size();
+                mLzma.next_out  = out;
+                mLzma.avail_out = available;
+                lzma_ret ret    = LZMA_OK;
+                // liblzma reports LZMA_BUF_ERROR once it can make no progress, ending the loop
+                while (mLzma.avail_in > 0 && ret == LZMA_OK) {
+                    ret = lzma_code(&mLzma, LZMA_RUN);
+                }
+                mProduced += available - mLzma.avail_out;
+                mFinished = ret == LZMA_STREAM_END;
+                return (ret == LZMA_OK || mFinished) && mLzma.avail_in == 0;
+            }
+            case Codec::GZip: {
+                // z_stream counts are 32-bit, so larger chunks go in pieces
+                while (!input.empty() && !mFinished) {
+                    const auto piece   = input.first(std::min<size_t>(input.size(), UINT32_MAX));
+                    const size_t space = std::min<size_t>(mOutput.size() - mProduced, UINT32_MAX);
+                    mZlib.next_in      = CCAST<Bytef*>(piece.data());
+                    mZlib.avail_in     = CAST<uInt>(piece.size());
+                    mZlib.next_out     = mOutput.data() + mProduced;
+                    mZlib.avail_out    = CAST<uInt>(space);
+                    const int ret      = inflate(&mZlib, Z_NO_FLUSH);
+                    mProduced += space - mZlib.avail_out;
+                    input = input.subspan(piece.size() - mZlib.avail_in);
+                    if (ret == Z_STREAM_END) {
+                        mFinished = true;
+                    } else if (ret != Z_OK) {
+                        return false;  // Z_BUF_ERROR here means the output is full
+                    }
+                }
+                return input.empty();
+            }
+            case Codec::LZ4: {
+                LZ4F_decompressOptions_t options {};
+                options.stableDst = 1;
+                while (!input.empty() && !mFinished) {
+                    size_t outputSize = mOutput.size() - mProduced;
+                    size_t inputSize  = input.size();
+                    const size_t hint = LZ4F_decompress(mLz4,
+                                                        mOutput.data() + mProduced,
+                                                        &outputSize,
+                                                        input.data(),
+                                                        &inputSize,
+                                                        &options);
+                    if (LZ4F_isError(hint) || (inputSize == 0 && outputSize == 0)) {
+                        return false;
+                    }
+                    mProduced += outputSize;
+                    input     = input.subspan(inputSize);
+                    mFinished = hint == 0;
+                }
+                return input.empty();
+            }
+            case Codec::ZstdDict:
+                if (!mDictionary) {
+                    mDictionary = mDictionaries->Find(input);
+                    if (!mDictionary) { return false; }
+                    if (ZSTD_isError(ZSTD_DCtx_refDDict(mZstd, mDictionary->Get()))) {
+                        return false;
+                    }
+                }
+                [[fallthrough]];
+            case Codec::Zstd: {
+                ZSTD_inBuffer in {input.data(), input.size(), 0};
+                ZSTD_outBuffer outBuffer {mOutput.data(), mOutput.size(), mProduced};
+                while (in.pos < in.size && !mFinished) {
+                    const size_t before = in.pos + outBuffer.pos;
+                    const size_t hint   = ZSTD_decompressStream(mZstd, &outBuffer, &in);
+                    if (ZSTD_isError(hint)) { return false; }
+                    mFinished = hint == 0;
+                    if (!mFinished && in.pos + outBuffer.pos == before) { return false; }
+                }
+                mProduced = outBuffer.pos;
+                return in.pos == in.size;
+            }
+            default:
+                return false;
+        }
+    }
+};
+
+namespace Codecs {
+    static str ToString(Codec codec) {
+        switch (codec) {
+            case Codec::LZMA:
+                return "lzma";
+            case Codec::GZip:
+                return "gzip";
+            case Codec::LZ4:
+                return "lz4";
+            case Codec::Zstd:
+                return "zstd";
+            case Codec::ZstdDict:
+                return "zstd-dict";
+            case Codec::None:
+            default:
+                return "none";
+        }
+    }
+
+    static bool IsValid(u8 value) {
+        return value <= CAST<u8>(Codec::ZstdDict);
+    }
+
+    /// @brief Parses "<codec>" or "<codec>:<level>", e.g. "lz4", "zstd:19" or "lzma:6".
+    static std::optional<CodecSettings> FromString(const str& value) {
+        const auto separator = value.find(':');
+        const str name       = value.substr(0, separator);
+        CodecSettings settings;
+        for (u8 id = 0; IsValid(id); ++id) {
+            if (ToString(CAST<Codec>(id)) == name) { settings.Type = CAST<Codec>(id); }
+        }
+        if (settings.Type == Codec::None && name != "none") { return std::nullopt; }
+        if (separator != str::npos) {
+            try {
+                settings.Level = std::stoi(value.substr(separator + 1));
+            } catch (const std::exception&) { return std::nullopt; }
+        }
+        return settings;
+    }
+
+    /// @brief ZstdDict needs the category's trained `dictionary`; other codecs ignore it. LZMA
+    /// encodes on up to `threads` threads (0 = every core); the output is the same either way.
+    static std::optional<std::vector<uint8_t>> Compress(const std::vector<uint8_t>& data,
+                                                        const CodecSettings& settings,
+                                                        std::span<const uint8_t> dictionary = {},
+                                                        u32 threads                         = 0) {
+        const i32 level = settings.Level;
+        switch (settings.Type) {
+            case Codec::LZMA:
+                return LZMA::Compress(data, threads, level > 0 ? level : 0);
+            case Codec::GZip:
+                return GZip::Compress(data, level > 0 ? level : Z_DEFAULT_COMPRESSION);
+            case Codec::LZ4:
+                return LZ4::Compress(data, level);
+            case Codec::Zstd:
+                return Zstd::Compress(data, level != 0 ? level : Zstd::kDefaultLevel);
+            case Codec::ZstdDict:
+                if (dictionary.empty()) { return {}; }
+                return Zstd::CompressWithDictionary(data,
+                                                    dictionary,
+                                                    level != 0 ? level : Zstd::kDefaultLevel);
+            case Codec::None:
+            default:
+                return data;
+        }
+    }
+
+    /// @brief Decodes `data` into `output`, which must be exactly the original size. ZstdDict
+    /// data is decoded against its dictionary from `dictionaries`. Multi-block LZMA data is
+    /// decoded on up to `threads` threads (0 = every core).
+    static bool DecompressInto(Codec codec,
+                               std::span<const uint8_t> data,
+                               std::span<uint8_t> output,
+                               const DictionarySet* dictionaries = nullptr,
+                               u32 threads                       = 0) {
+        switch (codec) {
+            case Codec::None:
+                if (data.size() != output.size()) { return false; }
+                std::ranges::copy(data, output.begin());
+                return true;
+            case Codec::LZMA:
+                return LZMA::DecompressInto(data, output, threads);
+            case Codec::GZip:
+                return GZip::DecompressInto(data, output);
+            case Codec::LZ4:
+                return LZ4::DecompressInto(data, output);
+            case Codec::Zstd:
+                return Zstd::DecompressInto(data, output);
+            case Codec::ZstdDict: {
+                const auto dictionary = dictionaries ? dictionaries->Find(data) : nullptr;
+                if (!dictionary) {
+                    std::cerr << "Zstd error: dictionary not loaded" << std::endl;
+                    return false;
+                }
+                return Zstd::DecompressInto(data, output, dictionary->Get());
+            }
+        }
+        return false;
     }
-};
\ No newline at end of file
+}  // namespace Codecs
@@ -0,0 +1,51 @@
+// Author: Jake Rieger
+// Created: 12/3/2024.
+//
+
+#pragma once
+
+#include "Types.hpp"
+
+// Font Asset Structure (produced by XPak, consumed by Xen::Font)
+//
+// +-----------------+-----------------------------------+
+// | Name            | Size                              |
+// +-----------------+-----------------------------------+
+// | FontHeader      | sizeof(FontHeader)                |
+// +-----------------+-----------------------------------+
+// | GlyphMetrics[]  | GlyphCount * sizeof(GlyphMetrics) |
+// +-----------------+-----------------------------------+
+// | Atlas (R8)      | AtlasWidth * AtlasHeight          |
+// +-----------------+-----------------------------------+
+//
+// All metrics are in pixels at FontHeader::Size. The atlas stores a signed distance field where
+// 128 is the glyph edge and FontHeader::Spread pixels map to the full [0, 255] range. Rows are
+// stored bottom-up so the atlas can be uploaded to OpenGL as-is.
+namespace FontFormat {
+    static constexpr char kMagic[4] = {'X', 'F', 'N', 'T'};
+
+    struct FontHeader {
+        char Magic[4];
+        u32 GlyphCount;
+        u32 AtlasWidth;
+        u32 AtlasHeight;
+        f32 Size;
+        f32 Spread;
+        f32 LineHeight;
+        f32 Ascender;
+        f32 Descender;
+    };
+
+    struct GlyphMetrics {
+        u32 Codepoint;
+        f32 Advance;
+        f32 OffsetX;  // Left edge of the quad relative to the pen position
+        f32 OffsetY;  // Top edge of the quad relative to the baseline (+Y up)
+        f32 Width;
+        f32 Height;
+        f32 U0, V0, U1, V1;
+    };
+
+    static_assert(sizeof(FontHeader) == 36);
+    static_assert(sizeof(GlyphMetrics) == 40);
+}  // namespace FontFormat
@@ -0,0 +1,122 @@
+// Author: Jake Rieger
+// Created: 12/6/2024.
+//
+
+#pragma once
+
+#include "Types.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+/// @brief Read-only memory mapping of a whole file. Move-only; the mapping lives until the
+/// object is destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Close();
+            mData = std::exchange(other.mData, nullptr);
+            mSize = std::exchange(other.mSize, 0);
+#ifdef _WIN32
+            mFile    = std::exchange(other.mFile, INVALID_HANDLE_VALUE);
+            mMapping = std::exchange(other.mMapping, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        Close();
+    }
+
+    static std::optional<MappedFile> Open(const std::filesystem::path& filename) {
+        MappedFile file;
+#ifdef _WIN32
+        file.mFile = CreateFileW(filename.c_str(),
+                                 GENERIC_READ,
+                                 FILE_SHARE_READ,
+                                 nullptr,
+                                 OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL,
+                                 nullptr);
+        if (file.mFile == INVALID_HANDLE_VALUE) { return std::nullopt; }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file.mFile, &size) || size.QuadPart == 0) { return std::nullopt; }
+        file.mMapping = CreateFileMappingW(file.mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!file.mMapping) { return std::nullopt; }
+        file.mData = MapViewOfFile(file.mMapping, FILE_MAP_READ, 0, 0, 0);
+        if (!file.mData) { return std::nullopt; }
+        file.mSize = CAST<size_t>(size.QuadPart);
+#else
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) { return std::nullopt; }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return std::nullopt;
+        }
+        void* data = mmap(nullptr, CAST<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);  // The mapping keeps its own reference to the file
+        if (data == MAP_FAILED) { return std::nullopt; }
+        file.mData = data;
+        file.mSize = CAST<size_t>(info.st_size);
+#endif
+        return file;
+    }
+
+    [[nodiscard]] const u8* Data() const {
+        return CAST<const u8*>(mData);
+    }
+
+    [[nodiscard]] size_t Size() const {
+        return mSize;
+    }
+
+private:
+    void* mData  = nullptr;
+    size_t mSize = 0;
+#ifdef _WIN32
+    HANDLE mFile    = INVALID_HANDLE_VALUE;
+    HANDLE mMapping = nullptr;
+#endif
+
+    void Close() {
+#ifdef _WIN32
+        if (mData) { UnmapViewOfFile(mData); }
+        if (mMapping) { CloseHandle(mMapping); }
+        if (mFile != INVALID_HANDLE_VALUE) { CloseHandle(mFile); }
+        mFile    = INVALID_HANDLE_VALUE;
+        mMapping = nullptr;
+#else
+        if (mData) { munmap(mData, mSize); }
+#endif
+        mData = nullptr;
+        mSize = 0;
+    }
+};
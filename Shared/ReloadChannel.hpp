@@ -0,0 +1,227 @@
+// Author: Jake Rieger
+// Created: 12/10/2024.
+//
+
+#pragma once
+
+#include "Types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <WinSock2.h>
+#else
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <sys/select.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+/// @brief Loopback UDP socket over which `XPak watch` tells running games which assets it just
+/// rebuilt and where. Games subscribe by sending a datagram to the watcher's port every second
+/// or so, and the watcher sends each batch of rebuilt names to every game it heard from
+/// recently. Either side can start first; a game that exits simply stops being sent to.
+///
+/// A datagram is "XRLD", a one-byte Message and, for reloads, lines separated by '\n': the
+/// absolute directory holding the rebuilt loose files, then the asset names. Games usually run
+/// from a copy of the content, so the directory is what lets them read the new files. Batches
+/// longer than kMaxBatchSize are split over several datagrams, each naming the directory.
+/// Move-only.
+class ReloadChannel {
+public:
+    static constexpr u16 kDefaultPort     = 47250;
+    static constexpr size_t kMaxBatchSize = 8192;
+
+    enum class Message : u8 {
+        Subscribe,
+        Reload,
+    };
+
+    struct Datagram {
+        Message Kind;
+        u16 From;       // Port of the sender
+        str Directory;  // Where the rebuilt files are; reloads only
+        std::vector<str> Names;
+    };
+
+    ReloadChannel() = default;
+
+    ReloadChannel(ReloadChannel&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    ReloadChannel& operator=(ReloadChannel&& other) noexcept {
+        if (this != &other) {
+            Close();
+            mSocket = std::exchange(other.mSocket, kInvalidSocket);
+            mPort   = std::exchange(other.mPort, 0);
+        }
+        return *this;
+    }
+
+    ReloadChannel(const ReloadChannel&)            = delete;
+    ReloadChannel& operator=(const ReloadChannel&) = delete;
+
+    ~ReloadChannel() {
+        Close();
+    }
+
+    /// @brief Binds 127.0.0.1:`port`; 0 picks a free port. Empty if the socket can't be opened
+    /// or the port is taken.
+    static std::optional<ReloadChannel> Open(u16 port = 0) {
+#ifdef _WIN32
+        static const bool started = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if (!started) { return std::nullopt; }
+#endif
+        ReloadChannel channel;
+        channel.mSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (channel.mSocket == kInvalidSocket) { return std::nullopt; }
+
+        auto address = GetAddress(port);
+        if (bind(channel.mSocket, RCAST<const sockaddr*>(&address), sizeof(address)) != 0) {
+            return std::nullopt;
+        }
+        socklen_t length = sizeof(address);
+        if (getsockname(channel.mSocket, RCAST<sockaddr*>(&address), &length) != 0) {
+            return std::nullopt;
+        }
+        channel.mPort = ntohs(address.sin_port);
+        return channel;
+    }
+
+    [[nodiscard]] u16 GetPort() const {
+        return mPort;
+    }
+
+    bool Subscribe(u16 port) const {
+        const auto header = GetHeader(Message::Subscribe);
+        return SendTo(port, header.data(), header.size());
+    }
+
+    /// @brief Tells whoever listens on `port` to reload `names` from the loose files in
+    /// `directory`.
+    bool SendReload(u16 port, const str& directory, const std::vector<str>& names) const {
+        auto datagram = GetHeader(Message::Reload);
+        datagram.insert(datagram.end(), directory.begin(), directory.end());
+        const size_t start = datagram.size();
+        bool sent          = true;
+        for (const auto& name : names) {
+            if (datagram.size() > start && datagram.size() + 1 + name.size() > kMaxBatchSize) {
+                sent &= SendTo(port, datagram.data(), datagram.size());
+                datagram.resize(start);
+            }
+            datagram.push_back('\n');
+            datagram.insert(datagram.end(), name.begin(), name.end());
+        }
+        if (datagram.size() > start) { sent &= SendTo(port, datagram.data(), datagram.size()); }
+        return sent;
+    }
+
+    /// @brief Waits up to `timeout` for a datagram. Empty on timeout or when what arrived isn't
+    /// one of ours.
+    [[nodiscard]] std::optional<Datagram> Receive(std::chrono::milliseconds timeout) const {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(mSocket, &readable);
+        timeval wait {};
+        wait.tv_sec  = CAST<decltype(wait.tv_sec)>(timeout.count() / 1000);
+        wait.tv_usec = CAST<decltype(wait.tv_usec)>(timeout.count() % 1000 * 1000);
+        if (select(CAST<int>(mSocket) + 1, &readable, nullptr, nullptr, &wait) <= 0) {
+            return std::nullopt;
+        }
+
+        thread_local std::vector<char> buffer(kMaxDatagramSize);
+        sockaddr_in from {};
+        socklen_t fromLength = sizeof(from);
+        const auto received  = recvfrom(mSocket,
+                                        buffer.data(),
+                                        CAST<int>(buffer.size()),
+                                        0,
+                                        RCAST<sockaddr*>(&from),
+                                        &fromLength);
+        if (received < 0 || CAST<size_t>(received) < kHeaderSize ||
+            memcmp(buffer.data(), kMagic, 4) != 0 ||
+            buffer[4] > CAST<char>(Message::Reload)) {
+            return std::nullopt;
+        }
+
+        Datagram datagram {CAST<Message>(buffer[4]), ntohs(from.sin_port), {}, {}};
+        const std::string_view body(buffer.data() + kHeaderSize,
+                                    CAST<size_t>(received) - kHeaderSize);
+        const auto directoryEnd = std::min(body.find('\n'), body.size());
+        datagram.Directory      = body.substr(0, directoryEnd);
+        for (size_t start = directoryEnd + 1; start < body.size();) {
+            const auto end = std::min(body.find('\n', start), body.size());
+            if (end > start) { datagram.Names.emplace_back(body.substr(start, end - start)); }
+            start = end + 1;
+        }
+        return datagram;
+    }
+
+private:
+#ifdef _WIN32
+    using Socket                           = SOCKET;
+    using socklen_t                        = int;
+    static constexpr Socket kInvalidSocket = INVALID_SOCKET;
+#else
+    using Socket                           = int;
+    static constexpr Socket kInvalidSocket = -1;
+#endif
+    static constexpr char kMagic[4]          = {'X', 'R', 'L', 'D'};
+    static constexpr size_t kHeaderSize      = 5;
+    static constexpr size_t kMaxDatagramSize = 65536;
+
+    Socket mSocket = kInvalidSocket;
+    u16 mPort      = 0;
+
+    static sockaddr_in GetAddress(u16 port) {
+        sockaddr_in address {};
+        address.sin_family      = AF_INET;
+        address.sin_port        = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    static std::vector<char> GetHeader(Message kind) {
+        std::vector<char> header(kMagic, kMagic + 4);
+        header.push_back(CAST<char>(kind));
+        return header;
+    }
+
+    bool SendTo(u16 port, const char* data, size_t size) const {
+        const auto address = GetAddress(port);
+        return sendto(mSocket,
+                      data,
+                      CAST<int>(size),
+                      0,
+                      RCAST<const sockaddr*>(&address),
+                      sizeof(address)) == CAST<int>(size);
+    }
+
+    void Close() {
+        if (mSocket == kInvalidSocket) { return; }
+#ifdef _WIN32
+        closesocket(mSocket);
+#else
+        close(mSocket);
+#endif
+        mSocket = kInvalidSocket;
+        mPort   = 0;
+    }
+};
@@ -0,0 +1,124 @@
+// Author: Jake Rieger
+// Created: 12/5/2024.
+//
+
+#pragma once
+
+#include "Types.hpp"
+
+#include <algorithm>
+#include <optional>
+
+// Texture payloads (produced by XPak, consumed by Xen::Texture) store every mip level back to
+// back, largest first, bottom row first, rows tightly packed. Block-compressed levels are stored
+// as rows of 4x4 blocks; levels smaller than a block still occupy one whole block.
+//
+// R8 and RG8 hold grayscale and grayscale + alpha; the loader swizzles them so shaders sample the
+// same RGBA they would from the RGBA8 source. 16-bit formats are little-endian u16s in GL's
+// packed layout (red in the high bits).
+enum class TextureFormat : u8 {
+    RGBA8,
+    R8,        // Gray
+    RG8,       // Gray + alpha
+    RGB565,    // Opaque color, 2 bytes per texel
+    RGBA4444,  // Color + alpha, 2 bytes per texel
+    BC1,       // RGB + 1-bit alpha, 8 bytes per block
+    BC3,       // RGBA with interpolated alpha, 16 bytes per block
+    BC7,       // RGBA, 16 bytes per block
+};
+
+namespace TextureFormats {
+    static std::optional<TextureFormat> FromString(const str& name) {
+        if (name == "RGBA8") { return TextureFormat::RGBA8; }
+        if (name == "R8") { return TextureFormat::R8; }
+        if (name == "RG8") { return TextureFormat::RG8; }
+        if (name == "RGB565") { return TextureFormat::RGB565; }
+        if (name == "RGBA4444") { return TextureFormat::RGBA4444; }
+        if (name == "BC1") { return TextureFormat::BC1; }
+        if (name == "BC3") { return TextureFormat::BC3; }
+        if (name == "BC7") { return TextureFormat::BC7; }
+        return std::nullopt;
+    }
+
+    static str ToString(TextureFormat format) {
+        switch (format) {
+            case TextureFormat::R8:
+                return "R8";
+            case TextureFormat::RG8:
+                return "RG8";
+            case TextureFormat::RGB565:
+                return "RGB565";
+            case TextureFormat::RGBA4444:
+                return "RGBA4444";
+            case TextureFormat::BC1:
+                return "BC1";
+            case TextureFormat::BC3:
+                return "BC3";
+            case TextureFormat::BC7:
+                return "BC7";
+            case TextureFormat::RGBA8:
+            default:
+                return "RGBA8";
+        }
+    }
+
+    static bool IsBlockCompressed(TextureFormat format) {
+        return format == TextureFormat::BC1 || format == TextureFormat::BC3 ||
+               format == TextureFormat::BC7;
+    }
+
+    static bool HasAlpha(TextureFormat format) {
+        return format != TextureFormat::R8 && format != TextureFormat::RGB565;
+    }
+
+    static u32 GetChannelCount(TextureFormat format) {
+        switch (format) {
+            case TextureFormat::R8:
+                return 1;
+            case TextureFormat::RG8:
+                return 2;
+            case TextureFormat::RGB565:
+                return 3;
+            default:
+                return 4;
+        }
+    }
+
+    /// @brief Bytes per 4x4 block for compressed formats, bytes per texel otherwise.
+    static u32 GetUnitSize(TextureFormat format) {
+        switch (format) {
+            case TextureFormat::R8:
+                return 1;
+            case TextureFormat::RG8:
+            case TextureFormat::RGB565:
+            case TextureFormat::RGBA4444:
+                return 2;
+            case TextureFormat::BC1:
+                return 8;
+            case TextureFormat::BC3:
+            case TextureFormat::BC7:
+                return 16;
+            case TextureFormat::RGBA8:
+            default:
+                return 4;
+        }
+    }
+
+    static size_t GetLevelSize(TextureFormat format, u32 width, u32 height) {
+        if (IsBlockCompressed(format)) {
+            width  = (width + 3) / 4;
+            height = (height + 3) / 4;
+        }
+        return CAST<size_t>(width) * height * GetUnitSize(format);
+    }
+
+    static size_t GetChainSize(TextureFormat format, u32 width, u32 height, u32 levels) {
+        size_t size = 0;
+        for (u32 level = 0; level < std::max(levels, 1u); ++level) {
+            size += GetLevelSize(format, width, height);
+            width  = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+        return size;
+    }
+}  // namespace TextureFormats
@@ -5,84 +5,840 @@
 #include "ContentManager.hpp"
 
 #include <fstream>
+#include <ArchiveFormat.hpp>
 #include <Compression.hpp>
 #include <cstring>
-#include <Expect.hpp>
+#include <IO.hpp>
+#include <MappedFile.hpp>
+#include <Panic.hpp>
+#include <algorithm>
+#include <array>
 #include <pugixml.hpp>
+#include <ranges>
+#include <ReloadChannel.hpp>
 
 namespace Xen {
-    std::optional<Shared<Asset>> ContentManager::LoadAsset(const str& name) {
+    /// @brief Compressed loose paks are read through a buffer this size, so decoding one never
+    /// holds more than the asset plus one chunk.
+    static constexpr size_t kStreamChunkSize = 64 * 1024;
+    /// @brief How often a hot-reloading game tells the watcher it is still running.
+    static constexpr auto kSubscribeInterval = std::chrono::seconds(1);
+    /// @brief How long the reload listener waits for a notification before checking whether
+    /// the manager is stopping; also the most destruction waits on it.
+    static constexpr auto kReloadPollInterval = std::chrono::milliseconds(100);
+
+    struct LoadRequest {
+        str Name;
+        std::promise<AssetResult> Promise;
+        std::shared_future<AssetResult> Future;
+        std::atomic<u32> Interested = 0;  // Handles that haven't cancelled
+        // Guarded by ContentManager::mMutex until the request finishes
+        LoadPriority Priority = LoadPriority::Low;
+        u64 Epoch             = 0;  // Bumped on every (re)queue; 0 if never queued
+        bool Started          = false;
+        std::vector<Shared<LoadTicket>> Tickets;  // Those with callbacks, cleared once delivered
+
+        explicit LoadRequest(str name)
+            : Name(std::move(name)), Future(Promise.get_future().share()) {}
+    };
+
+    struct LoadTicket {
+        Shared<LoadRequest> Request;
+        AssetCallback Callback;
+        std::atomic<bool> Cancelled = false;
+
+        LoadTicket(Shared<LoadRequest> request, AssetCallback callback)
+            : Request(std::move(request)), Callback(std::move(callback)) {}
+    };
+
+    /// @brief Asset types whose payload is only needed until it reaches the GPU.
+    static bool IsGpuResident(const Asset& asset) {
+        const auto type = asset.Metadata.find("type");
+        if (type == asset.Metadata.end()) { return false; }
+        return type->second == "Texture" || type->second == "Atlas" || type->second == "Font";
+    }
+
+    std::span<const u8> Asset::GetData() const {
+        std::lock_guard lock(mMutex);
+        if (mReleased) {
+            auto data = mReload();
+            if (!data) {
+                std::cout << "Unable to reload asset: " << Name << std::endl;
+                return {};
+            }
+            mStorage  = std::make_shared<const std::vector<u8>>(std::move(*data));
+            mData     = *mStorage;
+            mReleased = false;
+            // Someone is reading it on the CPU again; keep it until it is uploaded again
+            mUploaded = false;
+        }
+        return mData;
+    }
+
+    size_t Asset::GetResidentSize() const {
+        std::lock_guard lock(mMutex);
+        return mData.size();
+    }
+
+    void Asset::OnUploaded() const {
+        std::lock_guard lock(mMutex);
+        mUploaded = true;
+    }
+
+    void Asset::ReleaseIfUploaded() const {
+        std::lock_guard lock(mMutex);
+        if (!mUploaded || mReleased || !mReload || mOwner) { return; }
+        mStorage.reset();  // Freed once nothing sharing it holds it either
+        mData     = {};
+        mReleased = true;
+    }
+
+    Shared<Asset> Asset::Share(str name, std::unordered_map<str, str> metadata) const {
+        std::lock_guard lock(mMutex);
+        if (mReleased) { return nullptr; }
+        auto asset =
+          std::make_shared<Asset>(std::move(name), mData, mOwner, std::move(metadata));
+        asset->mStorage = mStorage;
+        asset->mReload  = mReload;
+        asset->mShared  = true;
+        return asset;
+    }
+
+    bool AssetHandle::IsValid() const {
+        return mTicket != nullptr;
+    }
+
+    bool AssetHandle::IsReady() const {
+        if (!mTicket || mTicket->Cancelled) { return true; }
+        const auto& future = mTicket->Request->Future;
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    AssetResult AssetHandle::Get() const {
+        if (!mTicket || mTicket->Cancelled) { return {}; }
+        return mTicket->Request->Future.get();
+    }
+
+    void AssetHandle::Cancel() const {
+        if (mTicket && !mTicket->Cancelled.exchange(true)) { --mTicket->Request->Interested; }
+    }
+
+    struct ContentManager::MountedArchive {
+        Shared<MappedFile> File;  // Shared with assets that view it
+        const ArchiveFormat::ArchiveEntry* Entries;
+        u32 EntryCount;
+        const u8* Metadata;
+        u64 MetadataSize;
+    };
+
+    ContentManager::ContentManager(const std::filesystem::path& contentRoot, u32 workerCount) {
+        this->mContentRoot = contentRoot;
+        // Leave a core for the main thread; loads are mostly I/O and decompression, which don't
+        // scale much past a handful of threads
+        this->mWorkerCount =
+          workerCount ? workerCount : std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+        this->mStats.Budget = kDefaultBudget;
+        this->mDictionaries = std::make_shared<DictionarySet>();
+
+        LoadDictionaries(contentRoot);
+        std::error_code error;
+        std::vector<std::filesystem::path> archives;
+        for (const auto& entry : std::filesystem::directory_iterator(contentRoot, error)) {
+            if (entry.path().extension() == ".xpak") { archives.push_back(entry.path()); }
+        }
+        std::ranges::sort(archives);
+        for (const auto& archive : archives) {
+            if (!Mount(archive)) {
+                std::cout << "Unable to mount archive: " << archive.string() << std::endl;
+            }
+        }
+    }
+
+    Shared<ContentManager> ContentManager::GetShared(const std::filesystem::path& contentRoot) {
+        static std::mutex mutex;
+        static std::unordered_map<str, Shared<ContentManager>> managers;
+
+        std::lock_guard lock(mutex);
+        const auto key = std::filesystem::absolute(contentRoot).lexically_normal().string();
+        auto& manager  = managers[key];
+        if (!manager) { manager = std::make_shared<ContentManager>(contentRoot); }
+        return manager;
+    }
+
+    ContentManager::~ContentManager() {
+        {
+            std::lock_guard lock(mMutex);
+            mStopping = true;
+            // Nothing is left to serve the queue; resolve it so waiting handles don't hang
+            for (; !mQueue.empty(); mQueue.pop()) {
+                const auto& request = mQueue.top().Request;
+                if (request->Started) { continue; }
+                request->Started = true;
+                request->Tickets.clear();
+                request->Promise.set_value({});
+            }
+        }
+        mQueueCondition.notify_all();
+        for (auto& worker : mWorkers) {
+            worker.join();
+        }
+        if (mReloadThread.joinable()) { mReloadThread.join(); }
+        // Tickets point back at their requests
+        for (const auto& request : mFinished) {
+            request->Tickets.clear();
+        }
+    }
+
+    AssetResult ContentManager::LoadAsset(const str& name) {
+        std::unique_lock lock(mMutex);
+        if (auto cached = FindCached(name)) { return cached; }
+
+        auto& slot = mInFlight[name];
+        if (!slot) { slot = std::make_shared<LoadRequest>(name); }
+        const auto request = slot;
+        if (request->Started) {
+            lock.unlock();
+            return request->Future.get();
+        }
+        // Take over a queued request; its queue entry is skipped when popped
+        request->Started = true;
+        lock.unlock();
+        Execute(request);
+        return request->Future.get();
+    }
+
+    AssetHandle ContentManager::LoadAssetAsync(const str& name,
+                                               LoadPriority priority,
+                                               AssetCallback callback) {
+        std::lock_guard lock(mMutex);
+        Shared<LoadRequest> request;
+        bool cached = false;
+        if (const auto it = mInFlight.find(name); it != mInFlight.end()) {
+            request = it->second;
+        } else {
+            request = std::make_shared<LoadRequest>(name);
+            if (auto asset = FindCached(name)) {
+                request->Started = true;
+                request->Promise.set_value(std::move(asset));
+                cached = true;
+            } else {
+                mInFlight.emplace(name, request);
+            }
+        }
+
+        auto ticket = std::make_shared<LoadTicket>(request, std::move(callback));
+        ++request->Interested;
+        if (ticket->Callback) {
+            request->Tickets.push_back(ticket);
+            // Cached results still report through Update() so callbacks always run on one thread
+            if (cached) { mFinished.push_back(request); }
+        }
+        if (!request->Started && (request->Epoch == 0 || priority > request->Priority)) {
+            request->Priority = priority;
+            Enqueue(request);
+        }
+        return AssetHandle(std::move(ticket));
+    }
+
+    void ContentManager::SetPriority(const AssetHandle& handle, LoadPriority priority) {
+        if (!handle.mTicket) { return; }
+        std::lock_guard lock(mMutex);
+        const auto& request = handle.mTicket->Request;
+        if (request->Started || request->Priority == priority) { return; }
+        request->Priority = priority;
+        Enqueue(request);
+    }
+
+    void ContentManager::Update() {
+        std::vector<Shared<LoadRequest>> finished;
+        std::vector<std::pair<str, std::filesystem::path>> reloads;
+        {
+            std::lock_guard lock(mMutex);
+            finished.swap(mFinished);
+            reloads.swap(mPendingReloads);
+            ReleaseUploaded();
+            EvictUntagged();
+            // Picks up assets whose last outside reference went away since the last frame
+            Trim();
+        }
+        // Finished requests are no longer shared through mInFlight, so their tickets are ours
+        for (const auto& request : finished) {
+            const auto& result = request->Future.get();
+            const auto tickets = std::move(request->Tickets);
+            request->Tickets.clear();
+            for (const auto& ticket : tickets) {
+                if (!ticket->Cancelled) { ticket->Callback(result); }
+            }
+        }
+        // The rebuild may have trained new dictionaries
+        std::vector<std::filesystem::path> directories;
+        for (const auto& directory : reloads | std::views::values) {
+            if (std::ranges::find(directories, directory) != directories.end()) { continue; }
+            directories.push_back(directory);
+            LoadDictionaries(directory);
+        }
+        for (const auto& [name, directory] : reloads) {
+            Reload(name, directory);
+        }
+    }
+
+    void ContentManager::SetBudget(u64 bytes) {
+        std::lock_guard lock(mMutex);
+        mStats.Budget = bytes;
+        Trim();
+    }
+
+    void ContentManager::Pin(const str& name) {
+        std::lock_guard lock(mMutex);
+        ++mPolicies[name].Pins;
+    }
+
+    void ContentManager::Unpin(const str& name) {
+        std::lock_guard lock(mMutex);
+        const auto it = mPolicies.find(name);
+        if (it == mPolicies.end() || it->second.Pins == 0) { return; }
+        --it->second.Pins;
+        if (it->second.Pins == 0 && it->second.Tags.empty()) { mPolicies.erase(it); }
+        Trim();
+    }
+
+    void ContentManager::Tag(const str& name, const str& tag) {
+        std::lock_guard lock(mMutex);
+        auto& tags = mPolicies[name].Tags;
+        if (std::ranges::find(tags, tag) == tags.end()) { tags.push_back(tag); }
+    }
+
+    void ContentManager::ReleaseTag(const str& tag) {
+        std::lock_guard lock(mMutex);
+        for (auto it = mPolicies.begin(); it != mPolicies.end();) {
+            auto& policy = it->second;
+            if (std::erase(policy.Tags, tag) == 0 || !policy.Tags.empty()) {
+                ++it;
+                continue;
+            }
+            mUntagged.push_back(it->first);
+            it = policy.Pins == 0 ? mPolicies.erase(it) : std::next(it);
+        }
+    }
+
+    void ContentManager::EvictUntagged() {
+        for (const auto& name : mUntagged) {
+            // Tagged again (or pinned) since it was released
+            if (mPolicies.contains(name)) { continue; }
+            const auto entry = mLoadedAssets.find(name);
+            if (entry != mLoadedAssets.end() && IsEvictable(name, entry->second)) { Evict(name); }
+        }
+        mUntagged.clear();
+    }
+
+    ContentStats ContentManager::GetStats() {
+        std::lock_guard lock(mMutex);
+        return mStats;
+    }
+
+    Shared<Asset> ContentManager::FindCached(const str& name) {
+        const auto it = mLoadedAssets.find(name);
+        if (it == mLoadedAssets.end()) {
+            ++mStats.Misses;
+            return nullptr;
+        }
+        ++mStats.Hits;
+        mLru.splice(mLru.begin(), mLru, it->second.LruPosition);
+        return it->second.Loaded;
+    }
+
+    void ContentManager::Cache(const str& name, const Shared<Asset>& asset) {
+        if (mLoadedAssets.contains(name)) { Evict(name); }
+        mLru.push_front(name);
+        // Mapped payloads are counted too: they are still resident pages
+        const u64 size = asset->GetResidentSize();
+        mLoadedAssets.emplace(name, CacheEntry {asset, size, mLru.begin()});
+        mStats.ResidentBytes += size;
+        ++mStats.ResidentAssets;
+
+        if (const auto hash = asset->Metadata.find("hash"); hash != asset->Metadata.end()) {
+            std::lock_guard contentLock(mContentMutex);
+            auto& indexed = mContentIndex[hash->second];
+            if (indexed.expired()) { indexed = asset; }
+        }
+        Trim();
+    }
+
+    bool ContentManager::IsEvictable(const str& name, const CacheEntry& entry) const {
+        // The cache's own reference is the only one left
+        if (entry.Loaded.use_count() > 1) { return false; }
+        const auto policy = mPolicies.find(name);
+        return policy == mPolicies.end() || policy->second.Pins == 0;
+    }
+
+    void ContentManager::Evict(const str& name) {
         const auto it = mLoadedAssets.find(name);
-        if (it != mLoadedAssets.end()) { return it->second; }
+        mStats.ResidentBytes -= it->second.Size;
+        --mStats.ResidentAssets;
+        ++mStats.Evictions;
+        // `name` may live in the LRU node, so it goes last
+        const auto lruPosition = it->second.LruPosition;
+        const auto hash        = it->second.Loaded->Metadata.find("hash");
+        const str contentHash  = hash != it->second.Loaded->Metadata.end() ? hash->second : "";
+        mLoadedAssets.erase(it);
+        mLru.erase(lruPosition);
 
-        auto fileName = mContentRoot / name;
+        if (!contentHash.empty()) {
+            std::lock_guard contentLock(mContentMutex);
+            const auto indexed = mContentIndex.find(contentHash);
+            if (indexed != mContentIndex.end() && indexed->second.expired()) {
+                mContentIndex.erase(indexed);
+            }
+        }
+    }
+
+    void ContentManager::ReleaseUploaded() {
+        for (auto& entry : mLoadedAssets | std::views::values) {
+            entry.Loaded->ReleaseIfUploaded();
+            const u64 size = entry.Loaded->GetResidentSize();
+            mStats.ResidentBytes += size - entry.Size;
+            entry.Size = size;
+        }
+    }
+
+    void ContentManager::Trim() {
+        auto position = mLru.end();
+        while (mStats.ResidentBytes > mStats.Budget && position != mLru.begin()) {
+            --position;
+            if (!IsEvictable(*position, mLoadedAssets.at(*position))) { continue; }
+            const auto victim = position++;
+            Evict(*victim);
+        }
+    }
+
+    void ContentManager::Enqueue(const Shared<LoadRequest>& request) {
+        if (mWorkers.empty()) { StartWorkers(); }
+        mQueue.push({request->Priority, mSequence++, ++request->Epoch, request});
+        mQueueCondition.notify_one();
+    }
+
+    void ContentManager::StartWorkers() {
+        mWorkers.reserve(mWorkerCount);
+        for (u32 i = 0; i < mWorkerCount; ++i) {
+            mWorkers.emplace_back(&ContentManager::WorkerLoop, this);
+        }
+    }
+
+    void ContentManager::WorkerLoop() {
+        for (;;) {
+            Shared<LoadRequest> request;
+            {
+                std::unique_lock lock(mMutex);
+                mQueueCondition.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+                if (mStopping) { return; }
+                const auto next = mQueue.top();
+                mQueue.pop();
+                request = next.Request;
+                if (request->Started || request->Epoch != next.Epoch) { continue; }
+                request->Started = true;
+
+                if (request->Interested == 0) {
+                    // Every handle cancelled before the load started
+                    mInFlight.erase(request->Name);
+                    request->Tickets.clear();
+                    lock.unlock();
+                    request->Promise.set_value({});
+                    continue;
+                }
+            }
+            Execute(request);
+        }
+    }
+
+    void ContentManager::Execute(const Shared<LoadRequest>& request) {
+        auto result = ReadAsset(request->Name);
+        {
+            std::lock_guard lock(mMutex);
+            if (result) {
+                const u64 size = (*result)->GetResidentSize();
+                ((*result)->mShared ? mStats.SharedBytes : mStats.LoadedBytes) += size;
+                Cache(request->Name, *result);
+            }
+            mInFlight.erase(request->Name);
+            if (!request->Tickets.empty()) { mFinished.push_back(request); }
+        }
+        request->Promise.set_value(std::move(result));
+    }
+
+    bool ContentManager::Mount(const std::filesystem::path& archive) {
+        using namespace ArchiveFormat;
+
+        auto file = MappedFile::Open(archive);
+        if (!file || file->Size() < sizeof(ArchiveHeader)) { return false; }
+
+        ArchiveHeader header;
+        memcpy(&header, file->Data(), sizeof(header));
+        if (memcmp(header.Magic, kMagic, 4) != 0 || header.Version != kVersion) { return false; }
+
+        const u64 size    = file->Size();
+        const u64 tocSize = CAST<u64>(header.EntryCount) * sizeof(ArchiveEntry);
+        if (header.TocOffset % alignof(ArchiveEntry) != 0 || header.TocOffset > size ||
+            tocSize > size - header.TocOffset || header.MetadataOffset > size ||
+            header.MetadataSize > size - header.MetadataOffset) {
+            return false;
+        }
+
+        auto mounted          = std::make_unique<MountedArchive>();
+        mounted->Entries      = RCAST<const ArchiveEntry*>(file->Data() + header.TocOffset);
+        mounted->EntryCount   = header.EntryCount;
+        mounted->Metadata     = file->Data() + header.MetadataOffset;
+        mounted->MetadataSize = header.MetadataSize;
+        mounted->File         = std::make_shared<MappedFile>(std::move(*file));
+        for (u32 i = 0; i < mounted->EntryCount; ++i) {
+            const auto& entry = mounted->Entries[i];
+            if ((entry.Flags & kEntryDictionary) == 0) { continue; }
+            if (entry.Offset > size || entry.Size > size - entry.Offset ||
+                !mDictionaries->Add({mounted->File->Data() + entry.Offset, entry.Size})) {
+                return false;
+            }
+        }
+        std::unique_lock lock(mArchiveMutex);
+        mArchives.push_back(std::move(mounted));
+        return true;
+    }
+
+    bool ContentManager::EnableHotReload(u16 port) {
+        std::lock_guard lock(mMutex);
+        if (mReloadChannel) { return true; }
+        auto channel = ReloadChannel::Open();
+        if (!channel) { return false; }
+        mReloadChannel = std::make_unique<ReloadChannel>(std::move(*channel));
+        mReloadThread  = std::thread(&ContentManager::ListenForReloads,
+                                    this,
+                                    port ? port : ReloadChannel::kDefaultPort);
+        return true;
+    }
+
+    void ContentManager::AddReloadListener(ReloadListener listener) {
+        mReloadListeners.push_back(std::move(listener));
+    }
+
+    void ContentManager::ListenForReloads(u16 watcherPort) {
+        auto lastSubscribed = std::chrono::steady_clock::time_point {};
+        for (;;) {
+            {
+                std::lock_guard lock(mMutex);
+                if (mStopping) { return; }
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastSubscribed >= kSubscribeInterval) {
+                mReloadChannel->Subscribe(watcherPort);
+                lastSubscribed = now;
+            }
+
+            const auto datagram = mReloadChannel->Receive(kReloadPollInterval);
+            if (!datagram || datagram->Kind != ReloadChannel::Message::Reload ||
+                datagram->From != watcherPort) {
+                continue;
+            }
+            const std::filesystem::path directory = datagram->Directory;
+            std::lock_guard lock(mMutex);
+            for (const auto& name : datagram->Names) {
+                const auto pending = std::ranges::find_if(mPendingReloads, [&](const auto& entry) {
+                    return entry.first == name;
+                });
+                if (pending != mPendingReloads.end()) {
+                    pending->second = directory;
+                } else {
+                    mPendingReloads.emplace_back(name, directory);
+                }
+            }
+        }
+    }
+
+    bool ContentManager::Reload(const str& name, const std::filesystem::path& directory) {
+        const auto root = directory.empty() ? mContentRoot : directory;
+        {
+            std::unique_lock lock(mArchiveMutex);
+            mStaleEntries.insert_or_assign(name, root);
+        }
+        Shared<Asset> cached;
+        {
+            std::lock_guard lock(mMutex);
+            const auto it = mLoadedAssets.find(name);
+            if (it != mLoadedAssets.end()) { cached = it->second.Loaded; }
+        }
+        // Not cached and nobody listening; the next load reads the new files
+        if (!cached && mReloadListeners.empty()) { return false; }
+        const auto fresh = LoadLooseFiles(name, root);
+        if (!fresh) {
+            std::cout << "Unable to reload asset: " << name << std::endl;
+            return false;
+        }
+
+        // Evicted or released, but copies made from it (such as GPU textures) may still be live
+        if (!cached) {
+            for (const auto& listener : mReloadListeners) {
+                listener(*fresh);
+            }
+            return true;
+        }
+
+        {
+            std::lock_guard lock(mMutex);
+            const auto oldHash = cached->Metadata.find("hash");
+            const str contentHash = oldHash != cached->Metadata.end() ? oldHash->second : "";
+            {
+                std::scoped_lock assetLock(cached->mMutex, (*fresh)->mMutex);
+                cached->mData     = (*fresh)->mData;
+                cached->mStorage  = (*fresh)->mStorage;
+                cached->mOwner    = (*fresh)->mOwner;
+                cached->mReload   = (*fresh)->mReload;
+                cached->mShared   = (*fresh)->mShared;
+                cached->mUploaded = false;
+                cached->mReleased = false;
+            }
+            cached->Metadata = (*fresh)->Metadata;
+
+            // The old content is no longer available from this asset
+            std::lock_guard contentLock(mContentMutex);
+            if (const auto indexed = mContentIndex.find(contentHash);
+                indexed != mContentIndex.end() && indexed->second.lock() == cached) {
+                mContentIndex.erase(indexed);
+            }
+            if (const auto hash = cached->Metadata.find("hash"); hash != cached->Metadata.end()) {
+                auto& indexed = mContentIndex[hash->second];
+                if (indexed.expired()) { indexed = cached; }
+            }
+        }
+        // The cache picks up the new resident size at the next Update()
+        for (const auto& listener : mReloadListeners) {
+            listener(cached);
+        }
+        return true;
+    }
+
+    void ContentManager::LoadDictionaries(const std::filesystem::path& directory) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            if (entry.path().extension() != ".xdict") { continue; }
+            const auto dictionary = IO::ReadBytes(entry.path());
+            if (!dictionary || !mDictionaries->Add(*dictionary)) {
+                std::cout << "Unable to load dictionary: " << entry.path().string() << std::endl;
+            }
+        }
+    }
+
+    AssetResult ContentManager::LoadFromArchive(const str& name) const {
+        using namespace ArchiveFormat;
+
+        const u64 id = HashName(name);
+        std::shared_lock lock(mArchiveMutex);
+        if (mStaleEntries.contains(name)) { return {}; }
+        for (auto archive = mArchives.rbegin(); archive != mArchives.rend(); ++archive) {
+            const auto& mounted = **archive;
+            const auto* end     = mounted.Entries + mounted.EntryCount;
+            const auto* entry =
+              std::lower_bound(mounted.Entries, end, id, [](const ArchiveEntry& e, u64 value) {
+                  return e.Id < value;
+              });
+            if (entry == end || entry->Id != id || (entry->Flags & kEntryDictionary) != 0) {
+                continue;
+            }
+
+            const u64 size = mounted.File->Size();
+            if (entry->Offset > size || entry->Size > size - entry->Offset ||
+                entry->MetadataOffset > mounted.MetadataSize ||
+                entry->MetadataSize > mounted.MetadataSize - entry->MetadataOffset ||
+                entry->OriginalSize > CAST<u64>(MAX_ASSET_SIZE) ||
+                !Codecs::IsValid(entry->Codec) ||
+                (entry->Codec == CAST<u8>(Codec::None) && entry->OriginalSize != entry->Size)) {
+                std::cout << "Corrupt archive entry for asset: " << name << std::endl;
+                return {};
+            }
+
+            std::unordered_map<str, str> metadata;
+            const u8* metadataBlock = mounted.Metadata + entry->MetadataOffset;
+            if (!ArchiveFormat::ReadMetadata(metadataBlock, entry->MetadataSize, metadata)) {
+                std::cout << "Unable to read metadata for asset: " << name << std::endl;
+                return {};
+            }
+
+            // Decode without holding up Mount; `file` keeps the mapping alive
+            const auto file = mounted.File;
+            lock.unlock();
+
+            const std::span payload(file->Data() + entry->Offset, entry->Size);
+            const auto codec = CAST<Codec>(entry->Codec);
+            if (codec == Codec::None) {
+                // Served straight from the mapping
+                return std::make_shared<Asset>(name, payload, file, std::move(metadata));
+            }
+            if (auto shared = ShareLoaded(name, metadata)) { return shared; }
+            // Holds the mapping rather than the archive entry, so it outlives a remount
+            const auto decode = [name,
+                                 payload,
+                                 file,
+                                 codec,
+                                 dictionaries = mDictionaries,
+                                 size         = entry->OriginalSize,
+                                 threads      = GetDecodeThreads()] {
+                std::vector<u8> data(size);
+                if (!Codecs::DecompressInto(codec, payload, data, dictionaries.get(), threads)) {
+                    Panic("Failed to decompress asset data: %s", name.c_str());
+                }
+                return data;
+            };
+            auto asset = std::make_shared<Asset>(name, decode(), std::move(metadata));
+            if (IsGpuResident(*asset)) {
+                asset->mReload = [decode]() -> std::optional<std::vector<u8>> {
+                    return decode();
+                };
+            }
+            return asset;
+        }
+        return {};
+    }
+
+    u32 ContentManager::GetDecodeThreads() const {
+        return std::max(1u, std::thread::hardware_concurrency() / std::max(mWorkerCount, 1u));
+    }
+
+    AssetResult ContentManager::ReadAsset(const str& name) const {
+        if (auto archived = LoadFromArchive(name)) { return archived; }
+        std::filesystem::path root = mContentRoot;
+        {
+            std::shared_lock lock(mArchiveMutex);
+            if (const auto stale = mStaleEntries.find(name); stale != mStaleEntries.end()) {
+                root = stale->second;
+            }
+        }
+        return LoadLooseFiles(name, root);
+    }
+
+    AssetResult ContentManager::LoadLooseFiles(const str& name,
+                                               const std::filesystem::path& root) const {
+        auto fileName = root / name;
         fileName.replace_extension(".xpkf");
         if (!exists(fileName)) {
             std::cout << "Unable to locate asset: " << fileName.string() << std::endl;
             return {};
         }
 
-        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
-        if (!file.is_open()) {
-            std::cout << "Unable to open file: " << fileName.string() << std::endl;
+        // Metadata first: it carries the content hash, which may make reading the pak
+        // unnecessary
+        const auto metadataFile = std::filesystem::path(fileName).replace_extension(".xmdf");
+        std::unordered_map<str, str> metadata;
+        if (!ReadMetadata(metadataFile, metadata)) {
+            std::cout << "Unable to read metadata: " << metadataFile.string() << std::endl;
             return {};
         }
-        const std::streamsize fileSize = file.tellg();
-        std::vector<u8> pakBytes(fileSize);
-        file.seekg(0, std::ios::beg);
-        if (!file.read(RCAST<char*>(pakBytes.data()), fileSize)) {
-            std::cout << "Unable to read file: " << fileName.string() << std::endl;
-            return {};
+        if (auto shared = ShareLoaded(name, metadata)) { return shared; }
+
+        const u32 threads = GetDecodeThreads();
+        auto data         = ReadPakFile(fileName, *mDictionaries, threads);
+        if (!data) { return {}; }
+
+        auto asset = std::make_shared<Asset>(name, std::move(*data), std::move(metadata));
+        if (IsGpuResident(*asset)) {
+            asset->mReload =
+              [pakFile = std::move(fileName), dictionaries = mDictionaries, threads] {
+                  return ReadPakFile(pakFile, *dictionaries, threads);
+              };
         }
-        file.close();
+        return asset;
+    }
 
-        if (!ValidatePakHeader(pakBytes)) {
-            std::cout << "Invalid PAK file: " << fileName.string() << std::endl;
-            return {};
+    Shared<Asset> ContentManager::ShareLoaded(const str& name,
+                                              std::unordered_map<str, str>& metadata) const {
+        const auto hash = metadata.find("hash");
+        if (hash == metadata.end()) { return nullptr; }
+
+        std::lock_guard lock(mContentMutex);
+        const auto indexed = mContentIndex.find(hash->second);
+        if (indexed == mContentIndex.end()) { return nullptr; }
+        const auto loaded = indexed->second.lock();
+        if (!loaded) {
+            mContentIndex.erase(indexed);
+            return nullptr;
         }
+        return loaded->Share(name, std::move(metadata));
+    }
 
-        bool compressed = false;
-        memcpy(&compressed, pakBytes.data() + 7, 1);
+    std::optional<std::vector<u8>> ContentManager::ReadPakFile(
+      const std::filesystem::path& filename,
+      const DictionarySet& dictionaries,
+      u32 threads) {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            std::cout << "Unable to open file: " << filename.string() << std::endl;
+            return std::nullopt;
+        }
+        const auto fileSize = CAST<size_t>(file.tellg());
+        u8 header[16];
+        file.seekg(0, std::ios::beg);
+        if (fileSize < sizeof(header) || !file.read(RCAST<char*>(header), sizeof(header)) ||
+            !ValidatePakHeader(header, fileSize)) {
+            std::cout << "Invalid PAK file: " << filename.string() << std::endl;
+            return std::nullopt;
+        }
 
+        const auto codec      = CAST<Codec>(header[7]);
+        const bool compressed = codec != Codec::None;
         size_t originalSize;
-        memcpy(&originalSize, pakBytes.data() + 8, sizeof(size_t));
-
-        std::vector<u8> srcData(pakBytes.size() - 16);
-        memcpy(srcData.data(), pakBytes.data() + 16, pakBytes.size() - 16);
+        memcpy(&originalSize, header + 8, sizeof(size_t));
 
+        // Uncompressed payloads are read straight into the asset's buffer; compressed ones are
+        // streamed through a fixed chunk and decoded straight into it, except LZMA payloads
+        // large enough to span blocks
         std::vector<u8> data(originalSize);
-        if (compressed) {
-            auto result       = LZMA::Decompress(srcData, originalSize);
-            auto decompressed = Expect(result, "Failed to decompress asset data");
-            memcpy(data.data(), decompressed.data(), decompressed.size());
-        } else {
-            memcpy(data.data(), srcData.data(), originalSize);
+        if (!compressed) {
+            if (!file.read(RCAST<char*>(data.data()), CAST<std::streamsize>(data.size()))) {
+                std::cout << "Unable to read file: " << filename.string() << std::endl;
+                return std::nullopt;
+            }
+            return data;
         }
-
-        const auto metadataFile = fileName.replace_extension(".xmdf");
-        std::unordered_map<str, str> metadata;
-        if (!ReadMetadata(metadataFile, metadata)) {
-            std::cout << "Unable to read metadata: " << metadataFile.string() << std::endl;
-            return {};
+        if (codec == Codec::LZMA && originalSize > LZMA::kBlockSize) {
+            // May hold several blocks, which only decode in parallel from the whole payload
+            std::vector<u8> payload(fileSize - sizeof(header));
+            if (!file.read(RCAST<char*>(payload.data()), CAST<std::streamsize>(payload.size()))) {
+                std::cout << "Unable to read file: " << filename.string() << std::endl;
+                return std::nullopt;
+            }
+            if (!Codecs::DecompressInto(codec, payload, data, &dictionaries, threads)) {
+                Panic("Failed to decompress asset data: %s", filename.string().c_str());
+            }
+            return data;
         }
 
-        const auto asset = std::make_shared<Asset>(name, data, metadata);
-        mLoadedAssets.insert_or_assign(name, asset);
-        return mLoadedAssets.at(name);
+        thread_local std::array<u8, kStreamChunkSize> chunk;
+        StreamDecoder decoder(codec, data, &dictionaries);
+        size_t remaining = fileSize - sizeof(header);
+        while (remaining > 0) {
+            const auto count = std::min(remaining, chunk.size());
+            if (!file.read(RCAST<char*>(chunk.data()), CAST<std::streamsize>(count))) {
+                std::cout << "Unable to read file: " << filename.string() << std::endl;
+                return std::nullopt;
+            }
+            if (!decoder.Feed(std::span(chunk.data(), count))) { break; }
+            remaining -= count;
+        }
+        if (!decoder.Finished()) {
+            Panic("Failed to decompress asset data: %s", filename.string().c_str());
+        }
+        return data;
     }
 
-    bool ContentManager::ValidatePakHeader(const std::vector<u8>& pakBytes) {
+    bool ContentManager::ValidatePakHeader(std::span<const u8> header, size_t fileSize) {
         char secret[5] = {'\0'};
-        memcpy(&secret[0], pakBytes.data(), 4);
+        memcpy(&secret[0], header.data(), 4);
         if (strcmp("XPAK", secret) != 0) { return false; }
 
-        if (pakBytes[4] != '\0' || pakBytes[5] != '\0' || pakBytes[6] != '\0') { return false; }
+        if (header[4] != '\0' || header[5] != '\0' || header[6] != '\0') { return false; }
+        if (!Codecs::IsValid(header[7])) { return false; }
 
         size_t originalSize;
-        memcpy(&originalSize, pakBytes.data() + 8, sizeof(size_t));
+        memcpy(&originalSize, header.data() + 8, sizeof(size_t));
         if (originalSize > (size_t)MAX_ASSET_SIZE) { return false; }
 
-        if (originalSize < (pakBytes.size() - 16)) { return false; }
+        // Stored payloads must be complete; compressed ones may legitimately be larger
+        if (header[7] == 0 && originalSize != fileSize - 16) { return false; }
 
         return true;
     }
@@ -0,0 +1,116 @@
+// Author: Jake Rieger
+// Created: 12/3/2024.
+//
+
+#include "Font.hpp"
+#include "Texture.hpp"
+
+#include <Panic.hpp>
+#include <cstring>
+#include <iostream>
+#include <glad/glad.h>
+
+namespace Xen {
+    namespace {
+        // Every live font, so Reload() can find the ones loaded from a rebuilt asset
+        std::vector<Font*>& GetFonts() {
+            static std::vector<Font*> fonts;
+            return fonts;
+        }
+    }  // namespace
+
+    Font::Font(const Shared<Asset>& fontAsset) : mName(fontAsset->Name) {
+        if (const auto error = Load(*fontAsset); !error.empty()) { Panic("%s", error.c_str()); }
+        GetFonts().push_back(this);
+    }
+
+    Font::~Font() {
+        std::erase(GetFonts(), this);
+        Texture::Delete(mTexture);
+    }
+
+    void Font::Reload(const Asset& asset) {
+        for (auto* font : GetFonts()) {
+            if (font->mName != asset.Name) { continue; }
+            // A broken rebuild keeps the old glyphs rather than taking the game down
+            if (const auto error = font->Load(asset); !error.empty()) {
+                std::cerr << "ERROR: Unable to reload font (" << error << ")." << std::endl;
+            }
+        }
+    }
+
+    str Font::Load(const Asset& fontAsset) {
+        const auto data = fontAsset.GetData();
+        if (data.size() < sizeof(FontFormat::FontHeader)) { return "Font asset is truncated"; }
+        FontFormat::FontHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        if (memcmp(header.Magic, FontFormat::kMagic, sizeof(FontFormat::kMagic)) != 0) {
+            return "Asset '" + fontAsset.Name + "' is not a font";
+        }
+
+        const size_t metricsBytes = header.GlyphCount * sizeof(FontFormat::GlyphMetrics);
+        const size_t atlasBytes   = CAST<size_t>(header.AtlasWidth) * header.AtlasHeight;
+        if (data.size() < sizeof(header) + metricsBytes + atlasBytes) {
+            return "Font asset is truncated";
+        }
+
+        mHeader = header;
+        mGlyphs.resize(mHeader.GlyphCount);
+        memcpy(mGlyphs.data(), data.data() + sizeof(mHeader), metricsBytes);
+        mAscii.fill(-1);
+        mExtended.clear();
+        for (u32 i = 0; i < mHeader.GlyphCount; ++i) {
+            const u32 codepoint = mGlyphs[i].Codepoint;
+            if (codepoint < kAsciiCount) {
+                mAscii[codepoint] = CAST<i32>(i);
+            } else {
+                mExtended.emplace(codepoint, i);
+            }
+        }
+
+        if (mTexture != 0) { Texture::Delete(mTexture); }
+        const auto* atlas = data.data() + sizeof(mHeader) + metricsBytes;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        mTexture = Texture::LoadFromMemory(atlas,
+                                           CAST<i32>(mHeader.AtlasWidth),
+                                           CAST<i32>(mHeader.AtlasHeight),
+                                           GL_RED);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        // Distance fields are reconstructed from bilinear samples; nearest filtering would
+        // reintroduce the jagged edges the field exists to avoid
+        Texture::SetFilter(mTexture, GL_LINEAR, GL_LINEAR);
+        Texture::SetWrap(mTexture, GL_CLAMP_TO_EDGE);
+        fontAsset.OnUploaded();
+        ++mVersion;
+        return {};
+    }
+
+    u32 Font::NextCodepoint(const str& text, size_t& offset) {
+        constexpr u32 kReplacement = 0xFFFD;
+        const auto lead            = CAST<u8>(text[offset++]);
+        if (lead < 0x80) { return lead; }
+
+        u32 length, codepoint;
+        if ((lead & 0xE0) == 0xC0) {
+            length    = 1;
+            codepoint = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length    = 2;
+            codepoint = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length    = 3;
+            codepoint = lead & 0x07;
+        } else {
+            return kReplacement;
+        }
+
+        if (offset + length > text.size()) { return kReplacement; }
+        for (u32 i = 0; i < length; ++i) {
+            const auto next = CAST<u8>(text[offset + i]);
+            if ((next & 0xC0) != 0x80) { return kReplacement; }
+            codepoint = (codepoint << 6) | (next & 0x3F);
+        }
+        offset += length;
+        return codepoint;
+    }
+}  // namespace Xen
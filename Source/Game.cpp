@@ -4,8 +4,11 @@
 
 #include <Panic.hpp>
 
+#include "Font.hpp"
 #include "Game.hpp"
 #include "Input.hpp"
+#include "Texture.hpp"
+#include "TextureAtlas.hpp"
 
 namespace Xen {
     static bool gEscToQuit = false;
@@ -84,6 +87,18 @@ namespace Xen {
         glViewport(0, 0, mInitWidth, mInitHeight);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
+#ifndef NDEBUG
+        // Pick up assets rebuilt by `XPak watch` while the game runs
+        const auto content = ContentManager::GetShared("Content");
+        if (content->EnableHotReload()) {
+            content->AddReloadListener([](const Shared<Asset>& asset) {
+                Texture::Reload(*asset);
+                TextureAtlas::Reload(*asset);
+                Font::Reload(*asset);
+            });
+        }
+#endif
+
         // ====================================================================================== //
         //        THE ENTIRE GAME'S LIFECYCLE IS CONTAINED IN THE FOLLOWING LINES OF CODE         //
         // ====================================================================================== //
@@ -45,6 +45,8 @@ namespace Xen {
                                        &GameObject::GetName,
                                        "GetTransform",
                                        &GameObject::GetTransform,
+                                       "GetTextRenderer",
+                                       &GameObject::GetTextRenderer,
                                        "Destroy",
                                        &GameObject::Destroy);
     }
@@ -0,0 +1,192 @@
+// Author: Jake Rieger
+// Created: 12/2/2024.
+//
+
+#include "ParticleSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XEN_PARTICLES_SSE 1
+#endif
+
+namespace Xen {
+    static constexpr u32 kSimdWidth = 4;
+
+    static u32 PadToSimdWidth(u32 count) {
+        return (count + kSimdWidth - 1) & ~(kSimdWidth - 1);
+    }
+
+    ParticlePool::ParticlePool(u32 capacity, u32 seed) : mSeed(seed ? seed : 1u) {
+        Resize(capacity);
+    }
+
+    void ParticlePool::Resize(u32 capacity) {
+        const u32 padded = PadToSimdWidth(capacity);
+        for (auto* array :
+             {&mPosX, &mPosY, &mVelX, &mVelY, &mR, &mG, &mB, &mA, &mDR, &mDG, &mDB, &mDA, &mLife}) {
+            array->resize(padded, 0.f);
+        }
+        mScratch.resize(padded + 1);
+        mCapacity = capacity;
+        mCount    = std::min(mCount, capacity);
+    }
+
+    void ParticlePool::Emit(u32 count, f32 x, f32 y, const ParticleSettings& settings) {
+        count = std::min(count, mCapacity - mCount);
+
+        const glm::vec4 colorDelta = settings.EndColor - settings.StartColor;
+        for (u32 i = mCount; i < mCount + count; ++i) {
+            const f32 angle = settings.Direction + (NextRandom() - 0.5f) * settings.Spread;
+            const f32 speed = settings.Speed + (NextRandom() * 2.f - 1.f) * settings.SpeedVariance;
+            const f32 life  = std::max(
+              settings.Lifetime + (NextRandom() * 2.f - 1.f) * settings.LifetimeVariance,
+              1e-3f);
+            const f32 invLife = 1.f / life;
+
+            mPosX[i] = x;
+            mPosY[i] = y;
+            mVelX[i] = std::cos(angle) * speed;
+            mVelY[i] = std::sin(angle) * speed;
+            mR[i]    = settings.StartColor.r;
+            mG[i]    = settings.StartColor.g;
+            mB[i]    = settings.StartColor.b;
+            mA[i]    = settings.StartColor.a;
+            mDR[i]   = colorDelta.r * invLife;
+            mDG[i]   = colorDelta.g * invLife;
+            mDB[i]   = colorDelta.b * invLife;
+            mDA[i]   = colorDelta.a * invLife;
+            mLife[i] = life;
+        }
+        mCount += count;
+    }
+
+    void ParticlePool::Simulate(f32 dT, const ParticleSettings& settings) {
+        if (mCount == 0) { return; }
+        Integrate(dT, settings.Gravity.x, settings.Gravity.y);
+        Compact();
+    }
+
+    void ParticlePool::WriteInstances(SpriteInstance* out, u32 first, u32 count, f32 size) const {
+        const f32 half = size * 0.5f;
+        u32 i          = first;
+        const u32 end  = first + count;
+#ifdef XEN_PARTICLES_SSE
+        // Transpose four particles at a time from SoA into the instance layout
+        const __m128 halfExtent = _mm_set1_ps(half);
+        const __m128 uv         = _mm_setr_ps(0.f, 0.f, 1.f, 1.f);
+        for (; i + kSimdWidth <= end; i += kSimdWidth, out += kSimdWidth) {
+            __m128 x = _mm_loadu_ps(&mPosX[i]);
+            __m128 y = _mm_loadu_ps(&mPosY[i]);
+            __m128 w = halfExtent;
+            __m128 h = halfExtent;
+            _MM_TRANSPOSE4_PS(x, y, w, h);
+
+            __m128 r = _mm_loadu_ps(&mR[i]);
+            __m128 g = _mm_loadu_ps(&mG[i]);
+            __m128 b = _mm_loadu_ps(&mB[i]);
+            __m128 a = _mm_loadu_ps(&mA[i]);
+            _MM_TRANSPOSE4_PS(r, g, b, a);
+
+            const __m128 transforms[] = {x, y, w, h};
+            const __m128 colors[]     = {r, g, b, a};
+            for (u32 lane = 0; lane < kSimdWidth; ++lane) {
+                f32* instance = &out[lane].X;
+                _mm_storeu_ps(instance, transforms[lane]);
+                _mm_storeu_ps(instance + 4, uv);
+                _mm_storeu_ps(instance + 8, colors[lane]);
+            }
+        }
+#endif
+        for (; i < end; ++i, ++out) {
+            *out = {mPosX[i], mPosY[i], half, half, 0.f, 0.f, 1.f, 1.f, mR[i], mG[i], mB[i], mA[i]};
+        }
+    }
+
+    f32 ParticlePool::NextRandom() {
+        // xorshift32, returns [0, 1)
+        mSeed ^= mSeed << 13;
+        mSeed ^= mSeed >> 17;
+        mSeed ^= mSeed << 5;
+        return CAST<f32>(mSeed >> 8) * (1.f / 16777216.f);
+    }
+
+    void ParticlePool::Integrate(f32 dT, f32 gravityX, f32 gravityY) {
+        // Arrays are padded to the SIMD width, so running past mCount only touches slack slots
+        const u32 count = PadToSimdWidth(mCount);
+#ifdef XEN_PARTICLES_SSE
+        const __m128 dt = _mm_set1_ps(dT);
+        const __m128 gx = _mm_set1_ps(gravityX * dT);
+        const __m128 gy = _mm_set1_ps(gravityY * dT);
+        for (u32 i = 0; i < count; i += kSimdWidth) {
+            const __m128 vx = _mm_add_ps(_mm_loadu_ps(&mVelX[i]), gx);
+            const __m128 vy = _mm_add_ps(_mm_loadu_ps(&mVelY[i]), gy);
+            _mm_storeu_ps(&mVelX[i], vx);
+            _mm_storeu_ps(&mVelY[i], vy);
+            _mm_storeu_ps(&mPosX[i], _mm_add_ps(_mm_loadu_ps(&mPosX[i]), _mm_mul_ps(vx, dt)));
+            _mm_storeu_ps(&mPosY[i], _mm_add_ps(_mm_loadu_ps(&mPosY[i]), _mm_mul_ps(vy, dt)));
+
+            _mm_storeu_ps(&mR[i],
+                          _mm_add_ps(_mm_loadu_ps(&mR[i]), _mm_mul_ps(_mm_loadu_ps(&mDR[i]), dt)));
+            _mm_storeu_ps(&mG[i],
+                          _mm_add_ps(_mm_loadu_ps(&mG[i]), _mm_mul_ps(_mm_loadu_ps(&mDG[i]), dt)));
+            _mm_storeu_ps(&mB[i],
+                          _mm_add_ps(_mm_loadu_ps(&mB[i]), _mm_mul_ps(_mm_loadu_ps(&mDB[i]), dt)));
+            _mm_storeu_ps(&mA[i],
+                          _mm_add_ps(_mm_loadu_ps(&mA[i]), _mm_mul_ps(_mm_loadu_ps(&mDA[i]), dt)));
+
+            _mm_storeu_ps(&mLife[i], _mm_sub_ps(_mm_loadu_ps(&mLife[i]), dt));
+        }
+#else
+        const f32 gx = gravityX * dT;
+        const f32 gy = gravityY * dT;
+        for (u32 i = 0; i < count; ++i) {
+            mVelX[i] += gx;
+            mVelY[i] += gy;
+            mPosX[i] += mVelX[i] * dT;
+            mPosY[i] += mVelY[i] * dT;
+            mR[i] += mDR[i] * dT;
+            mG[i] += mDG[i] * dT;
+            mB[i] += mDB[i] * dT;
+            mA[i] += mDA[i] * dT;
+            mLife[i] -= dT;
+        }
+#endif
+    }
+
+    void ParticlePool::Compact() {
+        // Particle order doesn't matter, so instead of shifting every survivor down we move the
+        // survivors that sit past the new end into the holes left below it. That touches only
+        // O(dead) elements. Index lists are built by always writing and conditionally advancing
+        // the cursor, so neither pass has a data-dependent branch.
+        u32* dead     = mScratch.data();
+        u32 deadCount = 0;
+        for (u32 i = 0; i < mCount; ++i) {
+            dead[deadCount] = i;
+            deadCount += CAST<u32>(mLife[i] <= 0.f);
+        }
+        if (deadCount == 0) { return; }
+
+        const u32 alive = mCount - deadCount;
+        // Dead indices are ascending, so the holes below `alive` are a prefix of the list and the
+        // free space after it can hold the survivors found in [alive, mCount).
+        u32* sources    = dead + deadCount;
+        u32 sourceCount = 0;
+        for (u32 i = alive; i < mCount; ++i) {
+            sources[sourceCount] = i;
+            sourceCount += CAST<u32>(mLife[i] > 0.f);
+        }
+
+        // One hole below `alive` exists for every survivor at or above it
+        for (auto* array :
+             {&mPosX, &mPosY, &mVelX, &mVelY, &mR, &mG, &mB, &mA, &mDR, &mDG, &mDB, &mDA, &mLife}) {
+            f32* data = array->data();
+            for (u32 i = 0; i < sourceCount; ++i) {
+                data[dead[i]] = data[sources[i]];
+            }
+        }
+        mCount = alive;
+    }
+}  // namespace Xen
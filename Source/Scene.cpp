@@ -7,6 +7,58 @@
 #include "Texture.hpp"
 
 namespace Xen {
+    static ParticleSettings ReadParticleSettings(const pugi::xml_node& node) {
+        ParticleSettings settings;
+        const auto readColor = [](const pugi::xml_node& colorNode, glm::vec4& color) {
+            if (!colorNode) { return; }
+            color.r = colorNode.attribute("r").as_float(color.r);
+            color.g = colorNode.attribute("g").as_float(color.g);
+            color.b = colorNode.attribute("b").as_float(color.b);
+            color.a = colorNode.attribute("a").as_float(color.a);
+        };
+
+        // Angles are authored in degrees to match Transform rotations
+        settings.MaxParticles = node.child("MaxParticles").text().as_uint(settings.MaxParticles);
+        settings.Rate         = node.child("Rate").text().as_float(settings.Rate);
+        settings.Lifetime     = node.child("Lifetime").text().as_float(settings.Lifetime);
+        settings.LifetimeVariance =
+          node.child("LifetimeVariance").text().as_float(settings.LifetimeVariance);
+        settings.Speed = node.child("Speed").text().as_float(settings.Speed);
+        settings.SpeedVariance =
+          node.child("SpeedVariance").text().as_float(settings.SpeedVariance);
+        settings.Direction =
+          glm::radians(node.child("Direction").text().as_float(glm::degrees(settings.Direction)));
+        settings.Spread =
+          glm::radians(node.child("Spread").text().as_float(glm::degrees(settings.Spread)));
+        settings.Size      = node.child("Size").text().as_float(settings.Size);
+        settings.Gravity.x = node.child("Gravity").attribute("x").as_float(0.f);
+        settings.Gravity.y = node.child("Gravity").attribute("y").as_float(0.f);
+        readColor(node.child("StartColor"), settings.StartColor);
+        readColor(node.child("EndColor"), settings.EndColor);
+
+        return settings;
+    }
+
+    /// @brief Queues every asset the scene references so they load in parallel; the LoadAsset
+    /// calls in Scene::Load then only wait for (or take over) loads that haven't finished. Each
+    /// asset is tagged with the scene name so Destroy() can release them together.
+    static void PrefetchAssets(const pugi::xml_node& sceneRoot,
+                               const str& sceneName,
+                               ContentManager& contentManager) {
+        const auto prefetch = [&](const char* name) {
+            if (!*name) { return; }
+            contentManager.Tag(name, sceneName);
+            contentManager.LoadAssetAsync(name, LoadPriority::High);
+        };
+        for (const auto go : sceneRoot.children("GameObject")) {
+            prefetch(go.child("SpriteRenderer").child_value("Sprite"));
+            prefetch(go.child("Tilemap").child_value("Map"));
+            prefetch(go.child("Tilemap").child_value("Tileset"));
+            prefetch(go.child("ParticleEmitter").child_value("Texture"));
+            prefetch(go.child("TextRenderer").child_value("Font"));
+        }
+    }
+
     Unique<Scene> Scene::Load(const char* filename) {
         pugi::xml_document doc;
 
@@ -18,6 +70,7 @@ namespace Xen {
 
         auto scene                 = std::make_unique<Scene>(sceneName);
         const auto& contentManager = scene->mContentManager;
+        PrefetchAssets(sceneRoot, scene->Name, *contentManager);
 
         for (auto go : sceneRoot.children("GameObject")) {
             const auto goName   = go.attribute("name").value();
@@ -29,6 +82,9 @@ namespace Xen {
             pugi::xml_node transformNode       = go.child("Transform");
             pugi::xml_node behaviorNode        = go.child("Behavior");
             pugi::xml_node spriteRendererNode  = go.child("SpriteRenderer");
+            pugi::xml_node tilemapNode         = go.child("Tilemap");
+            pugi::xml_node particleEmitterNode = go.child("ParticleEmitter");
+            pugi::xml_node textRendererNode    = go.child("TextRenderer");
             pugi::xml_node rigidbodyNode       = go.child("Rigidbody");
             pugi::xml_node boxColliderNode     = go.child("BoxCollider");
             pugi::xml_node circleColliderNode  = go.child("CircleCollider");
@@ -69,7 +125,49 @@ namespace Xen {
                 const auto sprite     = spriteRendererNode.child_value("Sprite");
                 const auto loadResult = contentManager->LoadAsset(sprite);
                 auto spriteAsset      = Expect(loadResult, "Failed to load sprite asset");
-                const auto& component = gameObject.AddComponent("Sprite Renderer", spriteAsset);
+                // <Region> selects a named sprite when <Sprite> refers to an atlas
+                if (const str region = spriteRendererNode.child_value("Region"); !region.empty()) {
+                    gameObject.AddComponent("Sprite Renderer", spriteAsset, region);
+                } else {
+                    gameObject.AddComponent("Sprite Renderer", spriteAsset);
+                }
+            }
+
+            if (tilemapNode) {
+                const auto map           = tilemapNode.child_value("Map");
+                const auto tileset       = tilemapNode.child_value("Tileset");
+                const auto mapResult     = contentManager->LoadAsset(map);
+                const auto tilesetResult = contentManager->LoadAsset(tileset);
+                auto mapAsset            = Expect(mapResult, "Failed to load tilemap asset");
+                auto tilesetAsset        = Expect(tilesetResult, "Failed to load tileset asset");
+                gameObject.AddComponent("Tilemap", mapAsset, tilesetAsset);
+            }
+
+            if (particleEmitterNode) {
+                const auto settings = ReadParticleSettings(particleEmitterNode);
+                Shared<Asset> textureAsset;
+                if (const auto texture = particleEmitterNode.child_value("Texture"); *texture) {
+                    const auto loadResult = contentManager->LoadAsset(texture);
+                    textureAsset = Expect(loadResult, "Failed to load particle texture asset");
+                }
+                gameObject.AddComponent("Particle Emitter", settings, textureAsset);
+            }
+
+            if (textRendererNode) {
+                const auto font       = textRendererNode.child_value("Font");
+                const auto loadResult = contentManager->LoadAsset(font);
+                auto fontAsset        = Expect(loadResult, "Failed to load font asset");
+                const str text        = textRendererNode.child_value("Text");
+                const auto size       = textRendererNode.child("Size").text().as_float(1.f);
+                const auto& component =
+                  gameObject.AddComponent("Text Renderer", fontAsset, text, size);
+                if (const auto colorNode = textRendererNode.child("Color")) {
+                    const glm::vec4 color(colorNode.attribute("r").as_float(1.f),
+                                          colorNode.attribute("g").as_float(1.f),
+                                          colorNode.attribute("b").as_float(1.f),
+                                          colorNode.attribute("a").as_float(1.f));
+                    component->As<TextRenderer>()->SetColor(color);
+                }
             }
 
             if (rigidbodyNode) {
@@ -165,6 +263,27 @@ namespace Xen {
                 } else if (name == "Sprite Renderer") {
                     auto spriteRenderer     = component->As<SpriteRenderer>();
                     auto spriteRendererRoot = goRoot.append_child("SpriteRenderer");
+                } else if (name == "Tilemap") {
+                    auto tilemap     = component->As<Tilemap>();
+                    auto tilemapRoot = goRoot.append_child("Tilemap");
+                } else if (name == "Particle Emitter") {
+                    auto particleEmitter     = component->As<ParticleEmitter>();
+                    auto particleEmitterRoot = goRoot.append_child("ParticleEmitter");
+                } else if (name == "Text Renderer") {
+                    const auto textRenderer = component->As<TextRenderer>();
+                    auto textRendererRoot   = goRoot.append_child("TextRenderer");
+                    if (const auto font = textRenderer->GetFont()) {
+                        textRendererRoot.append_child("Font").text().set(font->GetName().c_str());
+                    }
+                    textRendererRoot.append_child("Text").text().set(
+                      textRenderer->GetText().c_str());
+                    textRendererRoot.append_child("Size").text().set(textRenderer->GetSize());
+                    const auto& color = textRenderer->GetColor();
+                    auto colorNode    = textRendererRoot.append_child("Color");
+                    colorNode.append_attribute("r").set_value(color.r);
+                    colorNode.append_attribute("g").set_value(color.g);
+                    colorNode.append_attribute("b").set_value(color.b);
+                    colorNode.append_attribute("a").set_value(color.a);
                 } else if (name == "Rigidbody") {
                     auto rigidbody     = component->As<Rigidbody>();
                     auto rigidbodyRoot = goRoot.append_child("Rigidbody");
@@ -191,11 +310,16 @@ namespace Xen {
     }
 
     void Scene::Update(f32 dT) {
+        mContentManager->Update();
+
         for (auto& go : GameObjects | std::views::values) {
             const auto behavior = go.GetComponentAs<Behavior>("Behavior");
             if (behavior) {
                 ScriptEngine::Get().ExecuteFunction(behavior->GetScriptPath(), "onUpdate", go, dT);
             }
+
+            const auto particleEmitter = go.GetComponentAs<ParticleEmitter>("Particle Emitter");
+            if (particleEmitter) { particleEmitter->Update(go.GetTransform(), dT); }
         }
     }
 
@@ -206,9 +330,19 @@ namespace Xen {
             if (!transform) { Panic("Sprite Renderer requires Transform component."); }
             const auto camera = GetMainCamera();
             if (!camera) { Panic("Scene is missing main camera."); }
+            const auto tilemap = go.GetComponentAs<Tilemap>("Tilemap");
+            if (tilemap) { tilemap->Draw(transform, camera->GetCamera()->As<OrthoCamera>()); }
             if (spriteRenderer) {
                 spriteRenderer->Draw(transform, camera->GetCamera()->As<OrthoCamera>());
             }
+            const auto particleEmitter = go.GetComponentAs<ParticleEmitter>("Particle Emitter");
+            if (particleEmitter) {
+                particleEmitter->Draw(camera->GetCamera()->As<OrthoCamera>());
+            }
+            const auto textRenderer = go.GetComponentAs<TextRenderer>("Text Renderer");
+            if (textRenderer) {
+                textRenderer->Draw(transform, camera->GetCamera()->As<OrthoCamera>());
+            }
         }
     }
 
@@ -217,6 +351,7 @@ namespace Xen {
             go.Destroy();
         }
         GameObjects.clear();
+        mContentManager->ReleaseTag(Name);
     }
 
     void Scene::DestroyGameObject(const str& name) {
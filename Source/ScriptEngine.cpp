@@ -15,6 +15,9 @@ namespace Xen {
         Behavior::RegisterType(mState);
         Rigidbody::RegisterType(mState);
         SpriteRenderer::RegisterType(mState);
+        Tilemap::RegisterType(mState);
+        ParticleEmitter::RegisterType(mState);
+        TextRenderer::RegisterType(mState);
         BoxCollider::RegisterType(mState);
         CircleCollider::RegisterType(mState);
         PolygonCollider::RegisterType(mState);
@@ -0,0 +1,93 @@
+// Author: Jake Rieger
+// Created: 12/2/2024.
+//
+
+#include "SpriteBatch.hpp"
+#include "CommonShaders.hpp"
+#include "Primitives.hpp"
+#include "Texture.hpp"
+
+#include <Panic.hpp>
+#include <glad/glad.h>
+
+namespace Xen {
+    SpriteBatch::SpriteBatch(u32 capacity, cstr vertexSource, cstr fragmentSource)
+        : mCapacity(capacity) {
+        if (mCapacity == 0) { Panic("SpriteBatch capacity must be greater than zero"); }
+        mInstances.resize(mCapacity);
+
+        if (!vertexSource) { vertexSource = Shaders::BatchShader::Vertex; }
+        if (!fragmentSource) { fragmentSource = Shaders::BatchShader::Fragment; }
+        mShader = std::make_unique<Shader>(vertexSource, fragmentSource);
+
+        constexpr auto stride                       = CAST<i32>(sizeof(SpriteInstance));
+        std::vector<VertexAttribute> quadAttributes = {
+          {"aVertex", 0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(f32), (void*)nullptr},
+        };
+        std::vector<VertexAttribute> instanceAttributes = {
+          {"aTransform", 1, 4, GL_FLOAT, GL_FALSE, stride, (void*)nullptr},
+          {"aUV", 2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(f32))},
+          {"aColor", 3, 4, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(f32))},
+        };
+
+        mVAO = std::make_unique<VertexArray>();
+        mVAO->Bind();
+        mVAO->CreateVertexBuffer<f32>(Primitives::QuadVertTex, quadAttributes);
+        mVAO->CreateVertexBuffer<SpriteInstance>(mInstances, instanceAttributes, GL_STREAM_DRAW);
+        for (const auto& attribute : instanceAttributes) {
+            VertexArray::SetAttributeDivisor(attribute.Location, 1);
+        }
+        VertexArray::Unbind();
+    }
+
+    void SpriteBatch::Begin(const glm::mat4& viewProjection, u32 texture) {
+        if (mDrawing) { Panic("SpriteBatch::Begin called twice without End"); }
+        mViewProjection = viewProjection;
+        mTexture        = texture;
+        mCount          = 0;
+        mDrawCalls      = 0;
+        mDrawing        = true;
+    }
+
+    SpriteInstance* SpriteBatch::Reserve(u32 count) {
+        if (!mDrawing) { Panic("SpriteBatch::Reserve called outside of Begin/End"); }
+        if (count > mCapacity) { Panic("SpriteBatch reservation exceeds capacity"); }
+        if (mCount + count > mCapacity) { Flush(); }
+        SpriteInstance* instances = mInstances.data() + mCount;
+        mCount += count;
+        return instances;
+    }
+
+    void SpriteBatch::Submit(const SpriteInstance& instance) {
+        *Reserve(1) = instance;
+    }
+
+    void SpriteBatch::End() {
+        if (!mDrawing) { Panic("SpriteBatch::End called without Begin"); }
+        Flush();
+        mDrawing = false;
+    }
+
+    void SpriteBatch::Flush() {
+        if (mCount == 0) { return; }
+
+        // Orphan and refill the instance buffer so we never stall on a draw still in flight
+        mVAO->UpdateVertexBuffer<SpriteInstance>(1, mInstances.data(), mCount, GL_STREAM_DRAW);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        mShader->Bind();
+        mShader->SetInt("uSprite", 0);
+        mShader->SetMat4("uVP", mViewProjection);
+        Texture::Bind(mTexture, 0);
+        mVAO->Bind();
+        mVAO->DrawInstanced(CAST<i32>(mCount), GL_TRIANGLE_STRIP);
+        VertexArray::Unbind();
+        Texture::Unbind();
+        Shader::Unbind();
+        glDisable(GL_BLEND);
+
+        mCount = 0;
+        ++mDrawCalls;
+    }
+}  // namespace Xen
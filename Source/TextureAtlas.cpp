@@ -0,0 +1,107 @@
+// Author: Jake Rieger
+// Created: 12/4/2024.
+//
+
+#include "TextureAtlas.hpp"
+#include "Texture.hpp"
+
+#include <Panic.hpp>
+#include <iostream>
+#include <sstream>
+
+namespace Xen {
+    namespace {
+        // Live atlases by asset name. Get() hands out the same one; Reload() refreshes it
+        std::unordered_map<str, std::weak_ptr<TextureAtlas>>& GetAtlases() {
+            static std::unordered_map<str, std::weak_ptr<TextureAtlas>> atlases;
+            return atlases;
+        }
+    }  // namespace
+
+    TextureAtlas::TextureAtlas(const Shared<Asset>& atlasAsset) {
+        if (const auto error = Load(*atlasAsset); !error.empty()) { Panic("%s", error.c_str()); }
+    }
+
+    TextureAtlas::~TextureAtlas() {
+        for (const auto page : mPages) {
+            Texture::Delete(page);
+        }
+    }
+
+    Shared<TextureAtlas> TextureAtlas::Get(const Shared<Asset>& atlasAsset) {
+        auto& cached = GetAtlases()[atlasAsset->Name];
+        if (auto atlas = cached.lock()) { return atlas; }
+        auto atlas = std::make_shared<TextureAtlas>(atlasAsset);
+        cached     = atlas;
+        return atlas;
+    }
+
+    void TextureAtlas::Reload(const Asset& asset) {
+        const auto it = GetAtlases().find(asset.Name);
+        if (it == GetAtlases().end()) { return; }
+        const auto atlas = it->second.lock();
+        if (!atlas) {
+            GetAtlases().erase(it);
+            return;
+        }
+        // A broken rebuild keeps the old pages rather than taking the game down
+        if (const auto error = atlas->Load(asset); !error.empty()) {
+            std::cerr << "ERROR: Unable to reload atlas (" << error << ")." << std::endl;
+        }
+    }
+
+    str TextureAtlas::Load(const Asset& atlasAsset) {
+        const auto& metadata = atlasAsset.Metadata;
+        if (!metadata.contains("width") || !metadata.contains("height") ||
+            !metadata.contains("pages") || !metadata.contains("sprites")) {
+            return "Invalid atlas metadata: " + atlasAsset.Name;
+        }
+
+        const auto width       = ToInt(metadata.at("width"));
+        const auto height      = ToInt(metadata.at("height"));
+        const auto pageCount   = ToUInt(metadata.at("pages"));
+        const auto spriteCount = ToUInt(metadata.at("sprites"));
+        const auto mips        = metadata.contains("mips") ? ToUInt(metadata.at("mips")) : 0;
+        const size_t pageBytes = Texture::GetMipChainSize(width, height, mips);
+        const auto data = atlasAsset.GetData();
+        if (data.size() < pageBytes * pageCount) {
+            return "Atlas data is truncated: " + atlasAsset.Name;
+        }
+
+        for (const auto page : mPages) {
+            Texture::Delete(page);
+        }
+        mPages.clear();
+        mPages.reserve(pageCount);
+        for (u32 page = 0; page < pageCount; ++page) {
+            const u8* pageData = data.data() + pageBytes * page;
+            mPages.push_back(Texture::LoadFromMemory(pageData, width, height, GL_RGBA, mips));
+        }
+        atlasAsset.OnUploaded();
+
+        // Entry layout: page u0 v0 u1 v1 offsetX offsetY width height sourceWidth sourceHeight name
+        mRegions.clear();
+        mRegions.reserve(spriteCount);
+        for (u32 i = 0; i < spriteCount; ++i) {
+            const auto it = metadata.find("sprite" + std::to_string(i));
+            if (it == metadata.end()) { continue; }
+
+            std::istringstream entry(it->second);
+            AtlasRegion region {};
+            f32 offsetX, offsetY, trimWidth, trimHeight, sourceWidth, sourceHeight;
+            entry >> region.Page >> region.UV.x >> region.UV.y >> region.UV.z >> region.UV.w >>
+              offsetX >> offsetY >> trimWidth >> trimHeight >> sourceWidth >> sourceHeight;
+            str name;
+            std::getline(entry >> std::ws, name);
+            if (entry.fail() || name.empty()) { continue; }
+
+            region.Quad.x = (2.f * offsetX + trimWidth) / sourceWidth - 1.f;
+            region.Quad.y = (2.f * offsetY + trimHeight) / sourceHeight - 1.f;
+            region.Quad.z = trimWidth / sourceWidth;
+            region.Quad.w = trimHeight / sourceHeight;
+            mRegions.insert_or_assign(name, region);
+        }
+        ++mVersion;
+        return {};
+    }
+}  // namespace Xen
@@ -0,0 +1,60 @@
+// Author: Jake Rieger
+// Created: 12/2/2024.
+//
+
+#pragma once
+
+#include <Types.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace XBench {
+    /// @brief Collects per-iteration timings and prints a one-line summary.
+    class Timings {
+    public:
+        void Add(f64 milliseconds) {
+            mSamples.push_back(milliseconds);
+        }
+
+        [[nodiscard]] f64 Mean() const {
+            if (mSamples.empty()) { return 0.0; }
+            f64 total = 0.0;
+            for (const auto sample : mSamples) {
+                total += sample;
+            }
+            return total / CAST<f64>(mSamples.size());
+        }
+
+        [[nodiscard]] f64 Percentile(f64 p) const {
+            if (mSamples.empty()) { return 0.0; }
+            auto sorted = mSamples;
+            std::ranges::sort(sorted);
+            const auto index = CAST<size_t>(p * CAST<f64>(sorted.size() - 1));
+            return sorted[index];
+        }
+
+        void Print(const char* label) const {
+            printf("  %-24s mean %8.3f ms | p50 %8.3f ms | p99 %8.3f ms | n=%zu\n",
+                   label,
+                   Mean(),
+                   Percentile(0.5),
+                   Percentile(0.99),
+                   mSamples.size());
+        }
+
+    private:
+        std::vector<f64> mSamples;
+    };
+
+    /// @brief Runs `fn` and returns the elapsed wall time in milliseconds.
+    template<typename Fn>
+    f64 Measure(Fn&& fn) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<f64, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+}  // namespace XBench
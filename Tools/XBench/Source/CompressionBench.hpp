@@ -0,0 +1,138 @@
+// Author: Jake Rieger
+// Created: 12/7/2024.
+//
+
+#pragma once
+
+#include "BenchUtils.hpp"
+#include "TextureBench.hpp"
+
+#include <Compression.hpp>
+
+namespace XBench {
+    /// @brief The pre-blocking encoder: one LZMA_PRESET_EXTREME stream on a single thread, which
+    /// always decodes sequentially. Kept here as the baseline.
+    static std::optional<std::vector<u8>> CompressSingleStream(const std::vector<u8>& data) {
+        lzma_stream stream = LZMA_STREAM_INIT;
+        if (lzma_easy_encoder(&stream, LZMA_PRESET_EXTREME, LZMA_CHECK_CRC64) != LZMA_OK) {
+            return {};
+        }
+        std::vector<u8> compressed(lzma_stream_buffer_bound(data.size()));
+        stream.next_in   = data.data();
+        stream.avail_in  = data.size();
+        stream.next_out  = compressed.data();
+        stream.avail_out = compressed.size();
+        const lzma_ret ret = lzma_code(&stream, LZMA_FINISH);
+        compressed.resize(stream.total_out);
+        lzma_end(&stream);
+        if (ret != LZMA_STREAM_END) { return {}; }
+        return compressed;
+    }
+
+    /// @brief Compresses and decompresses a synthetic `size`² RGBA texture with the single-stream
+    /// baseline, the blocked encoder on 1 and `threads` threads, and each pak codec, reporting
+    /// throughput (of uncompressed bytes) and ratio. Returns false if any round trip fails or the
+    /// blocked output differs between thread counts.
+    static bool RunCompressionBench(u32 size, u32 iterations, u32 threads) {
+        if (threads == 0) { threads = std::max(1u, std::thread::hardware_concurrency()); }
+        const auto image = MakeTestImage(size);
+        const auto mib   = CAST<f64>(image.size()) / (1024.0 * 1024.0);
+        printf("LZMA: %ux%u RGBA8 (%.1f MiB), %zu KiB blocks, %u threads\n",
+               size,
+               size,
+               mib,
+               LZMA::kBlockSize / 1024,
+               threads);
+
+        bool valid     = true;
+        const auto run = [&](const char* label, const auto& compress, u32 decodeThreads) {
+            Timings encode, decode;
+            std::optional<std::vector<u8>> compressed;
+            for (u32 i = 0; i < iterations; ++i) {
+                encode.Add(Measure([&] { compressed = compress(); }));
+            }
+            if (!compressed) {
+                printf("  %-24s compression failed\n", label);
+                valid = false;
+                return std::vector<u8> {};
+            }
+
+            std::vector<u8> output(image.size());
+            bool decoded = true;
+            for (u32 i = 0; i < iterations; ++i) {
+                decode.Add(Measure(
+                  [&] { decoded &= LZMA::DecompressInto(*compressed, output, decodeThreads); }));
+            }
+            valid &= decoded && output == image;
+
+            printf("  %-24s encode %7.1f MiB/s | decode %7.1f MiB/s | ratio %5.2f:1%s\n",
+                   label,
+                   mib / (encode.Mean() / 1000.0),
+                   mib / (decode.Mean() / 1000.0),
+                   CAST<f64>(image.size()) / CAST<f64>(compressed->size()),
+                   decoded && output == image ? "" : " | ROUND TRIP FAILED");
+            return *compressed;
+        };
+
+        run("Single stream", [&] { return CompressSingleStream(image); }, 1);
+        const auto serial = run("Blocked, 1 thread", [&] { return LZMA::Compress(image, 1); }, 1);
+        const auto parallel =
+          run("Blocked, N threads", [&] { return LZMA::Compress(image, threads); }, threads);
+        if (serial != parallel) {
+            printf("  Blocked output differs between 1 and %u threads\n", threads);
+            valid = false;
+        }
+
+        static constexpr size_t kChunk = 64 * 1024;
+        printf("Codecs (as selected by <Codec> in a pak manifest), streamed in %zu KiB chunks:\n",
+               kChunk / 1024);
+        for (const char* name : {"lz4", "lz4:9", "zstd:3", "zstd:19", "gzip", "lzma"}) {
+            const auto settings = *Codecs::FromString(name);
+            Timings encode, decode, stream;
+            std::optional<std::vector<u8>> compressed;
+            for (u32 i = 0; i < iterations; ++i) {
+                encode.Add(Measure([&] { compressed = Codecs::Compress(image, settings); }));
+            }
+            if (!compressed) {
+                printf("  %-24s compression failed\n", name);
+                valid = false;
+                continue;
+            }
+
+            std::vector<u8> output(image.size());
+            bool decoded = true;
+            for (u32 i = 0; i < iterations; ++i) {
+                decode.Add(Measure([&] {
+                    decoded &= Codecs::DecompressInto(settings.Type, *compressed, output);
+                }));
+            }
+            decoded &= output == image;
+
+            // The way ContentManager reads loose paks: fixed chunks into the final buffer
+            std::ranges::fill(output, 0);
+            for (u32 i = 0; i < iterations; ++i) {
+                stream.Add(Measure([&] {
+                    StreamDecoder decoder(settings.Type, output);
+                    const std::span<const u8> input(*compressed);
+                    for (size_t offset = 0; offset < input.size(); offset += kChunk) {
+                        const auto count = std::min(kChunk, input.size() - offset);
+                        decoder.Feed(input.subspan(offset, count));
+                    }
+                    decoded &= decoder.Finished();
+                }));
+            }
+            decoded &= output == image;
+            valid &= decoded;
+
+            printf("  %-24s encode %7.1f MiB/s | decode %7.1f MiB/s | streamed %7.1f MiB/s | "
+                   "ratio %5.2f:1%s\n",
+                   name,
+                   mib / (encode.Mean() / 1000.0),
+                   mib / (decode.Mean() / 1000.0),
+                   mib / (stream.Mean() / 1000.0),
+                   CAST<f64>(image.size()) / CAST<f64>(compressed->size()),
+                   decoded ? "" : " | ROUND TRIP FAILED");
+        }
+        return valid;
+    }
+}  // namespace XBench
@@ -0,0 +1,129 @@
+// Author: Jake Rieger
+// Created: 12/8/2024.
+//
+
+#pragma once
+
+#include "BenchUtils.hpp"
+
+#include <ContentHash.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sha256.h>
+#include <sstream>
+#include <thread>
+
+namespace XBench {
+    /// @brief The previous build cache checksum: SHA-256 over 4 KiB ifstream reads, formatted
+    /// as hex. Kept here as the baseline.
+    static str ChecksumSha256(const std::filesystem::path& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        SHA256 sha256;
+        std::vector<char> buffer(4096);
+        while (file.read(buffer.data(), CAST<std::streamsize>(buffer.size())) ||
+               file.gcount() > 0) {
+            sha256.add(buffer.data(), file.gcount());
+        }
+        u8 hash[32];
+        sha256.getHash(hash);
+        std::ostringstream result;
+        result << std::hex << std::setfill('0');
+        for (const u8 byte : hash) {
+            result << std::setw(2) << CAST<int>(byte);
+        }
+        return result.str();
+    }
+
+    /// @brief Writes about `totalMiB` of source files to `directory`: half as small files (4 to
+    /// 256 KiB, like scripts and sprites), half as 64 MiB files (like audio and texture sheets)
+    /// that span several hash chunks.
+    static std::vector<std::filesystem::path>
+    WriteHashCorpus(const std::filesystem::path& directory, u32 totalMiB) {
+        std::filesystem::create_directories(directory);
+        std::vector<std::filesystem::path> files;
+        u32 seed         = 0x2545F491;
+        const auto write = [&](size_t size) {
+            std::vector<u8> data(size);
+            for (auto& byte : data) {
+                seed = seed * 1664525u + 1013904223u;
+                byte = CAST<u8>(seed >> 24);
+            }
+            const auto name = directory / ("source" + std::to_string(files.size()) + ".bin");
+            std::ofstream out(name, std::ios::binary | std::ios::trunc);
+            out.write(RCAST<const char*>(data.data()), CAST<std::streamsize>(data.size()));
+            if (!out.good()) { return false; }
+            files.push_back(name);
+            return true;
+        };
+
+        const u64 total = CAST<u64>(totalMiB) * 1024 * 1024;
+        const u64 large = std::min<u64>(64ull * 1024 * 1024, total / 2);
+        u64 written     = 0;
+        while (large > 0 && written + large <= total / 2) {
+            if (!write(large)) { return {}; }
+            written += large;
+        }
+        while (written < total) {
+            seed            = seed * 1664525u + 1013904223u;
+            const u64 small = std::min<u64>((4 + (seed >> 8) % 253) * 1024, total - written);
+            if (!write(small)) { return {}; }
+            written += small;
+        }
+        return files;
+    }
+
+    /// @brief Hashes a synthetic source tree the way XPak checks for changed sources, with the
+    /// old SHA-256 checksum and with XXH3 over mapped files on 1 and `threads` threads. Timings
+    /// are with the files in the page cache. Returns false if the XXH3 digests differ between
+    /// thread counts.
+    static bool RunHashBench(u32 totalMiB, u32 iterations, u32 threads) {
+        if (threads == 0) { threads = std::max(1u, std::thread::hardware_concurrency()); }
+        const auto folder = std::filesystem::temp_directory_path() / "XBenchHashes";
+        const auto files  = WriteHashCorpus(folder, totalMiB);
+        if (files.empty()) {
+            printf("Unable to write benchmark files to %s\n", folder.string().c_str());
+            return false;
+        }
+        printf("Source hashing: %u MiB in %zu files, %zu MiB chunks, %u threads\n",
+               totalMiB,
+               files.size(),
+               ContentHash::kChunkSize / (1024 * 1024),
+               threads);
+
+        std::vector<ContentHash> serial(files.size()), parallel(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            serial[i] = ContentHash::File(files[i], 1).value_or(ContentHash {});  // Warms the cache
+        }
+
+        const auto mib = CAST<f64>(totalMiB);
+        const auto run = [&](const char* label, const auto& hash) {
+            Timings timings;
+            for (u32 i = 0; i < iterations; ++i) {
+                timings.Add(Measure([&] {
+                    for (size_t f = 0; f < files.size(); ++f) {
+                        hash(f);
+                    }
+                }));
+            }
+            printf("  %-24s %8.1f ms | %8.1f MiB/s\n",
+                   label,
+                   timings.Mean(),
+                   mib / (timings.Mean() / 1000.0));
+        };
+
+        run("SHA-256, ifstream", [&](size_t f) { (void)ChecksumSha256(files[f]); });
+        run("XXH3, mapped, 1 thread",
+            [&](size_t f) { serial[f] = ContentHash::File(files[f], 1).value_or(ContentHash {}); });
+        run("XXH3, mapped, N threads", [&](size_t f) {
+            parallel[f] = ContentHash::File(files[f], threads).value_or(ContentHash {});
+        });
+
+        const bool valid = serial == parallel;
+        if (!valid) { printf("  XXH3 digests differ between 1 and %u threads\n", threads); }
+
+        std::error_code error;
+        std::filesystem::remove_all(folder, error);
+        return valid;
+    }
+}  // namespace XBench
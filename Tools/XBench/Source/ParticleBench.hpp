@@ -0,0 +1,65 @@
+// Author: Jake Rieger
+// Created: 12/2/2024.
+//
+
+#pragma once
+
+#include "BenchUtils.hpp"
+
+#include <ParticleSystem.hpp>
+#include <SpriteBatch.hpp>
+
+namespace XBench {
+    /// @brief Keeps a pool saturated at `count` particles and times one 60 Hz frame of work:
+    /// respawning the dead, simulating, and writing instance data in SpriteBatch-sized chunks
+    /// (everything ParticleEmitter does per frame except the GL upload).
+    static void RunParticleBench(u32 count, u32 frames) {
+        constexpr f32 kFrameTime   = 1.f / 60.f;
+        constexpr f64 kFrameBudget = 1000.0 / 60.0;
+
+        Xen::ParticleSettings settings;
+        settings.MaxParticles     = count;
+        settings.Lifetime         = 2.f;
+        settings.LifetimeVariance = 1.5f;
+        settings.Speed            = 50.f;
+        settings.SpeedVariance    = 25.f;
+        settings.Gravity          = glm::vec2(0.f, -9.8f);
+        settings.StartColor       = glm::vec4(1.f, 0.8f, 0.2f, 1.f);
+        settings.EndColor         = glm::vec4(1.f, 0.f, 0.f, 0.f);
+
+        Xen::ParticlePool pool(count);
+        std::vector<Xen::SpriteInstance> instances(Xen::SpriteBatch::kDefaultCapacity);
+        const u32 chunk = CAST<u32>(instances.size());
+
+        Timings emit, simulate, write, total;
+        u64 simulated = 0;
+        pool.Emit(count, 0.f, 0.f, settings);
+        for (u32 frame = 0; frame < frames; ++frame) {
+            const f64 simulateMs = Measure([&] { pool.Simulate(kFrameTime, settings); });
+            simulated += pool.GetCount();
+            const f64 emitMs =
+              Measure([&] { pool.Emit(count - pool.GetCount(), 0.f, 0.f, settings); });
+            const f64 writeMs = Measure([&] {
+                for (u32 first = 0; first < pool.GetCount(); first += chunk) {
+                    const u32 n = std::min(chunk, pool.GetCount() - first);
+                    pool.WriteInstances(instances.data(), first, n, 1.f);
+                }
+            });
+
+            simulate.Add(simulateMs);
+            emit.Add(emitMs);
+            write.Add(writeMs);
+            total.Add(simulateMs + emitMs + writeMs);
+        }
+
+        printf("Particles: %u live, %u frames @ 60 Hz\n", count, frames);
+        simulate.Print("Simulate + compact");
+        emit.Print("Emit");
+        write.Print("Write instances");
+        total.Print("Frame total");
+        printf("  Throughput: %.1f M particles/s | budget %.2f ms -> %s\n",
+               CAST<f64>(simulated) / (total.Mean() * frames) / 1000.0,
+               kFrameBudget,
+               total.Mean() <= kFrameBudget ? "PASS" : "FAIL");
+    }
+}  // namespace XBench
@@ -0,0 +1,132 @@
+// Author: Jake Rieger
+// Created: 12/7/2024.
+//
+
+#pragma once
+
+#include "BenchUtils.hpp"
+
+#include <Compression.hpp>
+#include <ContentManager.hpp>
+#include <PakFile.hpp>
+#include <filesystem>
+#include <fstream>
+
+namespace XBench {
+    /// @brief Writes `count` loose texture assets to `directory` the way XPak lays them out. All
+    /// assets share one LZMA payload so setup stays fast; every load still decodes its own copy.
+    static bool WriteSceneAssets(const std::filesystem::path& directory, u32 count, u32 size) {
+        std::vector<u8> payload(size);
+        u32 seed = 0x9E3779B9;
+        for (auto& byte : payload) {
+            seed = seed * 1664525u + 1013904223u;
+            byte = CAST<u8>((seed >> 24) & 0x3F);  // Roughly 2:1 under LZMA, like texture data
+        }
+        auto compressed = LZMA::Compress(payload);
+        if (!compressed) { return false; }
+
+        std::filesystem::create_directories(directory);
+        for (u32 i = 0; i < count; ++i) {
+            const auto name    = directory / ("asset" + std::to_string(i));
+            const auto pakFile = std::filesystem::path(name).replace_extension(".xpkf");
+            PakFile::Write(*compressed, pakFile, Codec::LZMA, size);
+            std::ofstream metadata(std::filesystem::path(name).replace_extension(".xmdf"));
+            metadata << "<?xml version=\"1.0\"?>\n<Metadata>\n\t<type>Texture</type>\n"
+                     << "\t<width>" << size / 4 << "</width>\n\t<height>1</height>\n</Metadata>\n";
+            if (!metadata.good()) { return false; }
+        }
+        return true;
+    }
+
+    /// @brief Alternates between two levels that share `sharedPercent` of their `assetsPerScene`
+    /// assets, driving the content system the way Scene::Load/Destroy do: tag and prefetch the
+    /// next level, take references, then release the previous level. Compares a fresh
+    /// ContentManager per scene (the old behaviour) against one shared across scenes.
+    static void RunSceneBench(u32 assetsPerScene,
+                              u32 assetKiB,
+                              u32 sharedPercent,
+                              u32 transitions) {
+        sharedPercent     = std::min(sharedPercent, 100u);
+        const u32 unique  = assetsPerScene * (100 - sharedPercent) / 100;
+        const u32 size    = assetKiB * 1024;
+        const auto folder = std::filesystem::temp_directory_path() / "XBenchScenes";
+        if (!WriteSceneAssets(folder, assetsPerScene + unique, size)) {
+            printf("Unable to write benchmark assets to %s\n", folder.string().c_str());
+            return;
+        }
+
+        // Level 0 uses assets [0, n), level 1 uses [unique, unique + n)
+        const auto levelAssets = [&](u32 level) {
+            std::vector<str> names;
+            for (u32 i = 0; i < assetsPerScene; ++i) {
+                names.push_back("asset" + std::to_string(level * unique + i));
+            }
+            return names;
+        };
+        const std::vector<str> levels[2] = {levelAssets(0), levelAssets(1)};
+        const str tags[2]                = {"Level0", "Level1"};
+
+        const auto loadLevel = [&](Xen::ContentManager& content, u32 level) {
+            std::vector<Shared<Xen::Asset>> references;
+            for (const auto& name : levels[level]) {
+                content.Tag(name, tags[level]);
+                content.LoadAssetAsync(name, Xen::LoadPriority::High);
+            }
+            for (const auto& name : levels[level]) {
+                if (auto asset = content.LoadAsset(name)) { references.push_back(*asset); }
+            }
+            return references;
+        };
+
+        printf("Scene transitions: %u assets of %u KiB per scene, %u%% shared, %u transitions\n",
+               assetsPerScene,
+               assetKiB,
+               sharedPercent,
+               transitions);
+
+        {
+            Timings timings;
+            u64 loaded   = 0;
+            auto content = std::make_unique<Xen::ContentManager>(folder);
+            auto scene   = loadLevel(*content, 0);
+            for (u32 i = 1; i <= transitions; ++i) {
+                timings.Add(Measure([&] {
+                    scene.clear();
+                    content = std::make_unique<Xen::ContentManager>(folder);
+                    scene   = loadLevel(*content, i % 2);
+                }));
+                loaded += content->GetStats().LoadedBytes;
+            }
+            timings.Print("Manager per scene");
+            printf("  %-24s %8.2f MiB loaded per transition\n",
+                   "",
+                   CAST<f64>(loaded) / (1024.0 * 1024.0) / transitions);
+        }
+
+        {
+            Timings timings;
+            Xen::ContentManager content(folder);
+            auto scene         = loadLevel(content, 0);
+            const u64 baseline = content.GetStats().LoadedBytes;
+            for (u32 i = 1; i <= transitions; ++i) {
+                timings.Add(Measure([&] {
+                    auto next = loadLevel(content, i % 2);
+                    scene     = std::move(next);
+                    content.ReleaseTag(tags[(i + 1) % 2]);
+                    content.Update();
+                }));
+            }
+            const auto stats = content.GetStats();
+            timings.Print("Shared manager");
+            printf("  %-24s %8.2f MiB loaded per transition | %llu evictions | %.2f MiB "
+                   "resident\n",
+                   "",
+                   CAST<f64>(stats.LoadedBytes - baseline) / (1024.0 * 1024.0) / transitions,
+                   CAST<unsigned long long>(stats.Evictions),
+                   CAST<f64>(stats.ResidentBytes) / (1024.0 * 1024.0));
+        }
+
+        std::error_code error;
+        std::filesystem::remove_all(folder, error);
+    }
+}  // namespace XBench
@@ -0,0 +1,126 @@
+// Author: Jake Rieger
+// Created: 12/5/2024.
+//
+
+#pragma once
+
+#include "BenchUtils.hpp"
+
+#include <MipGenerator.hpp>
+#include <TextureEncoder.hpp>
+#include <cmath>
+#include <thread>
+
+namespace XBench {
+    /// @brief Deterministic RGBA test card: smooth gradients, hard edges, fine noise and an alpha
+    /// ramp, so every encoder path (flat, two-color and noisy blocks) gets exercised.
+    static std::vector<u8> MakeTestImage(u32 size) {
+        std::vector<u8> image(CAST<size_t>(size) * size * 4);
+        u32 seed = 0x12345678;
+        for (u32 y = 0; y < size; ++y) {
+            for (u32 x = 0; x < size; ++x) {
+                seed             = seed * 1664525u + 1013904223u;
+                u8* texel        = &image[(CAST<size_t>(y) * size + x) * 4];
+                const u32 noise  = (seed >> 24) & 15;
+                const bool check = ((x / 32) + (y / 32)) % 2 == 0;
+                texel[0]         = CAST<u8>(x * 255 / size);
+                texel[1]         = CAST<u8>(check ? 220 : 40);
+                texel[2]         = CAST<u8>(std::min(255u, y * 255 / size + noise));
+                texel[3]         = CAST<u8>(x < size / 2 ? 255 : (y * 255 / size));
+            }
+        }
+        return image;
+    }
+
+    /// @brief PSNR of `b` against `a` over the first `channels` channels. Three-channel
+    /// comparisons skip texels that BC1 stores as transparent black.
+    static f64 Psnr(const u8* a, const u8* b, size_t texels, u32 channels) {
+        f64 error    = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < texels; ++i) {
+            if (channels == 3 && a[i * 4 + 3] < 128) { continue; }
+            ++count;
+            for (u32 c = 0; c < channels; ++c) {
+                const f64 d = CAST<f64>(a[i * 4 + c]) - CAST<f64>(b[i * 4 + c]);
+                error += d * d;
+            }
+        }
+        if (error == 0.0) { return INFINITY; }
+        const f64 mse = error / CAST<f64>(count * channels);
+        return 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+
+    static u64 HashBytes(const std::vector<u8>& data) {
+        u64 hash = 14695981039346656037ull;
+        for (const u8 byte : data) {
+            hash = (hash ^ byte) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /// @brief Encodes a full mip chain of a synthetic `size`² texture in each block format and
+    /// quality, reporting throughput, base-level PSNR and an output hash. Every configuration
+    /// is encoded single-threaded and with `threads` workers; the outputs must match byte for
+    /// byte, so the hashes double as golden values for cross-machine comparisons.
+    static bool RunTextureBench(u32 size, u32 iterations, u32 threads) {
+        if (threads == 0) { threads = std::max(1u, std::thread::hardware_concurrency()); }
+        auto image        = MakeTestImage(size);
+        const u32 levels  = MipGenerator::Generate(image, size, size);
+        const auto pixels = CAST<f64>(image.size() / 4) / 1e6;
+        printf("Texture encode: %ux%u RGBA8 with %u mips, %u threads\n",
+               size,
+               size,
+               levels,
+               threads);
+
+        static constexpr TextureFormat kFormats[] = {
+          TextureFormat::BC1,
+          TextureFormat::BC3,
+          TextureFormat::BC7,
+        };
+        static constexpr EncodeQuality kQualities[] = {
+          EncodeQuality::Fast,
+          EncodeQuality::Normal,
+          EncodeQuality::High,
+        };
+        static constexpr const char* kQualityNames[] = {"fast", "normal", "high"};
+
+        bool exact = true;
+        for (const auto format : kFormats) {
+            for (const auto quality : kQualities) {
+                const auto label =
+                  TextureFormats::ToString(format) + " " + kQualityNames[CAST<u32>(quality)];
+
+                const auto reference =
+                  TextureEncoder::Encode(image, size, size, levels, format, quality, 1);
+                Timings timings;
+                std::vector<u8> encoded;
+                for (u32 i = 0; i < iterations; ++i) {
+                    timings.Add(Measure([&] {
+                        encoded = TextureEncoder::Encode(image,
+                                                         size,
+                                                         size,
+                                                         levels,
+                                                         format,
+                                                         quality,
+                                                         threads);
+                    }));
+                }
+
+                const auto decoded = TextureEncoder::Decode(encoded, size, size, 1, format);
+                const u32 channels = format == TextureFormat::BC1 ? 3 : 4;
+                const bool matches = encoded == reference;
+                exact &= matches;
+
+                timings.Print(label.c_str());
+                printf("  %-24s %8.1f Mpix/s | PSNR %6.2f dB | hash %016llx%s\n",
+                       "",
+                       pixels / (timings.Mean() / 1000.0),
+                       Psnr(image.data(), decoded.data(), CAST<size_t>(size) * size, channels),
+                       CAST<unsigned long long>(HashBytes(encoded)),
+                       matches ? "" : " | MISMATCH vs 1 thread");
+            }
+        }
+        return exact;
+    }
+}  // namespace XBench
@@ -0,0 +1,83 @@
+// Author: Jake Rieger
+// Created: 12/2/2024.
+//
+
+#include "CompressionBench.hpp"
+#include "HashBench.hpp"
+#include "ParticleBench.hpp"
+#include "SceneBench.hpp"
+#include "TextureBench.hpp"
+
+#include <Types.hpp>
+#include <CLI/CLI.hpp>
+
+int main(int argc, char* argv[]) {
+    CLI::App app("XEN Engine CPU benchmarks.", "XBench");
+    argv = app.ensure_utf8(argv);
+
+    u32 particleCount  = 1000000;
+    u32 particleFrames = 600;
+    auto* particlesCmd = app.add_subcommand("particles", "Particle simulation benchmark.");
+    particlesCmd->add_option("-n,--count", particleCount, "Live particle count");
+    particlesCmd->add_option("-f,--frames", particleFrames, "Frames to simulate");
+    particlesCmd->callback([&]() { XBench::RunParticleBench(particleCount, particleFrames); });
+
+    u32 textureSize       = 1024;
+    u32 textureIterations = 3;
+    u32 textureThreads    = 0;
+    int result            = 0;
+    auto* texturesCmd     = app.add_subcommand("textures", "Block compression benchmark.");
+    texturesCmd->add_option("-s,--size", textureSize, "Texture edge length in pixels");
+    texturesCmd->add_option("-i,--iterations", textureIterations, "Encodes per configuration");
+    texturesCmd->add_option("-j,--threads", textureThreads, "Worker threads (0 = all cores)");
+    texturesCmd->callback([&]() {
+        if (!XBench::RunTextureBench(textureSize, textureIterations, textureThreads)) {
+            result = 1;
+        }
+    });
+
+    u32 compressionSize       = 2048;
+    u32 compressionIterations = 3;
+    u32 compressionThreads    = 0;
+    auto* compressionCmd      = app.add_subcommand("compression", "Codec throughput benchmark.");
+    compressionCmd->add_option("-s,--size", compressionSize, "Texture edge length in pixels");
+    compressionCmd->add_option("-i,--iterations", compressionIterations, "Runs per configuration");
+    compressionCmd->add_option("-j,--threads", compressionThreads, "Threads (0 = all cores)");
+    compressionCmd->callback([&]() {
+        if (!XBench::RunCompressionBench(compressionSize,
+                                         compressionIterations,
+                                         compressionThreads)) {
+            result = 1;
+        }
+    });
+
+    u32 hashSize       = 512;
+    u32 hashIterations = 3;
+    u32 hashThreads    = 0;
+    auto* hashingCmd   = app.add_subcommand("hashing", "Source change detection benchmark.");
+    hashingCmd->add_option("-s,--size", hashSize, "Corpus size in MiB");
+    hashingCmd->add_option("-i,--iterations", hashIterations, "Passes per configuration");
+    hashingCmd->add_option("-j,--threads", hashThreads, "Threads (0 = all cores)");
+    hashingCmd->callback([&]() {
+        if (!XBench::RunHashBench(hashSize, hashIterations, hashThreads)) { result = 1; }
+    });
+
+    u32 sceneAssets      = 100;
+    u32 sceneAssetSize   = 256;
+    u32 sceneShared      = 90;
+    u32 sceneTransitions = 10;
+    auto* scenesCmd      = app.add_subcommand("scenes", "Scene transition content benchmark.");
+    scenesCmd->add_option("-n,--assets", sceneAssets, "Assets per scene");
+    scenesCmd->add_option("-s,--size", sceneAssetSize, "Asset size in KiB");
+    scenesCmd->add_option("-p,--shared", sceneShared, "Percentage of assets both scenes use");
+    scenesCmd->add_option("-t,--transitions", sceneTransitions, "Scene transitions to time");
+    scenesCmd->callback([&]() {
+        XBench::RunSceneBench(sceneAssets, sceneAssetSize, sceneShared, sceneTransitions);
+    });
+
+    app.require_subcommand(1);
+
+    CLI11_PARSE(app, argc, argv);
+
+    return result;
+}
@@ -0,0 +1,195 @@
+// Author: Jake Rieger
+// Created: 12/6/2024.
+//
+
+#pragma once
+
+#include <ArchiveFormat.hpp>
+#include <Compression.hpp>
+#include <IO.hpp>
+#include <Types.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <pugixml.hpp>
+#include <sha256.h>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Links built .xpkf/.xmdf pairs and trained .xdict dictionaries into a single archive
+/// (see ArchiveFormat.hpp). The loose files stay on disk as the incremental build output; only
+/// the archive needs to ship. Byte-identical payloads are stored once, with every entry that
+/// has them pointing at the same offset.
+class ArchiveFile {
+public:
+    struct Input {
+        str Name;
+        std::filesystem::path PakFile;
+        std::filesystem::path MetadataFile;
+    };
+
+    /// @brief Writes a temporary file and renames it over `outPath`, so a game that has the old
+    /// archive mapped keeps reading it intact rather than having it truncated underneath it.
+    static bool Write(const std::vector<Input>& inputs,
+                      const std::vector<std::filesystem::path>& dictionaries,
+                      const std::filesystem::path& outPath) {
+        auto tempPath = outPath;
+        tempPath += ".tmp";
+        std::error_code error;
+        if (!WriteTo(inputs, dictionaries, tempPath)) {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        std::filesystem::rename(tempPath, outPath, error);
+        if (error) {
+            std::cerr << "  |  [ERROR] Unable to replace archive: " << outPath.string() << " ("
+                      << error.message() << ")\n";
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static bool WriteTo(const std::vector<Input>& inputs,
+                        const std::vector<std::filesystem::path>& dictionaries,
+                        const std::filesystem::path& outPath) {
+        using namespace ArchiveFormat;
+
+        std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "  |  [ERROR] Unable to open archive: " << outPath.string() << '\n';
+            return false;
+        }
+
+        u64 position     = 0;
+        const auto padTo = [&](u64 offset) {
+            static constexpr char zeros[kAlignment] = {};
+            while (position < offset) {
+                const auto count = std::min<u64>(offset - position, kAlignment);
+                out.write(zeros, CAST<std::streamsize>(count));
+                position += count;
+            }
+        };
+        const auto append = [&](const void* data, u64 size) {
+            out.write(CAST<const char*>(data), CAST<std::streamsize>(size));
+            position += size;
+        };
+
+        // Header is written last, once the offsets are known
+        padTo(kAlignment);
+
+        std::vector<ArchiveEntry> entries;
+        std::vector<str> names;
+        std::vector<u8> metadataBlock;
+        std::unordered_map<str, u64> payloadOffsets;  // SHA-256 of codec and payload -> offset
+        entries.reserve(inputs.size() + dictionaries.size());
+        for (const auto& input : inputs) {
+            const auto bytes = IO::ReadBytes(input.PakFile);
+            if (!bytes || bytes->size() < 16 || memcmp(bytes->data(), "XPAK", 4) != 0 ||
+                !Codecs::IsValid((*bytes)[7])) {
+                std::cerr << "  |  [ERROR] Invalid pak file: " << input.PakFile.string() << '\n';
+                return false;
+            }
+            std::unordered_map<str, str> metadata;
+            if (!ReadMetadataFile(input.MetadataFile, metadata)) {
+                std::cerr << "  |  [ERROR] Invalid metadata file: " << input.MetadataFile.string()
+                          << '\n';
+                return false;
+            }
+
+            ArchiveEntry entry {};
+            entry.Id    = HashName(input.Name);
+            entry.Codec = (*bytes)[7];
+            entry.Size  = bytes->size() - 16;
+
+            SHA256 sha256;
+            sha256.add(&entry.Codec, 1);
+            sha256.add(bytes->data() + 16, entry.Size);
+            const auto [stored, isNew] = payloadOffsets.try_emplace(sha256.getHash(), 0);
+            if (isNew) {
+                padTo(Align(position, entry.Codec == CAST<u8>(Codec::None) ? kAlignment
+                                                                              : kPackedAlignment));
+                stored->second = position;
+                append(bytes->data() + 16, entry.Size);
+            }
+            entry.Offset = stored->second;
+            memcpy(&entry.OriginalSize, bytes->data() + 8, 8);
+            entry.MetadataOffset = metadataBlock.size();
+            WriteMetadata(metadata, metadataBlock);
+            entry.MetadataSize = CAST<u32>(metadataBlock.size() - entry.MetadataOffset);
+            entries.push_back(entry);
+            names.push_back(input.Name);
+        }
+
+        for (const auto& dictionary : dictionaries) {
+            const auto bytes = IO::ReadBytes(dictionary);
+            if (!bytes || bytes->empty()) {
+                std::cerr << "  |  [ERROR] Invalid dictionary: " << dictionary.string() << '\n';
+                return false;
+            }
+
+            // Copied into the decoder's own tables at mount, so never used in place
+            padTo(Align(position, kPackedAlignment));
+            ArchiveEntry entry {};
+            entry.Id             = HashName("dictionary:" + dictionary.stem().string());
+            entry.Offset         = position;
+            entry.Size           = bytes->size();
+            entry.OriginalSize   = bytes->size();
+            entry.Codec          = CAST<u8>(Codec::None);
+            entry.Flags          = kEntryDictionary;
+            entry.MetadataOffset = metadataBlock.size();
+            WriteMetadata({}, metadataBlock);
+            entry.MetadataSize = CAST<u32>(metadataBlock.size() - entry.MetadataOffset);
+            entries.push_back(entry);
+            names.push_back("dictionary:" + dictionary.stem().string());
+
+            append(bytes->data(), entry.Size);
+        }
+
+        // Sort the table of contents by Id, refusing to ship two names that hash alike
+        std::vector<size_t> order(entries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::sort(order, [&](size_t a, size_t b) { return entries[a].Id < entries[b].Id; });
+        for (size_t i = 1; i < order.size(); ++i) {
+            if (entries[order[i]].Id == entries[order[i - 1]].Id) {
+                std::cerr << "  |  [ERROR] Asset names '" << names[order[i - 1]] << "' and '"
+                          << names[order[i]] << "' have the same archive ID\n";
+                return false;
+            }
+        }
+
+        ArchiveHeader header {};
+        memcpy(header.Magic, kMagic, 4);
+        header.Version        = kVersion;
+        header.EntryCount     = CAST<u32>(entries.size());
+        header.MetadataOffset = position;
+        header.MetadataSize   = metadataBlock.size();
+        append(metadataBlock.data(), metadataBlock.size());
+
+        padTo((position + 7) & ~7ull);  // The runtime reads entries in place
+        header.TocOffset = position;
+        for (const auto index : order) {
+            append(&entries[index], sizeof(ArchiveEntry));
+        }
+
+        out.seekp(0);
+        out.write(RCAST<const char*>(&header), sizeof(header));
+        out.close();
+        return out.good();
+    }
+
+    static bool ReadMetadataFile(const std::filesystem::path& filename,
+                                 std::unordered_map<str, str>& metadata) {
+        pugi::xml_document doc;
+        if (!doc.load_file(filename.string().c_str())) { return false; }
+        const auto root = doc.first_child();
+        if (!root) { return false; }
+        for (const auto& node : root.children()) {
+            metadata.insert_or_assign(node.name(), node.text().as_string());
+        }
+        return true;
+    }
+};
@@ -0,0 +1,196 @@
+// Author: Jake Rieger
+// Created: 12/8/2024.
+//
+
+#pragma once
+
+#include "ContentHash.hpp"
+
+#include <IO.hpp>
+#include <Types.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <span>
+#include <vector>
+
+/// @brief Built assets shared between machines, addressed by a hash of every input that shapes
+/// them (see BuildCache::AssetEntry::InputHash). A build checks here before processing an asset
+/// and publishes what it had to build itself.
+class IArtifactStore {
+public:
+    virtual ~IArtifactStore() = default;
+
+    /// @brief Writes the artifact stored under `key` to `pakFile` and `metadataFile`. False on a
+    /// miss or a damaged artifact.
+    virtual bool Fetch(const ContentHash& key,
+                       const std::filesystem::path& pakFile,
+                       const std::filesystem::path& metadataFile) = 0;
+
+    /// @brief Stores the given outputs under `key`. Losing a race to publish the same key is
+    /// fine; both copies are identical.
+    virtual void Publish(const ContentHash& key,
+                         const std::filesystem::path& pakFile,
+                         const std::filesystem::path& metadataFile) = 0;
+
+    /// @brief Drops least recently used artifacts until the store fits its size limit.
+    virtual void Trim() = 0;
+};
+
+/// @brief Artifact store in a directory, local or on a network share. Each artifact is one file,
+/// `<root>/<first two hex digits>/<key>.xart`, holding the pak and metadata files behind a small
+/// header with a checksum. Publishing writes to `<root>/tmp` and renames into place, so readers
+/// never see a partial artifact. Fetching touches the artifact's mtime, which Trim uses as the
+/// last-use time.
+class DirectoryArtifactStore final : public IArtifactStore {
+public:
+    static constexpr u64 kDefaultMaxSize = 10ull << 30;
+
+    explicit DirectoryArtifactStore(std::filesystem::path root, u64 maxSize = kDefaultMaxSize)
+        : mRoot(std::move(root)), mMaxSize(maxSize) {}
+
+    bool Fetch(const ContentHash& key,
+               const std::filesystem::path& pakFile,
+               const std::filesystem::path& metadataFile) override {
+        const auto artifactFile = GetArtifactFile(key);
+        const auto bytes        = IO::ReadBytes(artifactFile);
+        if (!bytes) { return false; }
+
+        Header header;
+        if (bytes->size() < sizeof(header)) { return false; }
+        memcpy(&header, bytes->data(), sizeof(header));
+        const std::span<const u8> body(bytes->data() + sizeof(header),
+                                       bytes->size() - sizeof(header));
+        if (memcmp(header.Magic, kMagic, 4) != 0 || header.Version != kVersion ||
+            header.PakSize + header.MetadataSize != body.size() ||
+            ContentHash::Bytes(body, 1) != header.Checksum) {
+            std::error_code error;
+            std::filesystem::remove(artifactFile, error);  // Damaged; the next build republishes
+            return false;
+        }
+
+        std::filesystem::create_directories(pakFile.parent_path());
+        if (!WriteFile(pakFile, body.first(header.PakSize)) ||
+            !WriteFile(metadataFile, body.subspan(header.PakSize))) {
+            return false;
+        }
+        std::error_code error;
+        std::filesystem::last_write_time(artifactFile,
+                                         std::filesystem::file_time_type::clock::now(),
+                                         error);
+        return true;
+    }
+
+    void Publish(const ContentHash& key,
+                 const std::filesystem::path& pakFile,
+                 const std::filesystem::path& metadataFile) override {
+        const auto artifactFile = GetArtifactFile(key);
+        std::error_code error;
+        if (std::filesystem::exists(artifactFile, error)) { return; }
+
+        const auto pak      = IO::ReadBytes(pakFile);
+        const auto metadata = IO::ReadBytes(metadataFile);
+        if (!pak || !metadata) { return; }
+        std::vector<u8> body;
+        body.reserve(pak->size() + metadata->size());
+        body.insert(body.end(), pak->begin(), pak->end());
+        body.insert(body.end(), metadata->begin(), metadata->end());
+
+        Header header {};
+        memcpy(header.Magic, kMagic, 4);
+        header.Version      = kVersion;
+        header.PakSize      = pak->size();
+        header.MetadataSize = metadata->size();
+        header.Checksum     = ContentHash::Bytes(body, 1);
+
+        // Unique per writer, so machines publishing the same key never share a temporary file
+        const auto tempDir = mRoot / "tmp";
+        std::filesystem::create_directories(tempDir, error);
+        std::filesystem::create_directories(artifactFile.parent_path(), error);
+        std::random_device random;
+        const auto tempFile = tempDir / (key.ToString() + '.' + std::to_string(random()) +
+                                         std::to_string(random()) + ".tmp");
+        {
+            std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+            out.write(RCAST<const char*>(&header), sizeof(header));
+            out.write(RCAST<const char*>(body.data()), CAST<std::streamsize>(body.size()));
+            out.close();
+            if (!out.good()) {
+                std::filesystem::remove(tempFile, error);
+                return;
+            }
+        }
+        std::filesystem::rename(tempFile, artifactFile, error);
+        if (error) { std::filesystem::remove(tempFile, error); }
+    }
+
+    void Trim() override {
+        struct Artifact {
+            std::filesystem::path Path;
+            std::filesystem::file_time_type LastUse;
+            u64 Size;
+        };
+        std::vector<Artifact> artifacts;
+        u64 total = 0;
+        std::error_code error;
+        const auto staleBefore = std::filesystem::file_time_type::clock::now() - kTempLifetime;
+        for (auto it = std::filesystem::recursive_directory_iterator(mRoot, error);
+             it != std::filesystem::recursive_directory_iterator();
+             it.increment(error)) {
+            if (error) { break; }
+            if (!it->is_regular_file(error)) { continue; }
+            const auto lastUse = it->last_write_time(error);
+            if (it->path().extension() == ".tmp") {
+                // Left behind by a build that died mid-publish
+                if (lastUse < staleBefore) { std::filesystem::remove(it->path(), error); }
+                continue;
+            }
+            if (it->path().extension() != ".xart") { continue; }
+            const auto size = it->file_size(error);
+            artifacts.push_back({it->path(), lastUse, size});
+            total += size;
+        }
+        if (total <= mMaxSize) { return; }
+
+        std::ranges::sort(artifacts, [](const Artifact& a, const Artifact& b) {
+            return a.LastUse < b.LastUse;
+        });
+        for (const auto& artifact : artifacts) {
+            if (total <= mMaxSize) { break; }
+            if (std::filesystem::remove(artifact.Path, error)) { total -= artifact.Size; }
+        }
+    }
+
+private:
+    static constexpr char kMagic[4]     = {'X', 'A', 'R', 'T'};
+    static constexpr u32 kVersion       = 1;
+    static constexpr auto kTempLifetime = std::chrono::hours(1);
+
+    struct Header {
+        char Magic[4];
+        u32 Version;
+        u64 PakSize;
+        u64 MetadataSize;
+        ContentHash Checksum;  // Of everything after the header
+    };
+
+    static_assert(sizeof(Header) == 40);
+
+    std::filesystem::path mRoot;
+    u64 mMaxSize;
+
+    [[nodiscard]] std::filesystem::path GetArtifactFile(const ContentHash& key) const {
+        const auto name = key.ToString();
+        return mRoot / name.substr(0, 2) / (name + ".xart");
+    }
+
+    static bool WriteFile(const std::filesystem::path& filename, std::span<const u8> data) {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        out.write(RCAST<const char*>(data.data()), CAST<std::streamsize>(data.size()));
+        out.close();
+        return out.good();
+    }
+};
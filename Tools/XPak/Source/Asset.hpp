@@ -10,6 +10,9 @@
 enum class AssetType {
     Texture,
     Audio,
+    Tilemap,
+    Font,
+    Atlas,
     Data,
 };
 
@@ -18,6 +21,12 @@ static AssetType GetAssetTypeFromString(const str& assetType) {
         return AssetType::Texture;
     } else if (assetType == "Audio") {
         return AssetType::Audio;
+    } else if (assetType == "Tilemap") {
+        return AssetType::Tilemap;
+    } else if (assetType == "Font") {
+        return AssetType::Font;
+    } else if (assetType == "Atlas") {
+        return AssetType::Atlas;
     } else {
         return AssetType::Data;
     }
@@ -29,6 +38,12 @@ static str AssetTypeToString(const AssetType& type) {
             return "Texture";
         case AssetType::Audio:
             return "Audio";
+        case AssetType::Tilemap:
+            return "Tilemap";
+        case AssetType::Font:
+            return "Font";
+        case AssetType::Atlas:
+            return "Atlas";
         case AssetType::Data:
         default:
             return "Data";
@@ -39,10 +54,19 @@ struct Asset {
     str Name;
     AssetType Type;
     str Source;
+    /// @brief Processor options, read from any extra child elements of the manifest's <Asset>
+    /// node (e.g. <Size>48</Size>).
+    std::unordered_map<str, str> Settings;
 
     Asset(str name, const str& type, str source) {
         this->Name   = std::move(name);
         this->Type   = GetAssetTypeFromString(type);
         this->Source = std::move(source);
     }
+
+    [[nodiscard]] str GetSetting(const str& key, const str& fallback = "") const {
+        const auto it = Settings.find(key);
+        if (it == Settings.end() || it->second.empty()) { return fallback; }
+        return it->second;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,243 @@
+// Author: Jake Rieger
+// Created: 12/4/2024.
+//
+
+#pragma once
+
+#include "BuildError.hpp"
+#include "MipGenerator.hpp"
+#include "RectPacker.hpp"
+
+#include <Types.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <stb_image.h>
+
+/// @brief Packs every image in a directory into one or more RGBA8 atlas pages.
+///
+/// Pages are stored bottom-up (row 0 is the bottom row, matching how ProcessTexture flips images
+/// for OpenGL) and concatenated in the payload, each followed by its mip chain when mips are
+/// enabled. Each sprite is described by a `sprite<N>`
+/// metadata entry of the form:
+///
+///     page u0 v0 u1 v1 offsetX offsetY width height sourceWidth sourceHeight name
+///
+/// where offset/size give the trimmed rect inside the original image in pixels, measured from
+/// its bottom-left corner, and `name` is the image path relative to the atlas directory without
+/// its extension (e.g. "player/idle_0").
+class AtlasBuilder {
+public:
+    static std::vector<u8> Build(const std::filesystem::path& directory,
+                                 u32 padding,
+                                 bool trim,
+                                 u32 maxSize,
+                                 bool mips,
+                                 std::unordered_map<str, str>& metadata) {
+        auto sprites = LoadSprites(directory, trim);
+        if (sprites.empty()) { throw BuildError("Atlas directory contains no images"); }
+
+        // Pack tallest first (ties broken by name) so the layout is deterministic
+        std::vector<Sprite*> remaining;
+        for (auto& sprite : sprites) {
+            if (sprite.Width + padding > maxSize || sprite.Height + padding > maxSize) {
+                throw BuildError("Sprite '%s' does not fit in a %ux%u atlas page",
+                                 sprite.Name.c_str(),
+                                 maxSize,
+                                 maxSize);
+            }
+            remaining.push_back(&sprite);
+        }
+        std::ranges::sort(remaining, [](const Sprite* a, const Sprite* b) {
+            if (a->Height != b->Height) { return a->Height > b->Height; }
+            if (a->Width != b->Width) { return a->Width > b->Width; }
+            return a->Name < b->Name;
+        });
+
+        // A single page shrinks to the smallest size that holds everything; once sprites spill
+        // onto more pages, every page is maxSize so the loader can treat them uniformly
+        u32 pageWidth = maxSize, pageHeight = maxSize;
+        u32 pageCount = 0;
+        while (!remaining.empty()) {
+            u32 width = std::min(128u, maxSize), height = width;
+            while ((width < maxSize || height < maxSize) &&
+                   !PackPage(remaining, width, height, padding, pageCount, true).empty()) {
+                if (width <= height) {
+                    width = std::min(width * 2, maxSize);
+                } else {
+                    height = std::min(height * 2, maxSize);
+                }
+            }
+            remaining = PackPage(remaining, width, height, padding, pageCount, false);
+            if (pageCount == 0) {
+                pageWidth  = width;
+                pageHeight = height;
+            }
+            ++pageCount;
+        }
+        if (pageCount > 1) { pageWidth = pageHeight = maxSize; }
+
+        const size_t pageBytes = CAST<size_t>(pageWidth) * pageHeight * 4;
+        std::vector<std::vector<u8>> pages(pageCount, std::vector<u8>(pageBytes, 0));
+        const f32 invWidth  = 1.f / CAST<f32>(pageWidth);
+        const f32 invHeight = 1.f / CAST<f32>(pageHeight);
+
+        std::ranges::sort(sprites, {}, &Sprite::Name);
+        for (size_t i = 0; i < sprites.size(); ++i) {
+            const auto& sprite = sprites[i];
+            u8* page           = pages[sprite.Page].data();
+            for (u32 row = 0; row < sprite.Height; ++row) {
+                std::copy_n(sprite.Pixels.data() + CAST<size_t>(row) * sprite.Width * 4,
+                            CAST<size_t>(sprite.Width) * 4,
+                            page + (CAST<size_t>(sprite.Y + row) * pageWidth + sprite.X) * 4);
+            }
+
+            std::ostringstream entry;
+            entry << sprite.Page << ' ' << CAST<f32>(sprite.X) * invWidth << ' '
+                  << CAST<f32>(sprite.Y) * invHeight << ' '
+                  << CAST<f32>(sprite.X + sprite.Width) * invWidth << ' '
+                  << CAST<f32>(sprite.Y + sprite.Height) * invHeight << ' ' << sprite.OffsetX
+                  << ' ' << sprite.OffsetY << ' ' << sprite.Width << ' ' << sprite.Height << ' '
+                  << sprite.SourceWidth << ' ' << sprite.SourceHeight << ' ' << sprite.Name;
+            metadata.insert_or_assign("sprite" + std::to_string(i), entry.str());
+        }
+
+        u32 levels = 1;
+        std::vector<u8> result;
+        for (auto& page : pages) {
+            if (mips) { levels = MipGenerator::Generate(page, pageWidth, pageHeight); }
+            result.insert(result.end(), page.begin(), page.end());
+        }
+
+        metadata.insert_or_assign("width", std::to_string(pageWidth));
+        metadata.insert_or_assign("height", std::to_string(pageHeight));
+        metadata.insert_or_assign("pages", std::to_string(pageCount));
+        metadata.insert_or_assign("mips", std::to_string(levels));
+        metadata.insert_or_assign("sprites", std::to_string(sprites.size()));
+
+        return result;
+    }
+
+    /// @brief Lists the images an atlas built from `directory` would contain, sorted by path.
+    static std::vector<std::filesystem::path> ListMembers(const std::filesystem::path& directory) {
+        std::vector<std::filesystem::path> members;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+            if (!entry.is_regular_file()) { continue; }
+            auto extension = entry.path().extension().string();
+            std::ranges::transform(extension, extension.begin(), ::tolower);
+            if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" ||
+                extension == ".tga" || extension == ".bmp") {
+                members.push_back(entry.path());
+            }
+        }
+        std::ranges::sort(members);
+        return members;
+    }
+
+private:
+    struct Sprite {
+        str Name;
+        std::vector<u8> Pixels;  // Trimmed RGBA8, bottom-up
+        u32 Width;
+        u32 Height;
+        u32 OffsetX;
+        u32 OffsetY;
+        u32 SourceWidth;
+        u32 SourceHeight;
+        u32 Page;
+        u32 X;
+        u32 Y;
+    };
+
+    static std::vector<Sprite> LoadSprites(const std::filesystem::path& directory, bool trim) {
+        const auto members = ListMembers(directory);
+        std::vector<Sprite> sprites(members.size());
+
+        // Decoded on the calling build worker, since the build already runs one transform per
+        // -j worker
+        stbi_set_flip_vertically_on_load(true);
+        for (size_t i = 0; i < members.size(); ++i) {
+            sprites[i] = LoadSprite(directory, members[i], trim);
+        }
+        return sprites;
+    }
+
+    static Sprite LoadSprite(const std::filesystem::path& directory,
+                             const std::filesystem::path& file,
+                             bool trim) {
+        int width, height, channels;
+        stbi_uc* data = stbi_load(file.string().c_str(), &width, &height, &channels, 4);
+        if (!data) { throw BuildError("Failed to load image: %s", file.string().c_str()); }
+
+        Sprite sprite {};
+        auto name = std::filesystem::relative(file, directory);
+        name.replace_extension();
+        sprite.Name         = name.generic_string();
+        sprite.SourceWidth  = CAST<u32>(width);
+        sprite.SourceHeight = CAST<u32>(height);
+
+        // Shrink to the bounding box of non-transparent texels; fully transparent images keep
+        // their original size so they still resolve to a valid region
+        u32 minX = 0, minY = 0, maxX = width, maxY = height;
+        if (trim) {
+            u32 left = width, bottom = height, right = 0, top = 0;
+            for (u32 y = 0; y < CAST<u32>(height); ++y) {
+                for (u32 x = 0; x < CAST<u32>(width); ++x) {
+                    if (data[(CAST<size_t>(y) * width + x) * 4 + 3] == 0) { continue; }
+                    left   = std::min(left, x);
+                    right  = std::max(right, x + 1);
+                    bottom = std::min(bottom, y);
+                    top    = std::max(top, y + 1);
+                }
+            }
+            if (right > left && top > bottom) {
+                minX = left;
+                minY = bottom;
+                maxX = right;
+                maxY = top;
+            }
+        }
+
+        sprite.OffsetX = minX;
+        sprite.OffsetY = minY;
+        sprite.Width   = maxX - minX;
+        sprite.Height  = maxY - minY;
+        sprite.Pixels.resize(CAST<size_t>(sprite.Width) * sprite.Height * 4);
+        for (u32 row = 0; row < sprite.Height; ++row) {
+            memcpy(sprite.Pixels.data() + CAST<size_t>(row) * sprite.Width * 4,
+                   data + ((CAST<size_t>(minY + row) * width) + minX) * 4,
+                   CAST<size_t>(sprite.Width) * 4);
+        }
+        stbi_image_free(data);
+
+        return sprite;
+    }
+
+    /// @brief Packs as many of `sprites` as fit into one page and returns the ones that didn't.
+    /// With `probe` set, nothing is recorded and packing stops at the first miss.
+    static std::vector<Sprite*> PackPage(const std::vector<Sprite*>& sprites,
+                                         u32 width,
+                                         u32 height,
+                                         u32 padding,
+                                         u32 page,
+                                         bool probe) {
+        std::vector<Sprite*> overflow;
+        SkylinePacker packer(width, height);
+        for (auto* sprite : sprites) {
+            const auto rect = packer.Insert(sprite->Width + padding, sprite->Height + padding);
+            if (!rect.has_value()) {
+                overflow.push_back(sprite);
+                if (probe) { break; }
+                continue;
+            }
+            if (probe) { continue; }
+            sprite->Page = page;
+            sprite->X    = rect->X;
+            sprite->Y    = rect->Y;
+        }
+        return overflow;
+    }
+};
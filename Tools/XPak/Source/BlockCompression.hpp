@@ -0,0 +1,646 @@
+// Author: Jake Rieger
+// Created: 12/5/2024.
+//
+
+#pragma once
+
+#include <Types.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XPAK_BLOCKS_SSE 1
+#endif
+
+enum class EncodeQuality : u8 {
+    Fast,    // Bounding-box endpoints, no refinement
+    Normal,  // Principal-axis endpoints plus one least-squares refinement
+    High,    // Principal-axis endpoints, several refinements and exhaustive BC7 p-bits
+};
+
+/// @brief CPU encoders (and matching reference decoders) for single 4x4 blocks of BC1, BC3 and
+/// BC7. Blocks are 16 RGBA8 texels in row-major order.
+///
+/// Everything here is a pure function of its input: no global state and no data-dependent
+/// threading, so the same source always produces the same bytes on any x86-64 machine. BC7
+/// output uses mode 6 only (one subset, RGBA endpoints with p-bits, 4-bit indices), which covers
+/// both opaque and translucent content with a single search.
+class BlockCompression {
+public:
+    static void EncodeBC1(const u8* texels, u8* out, EncodeQuality quality) {
+        EncodeColor(texels, out, quality, true);
+    }
+
+    static void EncodeBC3(const u8* texels, u8* out, EncodeQuality quality) {
+        EncodeAlpha(texels, out, quality);
+        EncodeColor(texels, out + 8, quality, false);
+    }
+
+    static void EncodeBC7(const u8* texels, u8* out, EncodeQuality quality) {
+        Block block;
+        Load(texels, block);
+        std::array<f32, 4> low {}, high {};
+        FitEndpoints(block, 4, quality, low, high);
+
+        Mode6 best {};
+        best.Error = std::numeric_limits<u32>::max();
+        const u32 refinements = quality == EncodeQuality::Fast     ? 0
+                                : quality == EncodeQuality::Normal ? 1
+                                                                   : 3;
+        for (u32 pass = 0; pass <= refinements; ++pass) {
+            const auto candidate = QuantizeMode6(block, low, high, quality == EncodeQuality::High);
+            if (candidate.Error < best.Error) { best = candidate; }
+            if (best.Error == 0 || pass == refinements) { break; }
+
+            std::array<f32, 16> weights {};
+            for (u32 i = 0; i < 16; ++i) {
+                weights[i] = CAST<f32>(kBC7Weights[candidate.Indices[i]]) / 64.f;
+            }
+            if (!LeastSquares(block, 4, weights, nullptr, low, high)) { break; }
+        }
+        WriteMode6(best, out);
+    }
+
+    static void DecodeBC1(const u8* block, u8* texels) {
+        DecodeColor(block, texels, false);
+    }
+
+    static void DecodeBC3(const u8* block, u8* texels) {
+        DecodeColor(block + 8, texels, true);
+        DecodeAlpha(block, texels);
+    }
+
+    /// @brief Decodes mode 6 blocks; any other mode decodes to opaque magenta.
+    static void DecodeBC7(const u8* block, u8* texels) {
+        u64 lo, hi;
+        memcpy(&lo, block, 8);
+        memcpy(&hi, block + 8, 8);
+        if ((lo & 0x7F) != 0x40) {
+            for (u32 i = 0; i < 16; ++i) {
+                texels[i * 4 + 0] = 255;
+                texels[i * 4 + 1] = 0;
+                texels[i * 4 + 2] = 255;
+                texels[i * 4 + 3] = 255;
+            }
+            return;
+        }
+
+        u32 position = 7;
+        const auto read = [&](u32 bits) {
+            u32 value = 0;
+            for (u32 i = 0; i < bits; ++i, ++position) {
+                const u64 word = position < 64 ? lo >> position : hi >> (position - 64);
+                value |= CAST<u32>(word & 1) << i;
+            }
+            return value;
+        };
+
+        std::array<std::array<u32, 4>, 2> endpoints {};
+        for (u32 c = 0; c < 4; ++c) {
+            endpoints[0][c] = read(7) << 1;
+            endpoints[1][c] = read(7) << 1;
+        }
+        const u32 p0 = read(1), p1 = read(1);
+        for (u32 c = 0; c < 4; ++c) {
+            endpoints[0][c] |= p0;
+            endpoints[1][c] |= p1;
+        }
+        for (u32 i = 0; i < 16; ++i) {
+            const u32 weight = kBC7Weights[read(i == 0 ? 3 : 4)];
+            for (u32 c = 0; c < 4; ++c) {
+                texels[i * 4 + c] = CAST<u8>(
+                  ((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+            }
+        }
+    }
+
+private:
+    static constexpr u32 kBC7Weights[16] =
+      {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    struct Block {
+        alignas(16) f32 Texels[16][4];
+        u8 Alpha[16];
+    };
+
+    /// @brief Up to 16 candidate colors in SoA layout, padded to the SIMD width with entries too
+    /// far away to ever be chosen.
+    struct Palette {
+        alignas(16) f32 Channels[4][16];
+        u32 Count;
+    };
+
+    struct Mode6 {
+        std::array<std::array<u32, 4>, 2> Endpoints;  // 7-bit
+        std::array<u32, 2> PBits;
+        std::array<u8, 16> Indices;
+        u32 Error;
+    };
+
+    static void Load(const u8* texels, Block& block) {
+        for (u32 i = 0; i < 16; ++i) {
+            for (u32 c = 0; c < 4; ++c) {
+                block.Texels[i][c] = CAST<f32>(texels[i * 4 + c]);
+            }
+            block.Alpha[i] = texels[i * 4 + 3];
+        }
+    }
+
+    static void InitPalette(Palette& palette, u32 count) {
+        palette.Count = count;
+        for (auto& channel : palette.Channels) {
+            std::fill(std::begin(channel), std::end(channel), 1e9f);
+        }
+    }
+
+    /// @brief Index of the palette entry nearest to `texel` over the first `channels` channels.
+    /// Ties go to the lower index.
+    static u32 FindNearest(const Palette& palette, const f32* texel, u32 channels, f32& error) {
+        u32 best      = 0;
+        f32 bestError = std::numeric_limits<f32>::max();
+        for (u32 group = 0; group < palette.Count; group += 4) {
+            alignas(16) f32 distances[4];
+#ifdef XPAK_BLOCKS_SSE
+            __m128 sum = _mm_setzero_ps();
+            for (u32 c = 0; c < channels; ++c) {
+                const __m128 d = _mm_sub_ps(_mm_load_ps(&palette.Channels[c][group]),
+                                            _mm_set1_ps(texel[c]));
+                sum            = _mm_add_ps(sum, _mm_mul_ps(d, d));
+            }
+            _mm_store_ps(distances, sum);
+#else
+            for (u32 lane = 0; lane < 4; ++lane) {
+                distances[lane] = 0.f;
+                for (u32 c = 0; c < channels; ++c) {
+                    const f32 d = palette.Channels[c][group + lane] - texel[c];
+                    distances[lane] += d * d;
+                }
+            }
+#endif
+            for (u32 lane = 0; lane < 4 && group + lane < palette.Count; ++lane) {
+                if (distances[lane] < bestError) {
+                    bestError = distances[lane];
+                    best      = group + lane;
+                }
+            }
+        }
+        error = bestError;
+        return best;
+    }
+
+    /// @brief Picks two endpoints spanning the block's colors: the bounding box diagonal for
+    /// Fast, otherwise the extent along the principal axis (power iteration on the covariance).
+    /// Only texels with alpha >= 128 count when `opaqueOnly` is set.
+    static void FitEndpoints(const Block& block,
+                             u32 channels,
+                             EncodeQuality quality,
+                             std::array<f32, 4>& low,
+                             std::array<f32, 4>& high,
+                             bool opaqueOnly = false) {
+        const auto included = [&](u32 i) { return !opaqueOnly || block.Alpha[i] >= 128; };
+
+        if (quality == EncodeQuality::Fast) {
+            low.fill(255.f);
+            high.fill(0.f);
+            for (u32 i = 0; i < 16; ++i) {
+                if (!included(i)) { continue; }
+                for (u32 c = 0; c < channels; ++c) {
+                    low[c]  = std::min(low[c], block.Texels[i][c]);
+                    high[c] = std::max(high[c], block.Texels[i][c]);
+                }
+            }
+            // Inset so the interpolated colors land inside the box rather than on its corners
+            for (u32 c = 0; c < channels; ++c) {
+                const f32 inset = (high[c] - low[c]) / 16.f;
+                low[c] += inset;
+                high[c] -= inset;
+            }
+            return;
+        }
+
+        std::array<f32, 4> mean {};
+        f32 count = 0.f;
+        for (u32 i = 0; i < 16; ++i) {
+            if (!included(i)) { continue; }
+            for (u32 c = 0; c < channels; ++c) {
+                mean[c] += block.Texels[i][c];
+            }
+            count += 1.f;
+        }
+        if (count == 0.f) {
+            low.fill(0.f);
+            high.fill(0.f);
+            return;
+        }
+        for (u32 c = 0; c < channels; ++c) {
+            mean[c] /= count;
+        }
+
+        f32 covariance[4][4] {};
+        for (u32 i = 0; i < 16; ++i) {
+            if (!included(i)) { continue; }
+            for (u32 a = 0; a < channels; ++a) {
+                for (u32 b = 0; b < channels; ++b) {
+                    covariance[a][b] +=
+                      (block.Texels[i][a] - mean[a]) * (block.Texels[i][b] - mean[b]);
+                }
+            }
+        }
+
+        std::array<f32, 4> axis {1.f, 1.f, 1.f, 1.f};
+        for (u32 iteration = 0; iteration < 8; ++iteration) {
+            std::array<f32, 4> next {};
+            f32 length = 0.f;
+            for (u32 a = 0; a < channels; ++a) {
+                for (u32 b = 0; b < channels; ++b) {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length = std::max(length, std::abs(next[a]));
+            }
+            if (length < 1e-6f) { break; }
+            for (u32 c = 0; c < channels; ++c) {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        f32 minT = std::numeric_limits<f32>::max(), maxT = std::numeric_limits<f32>::lowest();
+        f32 norm = 0.f;
+        for (u32 c = 0; c < channels; ++c) {
+            norm += axis[c] * axis[c];
+        }
+        if (norm < 1e-12f) { norm = 1.f; }
+        for (u32 i = 0; i < 16; ++i) {
+            if (!included(i)) { continue; }
+            f32 t = 0.f;
+            for (u32 c = 0; c < channels; ++c) {
+                t += (block.Texels[i][c] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t / norm);
+            maxT = std::max(maxT, t / norm);
+        }
+        for (u32 c = 0; c < channels; ++c) {
+            low[c]  = std::clamp(mean[c] + axis[c] * minT, 0.f, 255.f);
+            high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.f, 255.f);
+        }
+    }
+
+    /// @brief Solves for the endpoints that minimize squared error given each texel's
+    /// interpolation weight toward `high`. Texels with `mask[i] == false` are ignored.
+    static bool LeastSquares(const Block& block,
+                             u32 channels,
+                             const std::array<f32, 16>& weights,
+                             const bool* mask,
+                             std::array<f32, 4>& low,
+                             std::array<f32, 4>& high) {
+        f32 aa = 0.f, bb = 0.f, ab = 0.f;
+        std::array<f32, 4> ax {}, bx {};
+        for (u32 i = 0; i < 16; ++i) {
+            if (mask && !mask[i]) { continue; }
+            const f32 b = weights[i];
+            const f32 a = 1.f - b;
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for (u32 c = 0; c < channels; ++c) {
+                ax[c] += a * block.Texels[i][c];
+                bx[c] += b * block.Texels[i][c];
+            }
+        }
+        const f32 determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f) { return false; }
+        const f32 inverse = 1.f / determinant;
+        for (u32 c = 0; c < channels; ++c) {
+            low[c]  = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.f, 255.f);
+            high[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.f, 255.f);
+        }
+        return true;
+    }
+
+    // BC1 / BC3 color ----------------------------------------------------------------------------
+
+    static u16 Pack565(const std::array<f32, 4>& color) {
+        const auto r = CAST<u32>(std::lround(std::clamp(color[0], 0.f, 255.f) * 31.f / 255.f));
+        const auto g = CAST<u32>(std::lround(std::clamp(color[1], 0.f, 255.f) * 63.f / 255.f));
+        const auto b = CAST<u32>(std::lround(std::clamp(color[2], 0.f, 255.f) * 31.f / 255.f));
+        return CAST<u16>((r << 11) | (g << 5) | b);
+    }
+
+    static std::array<u32, 3> Unpack565(u16 color) {
+        const u32 r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+        return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+    }
+
+    /// @brief The four colors a BC1 block decodes to. Three-color mode (color0 <= color1) is
+    /// only honoured for BC1; BC3 always interpolates four.
+    static std::array<std::array<u32, 4>, 4> ColorPalette(u16 color0, u16 color1, bool forceFour) {
+        const auto c0 = Unpack565(color0), c1 = Unpack565(color1);
+        std::array<std::array<u32, 4>, 4> palette {};
+        for (u32 c = 0; c < 3; ++c) {
+            palette[0][c] = c0[c];
+            palette[1][c] = c1[c];
+            if (forceFour || color0 > color1) {
+                palette[2][c] = (2 * c0[c] + c1[c] + 1) / 3;
+                palette[3][c] = (c0[c] + 2 * c1[c] + 1) / 3;
+            } else {
+                palette[2][c] = (c0[c] + c1[c] + 1) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[0][3] = palette[1][3] = palette[2][3] = 255;
+        palette[3][3] = forceFour || color0 > color1 ? 255 : 0;
+        return palette;
+    }
+
+    struct ColorCandidate {
+        u16 Color0;
+        u16 Color1;
+        u32 Indices;
+        f32 Error;
+    };
+
+    static ColorCandidate EvaluateColor(const Block& block,
+                                        const std::array<f32, 4>& low,
+                                        const std::array<f32, 4>& high,
+                                        bool threeColor,
+                                        const bool* opaque) {
+        u16 color0 = Pack565(high), color1 = Pack565(low);
+        // Four-color mode needs color0 > color1, three-color mode needs color0 <= color1
+        if (threeColor ? color0 > color1 : color0 < color1) { std::swap(color0, color1); }
+
+        const auto colors = ColorPalette(color0, color1, !threeColor);
+        Palette palette;
+        InitPalette(palette, threeColor ? 3 : 4);
+        for (u32 i = 0; i < palette.Count; ++i) {
+            for (u32 c = 0; c < 3; ++c) {
+                palette.Channels[c][i] = CAST<f32>(colors[i][c]);
+            }
+        }
+
+        ColorCandidate candidate {color0, color1, 0, 0.f};
+        for (u32 i = 0; i < 16; ++i) {
+            u32 index = 3;
+            if (!opaque || opaque[i]) {
+                f32 error;
+                index = FindNearest(palette, block.Texels[i], 3, error);
+                candidate.Error += error;
+            }
+            candidate.Indices |= index << (i * 2);
+        }
+        return candidate;
+    }
+
+    static void EncodeColor(const u8* texels, u8* out, EncodeQuality quality, bool allowAlpha) {
+        Block block;
+        Load(texels, block);
+
+        // BC1 can only express alpha as fully transparent texels in three-color mode
+        bool opaque[16];
+        bool threeColor = false;
+        for (u32 i = 0; i < 16; ++i) {
+            opaque[i] = !allowAlpha || block.Alpha[i] >= 128;
+            threeColor |= !opaque[i];
+        }
+
+        std::array<f32, 4> low {}, high {};
+        FitEndpoints(block, 3, quality, low, high, threeColor);
+        auto best = EvaluateColor(block, low, high, threeColor, threeColor ? opaque : nullptr);
+        if (quality != EncodeQuality::Fast) {
+            // The principal axis is a poor fit for blocks with several distinct clusters; the
+            // bounding box is cheap to try as well
+            FitEndpoints(block, 3, EncodeQuality::Fast, low, high, threeColor);
+            const auto candidate =
+              EvaluateColor(block, low, high, threeColor, threeColor ? opaque : nullptr);
+            if (candidate.Error < best.Error) { best = candidate; }
+        }
+
+        const u32 refinements = quality == EncodeQuality::Fast     ? 0
+                                : quality == EncodeQuality::Normal ? 1
+                                                                   : 3;
+        for (u32 pass = 0; pass < refinements && best.Error > 0.f; ++pass) {
+            // Weight of each index toward color1 (the low endpoint), in index order
+            static constexpr f32 kFour[4]  = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+            static constexpr f32 kThree[4] = {0.f, 1.f, 0.5f, 0.f};
+            std::array<f32, 16> weights {};
+            for (u32 i = 0; i < 16; ++i) {
+                const u32 index = (best.Indices >> (i * 2)) & 3;
+                weights[i]      = threeColor ? kThree[index] : kFour[index];
+            }
+            // Solve with color0 as "low" so weights map toward color1
+            std::array<f32, 4> color0 {}, color1 {};
+            if (!LeastSquares(block, 3, weights, threeColor ? opaque : nullptr, color0, color1)) {
+                break;
+            }
+            const auto candidate =
+              EvaluateColor(block, color1, color0, threeColor, threeColor ? opaque : nullptr);
+            if (candidate.Error >= best.Error) { break; }
+            best = candidate;
+        }
+
+        memcpy(out, &best.Color0, 2);
+        memcpy(out + 2, &best.Color1, 2);
+        memcpy(out + 4, &best.Indices, 4);
+    }
+
+    static void DecodeColor(const u8* block, u8* texels, bool forceFour) {
+        u16 color0, color1;
+        u32 indices;
+        memcpy(&color0, block, 2);
+        memcpy(&color1, block + 2, 2);
+        memcpy(&indices, block + 4, 4);
+        const auto palette = ColorPalette(color0, color1, forceFour);
+        for (u32 i = 0; i < 16; ++i) {
+            const auto& color = palette[(indices >> (i * 2)) & 3];
+            for (u32 c = 0; c < 4; ++c) {
+                texels[i * 4 + c] = CAST<u8>(color[c]);
+            }
+        }
+    }
+
+    // BC3 alpha ----------------------------------------------------------------------------------
+
+    static std::array<u32, 8> AlphaPalette(u32 alpha0, u32 alpha1) {
+        std::array<u32, 8> palette {alpha0, alpha1};
+        if (alpha0 > alpha1) {
+            for (u32 i = 1; i < 7; ++i) {
+                palette[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+            }
+        } else {
+            for (u32 i = 1; i < 5; ++i) {
+                palette[i + 1] = ((5 - i) * alpha0 + i * alpha1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        return palette;
+    }
+
+    static u32 EvaluateAlpha(const Block& block, u32 alpha0, u32 alpha1, u64& indices) {
+        const auto palette = AlphaPalette(alpha0, alpha1);
+        u32 error          = 0;
+        indices            = 0;
+        for (u32 i = 0; i < 16; ++i) {
+            u32 best = 0, bestError = std::numeric_limits<u32>::max();
+            for (u32 j = 0; j < 8; ++j) {
+                const i32 d = CAST<i32>(palette[j]) - CAST<i32>(block.Alpha[i]);
+                if (CAST<u32>(d * d) < bestError) {
+                    bestError = CAST<u32>(d * d);
+                    best      = j;
+                }
+            }
+            error += bestError;
+            indices |= CAST<u64>(best) << (i * 3);
+        }
+        return error;
+    }
+
+    static void EncodeAlpha(const u8* texels, u8* out, EncodeQuality quality) {
+        Block block;
+        Load(texels, block);
+
+        u32 low = 255, high = 0, innerLow = 255, innerHigh = 0;
+        for (const u32 alpha : block.Alpha) {
+            low  = std::min(low, alpha);
+            high = std::max(high, alpha);
+            if (alpha != 0 && alpha != 255) {
+                innerLow  = std::min(innerLow, alpha);
+                innerHigh = std::max(innerHigh, alpha);
+            }
+        }
+
+        // Eight interpolated values over the full range
+        u64 indices;
+        u32 alpha0 = high, alpha1 = low;
+        u32 error  = EvaluateAlpha(block, alpha0, alpha1, indices);
+
+        // Six interpolated values over the non-extreme texels, with exact 0 and 255 available
+        if (quality != EncodeQuality::Fast && error > 0 && innerLow <= innerHigh) {
+            u64 sixIndices;
+            const u32 sixError = EvaluateAlpha(block, innerLow, innerHigh, sixIndices);
+            if (sixError < error) {
+                alpha0  = innerLow;
+                alpha1  = innerHigh;
+                indices = sixIndices;
+            }
+        }
+
+        out[0] = CAST<u8>(alpha0);
+        out[1] = CAST<u8>(alpha1);
+        for (u32 i = 0; i < 6; ++i) {
+            out[2 + i] = CAST<u8>(indices >> (i * 8));
+        }
+    }
+
+    static void DecodeAlpha(const u8* block, u8* texels) {
+        const auto palette = AlphaPalette(block[0], block[1]);
+        u64 indices        = 0;
+        for (u32 i = 0; i < 6; ++i) {
+            indices |= CAST<u64>(block[2 + i]) << (i * 8);
+        }
+        for (u32 i = 0; i < 16; ++i) {
+            texels[i * 4 + 3] = CAST<u8>(palette[(indices >> (i * 3)) & 7]);
+        }
+    }
+
+    // BC7 mode 6 ---------------------------------------------------------------------------------
+
+    static u32 QuantizeChannel(f32 value, u32 pBit) {
+        return CAST<u32>(std::clamp(std::lround((value - CAST<f32>(pBit)) * 0.5f), 0l, 127l));
+    }
+
+    static f32 EndpointError(const std::array<f32, 4>& endpoint, u32 pBit) {
+        f32 error = 0.f;
+        for (u32 c = 0; c < 4; ++c) {
+            const f32 d = CAST<f32>((QuantizeChannel(endpoint[c], pBit) << 1) | pBit) - endpoint[c];
+            error += d * d;
+        }
+        return error;
+    }
+
+    static Mode6 EvaluateMode6(const Block& block,
+                               const std::array<f32, 4>& low,
+                               const std::array<f32, 4>& high,
+                               u32 p0,
+                               u32 p1) {
+        Mode6 mode {};
+        mode.PBits = {p0, p1};
+        std::array<std::array<u32, 4>, 2> expanded {};
+        for (u32 c = 0; c < 4; ++c) {
+            mode.Endpoints[0][c] = QuantizeChannel(low[c], p0);
+            mode.Endpoints[1][c] = QuantizeChannel(high[c], p1);
+            expanded[0][c]       = (mode.Endpoints[0][c] << 1) | p0;
+            expanded[1][c]       = (mode.Endpoints[1][c] << 1) | p1;
+        }
+
+        Palette palette;
+        InitPalette(palette, 16);
+        for (u32 i = 0; i < 16; ++i) {
+            const u32 weight = kBC7Weights[i];
+            for (u32 c = 0; c < 4; ++c) {
+                palette.Channels[c][i] = CAST<f32>(
+                  ((64 - weight) * expanded[0][c] + weight * expanded[1][c] + 32) >> 6);
+            }
+        }
+
+        f32 error = 0.f;
+        for (u32 i = 0; i < 16; ++i) {
+            f32 texelError;
+            mode.Indices[i] = CAST<u8>(FindNearest(palette, block.Texels[i], 4, texelError));
+            error += texelError;
+        }
+        mode.Error = CAST<u32>(error);
+        return mode;
+    }
+
+    static Mode6 QuantizeMode6(const Block& block,
+                               const std::array<f32, 4>& low,
+                               const std::array<f32, 4>& high,
+                               bool exhaustive) {
+        if (exhaustive) {
+            Mode6 best {};
+            best.Error = std::numeric_limits<u32>::max();
+            for (u32 p = 0; p < 4; ++p) {
+                const auto candidate = EvaluateMode6(block, low, high, p & 1, p >> 1);
+                if (candidate.Error < best.Error) { best = candidate; }
+            }
+            return best;
+        }
+        const u32 p0 = EndpointError(low, 1) < EndpointError(low, 0) ? 1 : 0;
+        const u32 p1 = EndpointError(high, 1) < EndpointError(high, 0) ? 1 : 0;
+        return EvaluateMode6(block, low, high, p0, p1);
+    }
+
+    static void WriteMode6(Mode6 mode, u8* out) {
+        // The first index's top bit is implicit, so it must be < 8; mirror the block if not
+        if (mode.Indices[0] >= 8) {
+            std::swap(mode.Endpoints[0], mode.Endpoints[1]);
+            std::swap(mode.PBits[0], mode.PBits[1]);
+            for (auto& index : mode.Indices) {
+                index = CAST<u8>(15 - index);
+            }
+        }
+
+        u64 words[2] = {0, 0};
+        u32 position = 0;
+        const auto write = [&](u32 value, u32 bits) {
+            for (u32 i = 0; i < bits; ++i, ++position) {
+                words[position / 64] |= CAST<u64>((value >> i) & 1) << (position % 64);
+            }
+        };
+
+        write(0x40, 7);
+        for (u32 c = 0; c < 4; ++c) {
+            write(mode.Endpoints[0][c], 7);
+            write(mode.Endpoints[1][c], 7);
+        }
+        write(mode.PBits[0], 1);
+        write(mode.PBits[1], 1);
+        for (u32 i = 0; i < 16; ++i) {
+            write(mode.Indices[i], i == 0 ? 3 : 4);
+        }
+        memcpy(out, words, 16);
+    }
+};
@@ -6,84 +6,325 @@
 #pragma once
 #pragma warning(disable : 4996)
 
+#include "BuildError.hpp"
+#include "ContentHash.hpp"
+
+#include <IO.hpp>
 #include <Panic.hpp>
-#include <pugixml.hpp>
+#include <chrono>
+#include <cstring>
 #include <fstream>
+#include <iostream>
+#include <mutex>
 #include <optional>
-#include <sha256.h>
 #include <filesystem>
 
 #include <Types.hpp>
 #include <unordered_map>
 #include <vector>
 
+#ifndef _WIN32
+    #include <sys/stat.h>
+#endif
+
+/// @brief What the last build knew about each asset and source file, saved as `.build_cache`
+/// next to the manifest. The file is a header, fixed-size asset and file records, then a block
+/// holding their names:
+///
+///   Header                           24 bytes
+///   AssetRecord[Header.AssetCount]   80 bytes each
+///   FileRecord[Header.FileCount]     48 bytes each
+///   names                            Header.NamesSize bytes, referenced by offset and length
+///
+/// Integers are little-endian. Saving writes a temporary file and renames it over the old one,
+/// so an interrupted build never leaves a torn cache behind.
 struct BuildCache {
-    std::unordered_map<str, str> Assets;
+    static constexpr char kMagic[4]  = {'X', 'B', 'C', 'F'};
+    static constexpr u32 kVersion    = 1;
+    static constexpr auto kCacheName = ".build_cache";
+
+    /// @brief An asset is up to date while every input matches what the current build would
+    /// use and its outputs still hash to what was written.
+    struct AssetEntry {
+        ContentHash Source;  // Of the source file, or every member for atlases
+        u32 Type             = 0;
+        u32 ProcessorVersion = 0;
+        ContentHash Settings;  // Of the asset's settings and resolved codec
+        ContentHash Pak;       // Of the .xpkf as written
+        ContentHash Metadata;  // Of the .xmdf as written
+        bool Used = false;     // Looked up this build; entries of removed assets are dropped
+
+        [[nodiscard]] bool SameInputs(const AssetEntry& other) const {
+            return Source == other.Source && Type == other.Type &&
+                   ProcessorVersion == other.ProcessorVersion && Settings == other.Settings;
+        }
+
+        /// @brief Identifies the outputs independently of where the project lives, so other
+        /// machines building the same inputs can share them.
+        [[nodiscard]] ContentHash InputHash() const {
+            const struct {
+                ContentHash Source, Settings;
+                u32 Type, ProcessorVersion;
+            } inputs {Source, Settings, Type, ProcessorVersion};
+            static_assert(sizeof(inputs) == 40);  // No padding to leak into the hash
+            return ContentHash::Bytes({RCAST<const u8*>(&inputs), sizeof(inputs)});
+        }
+    };
+
+    /// @brief What a source file looked like when it was last hashed. While size, modification
+    /// time and inode all still match, the stored checksum is reused without reading the file.
+    struct FileStamp {
+        u64 Size  = 0;
+        i64 MTime = 0;  // file_time_type ticks
+        u64 Inode = 0;  // 0 where the platform has none
+        ContentHash Checksum;
+        bool Used = false;  // Looked up this build; stamps of files no longer built are dropped
+
+        bool operator==(const FileStamp& other) const {
+            return Size == other.Size && MTime == other.MTime && Inode == other.Inode;
+        }
+    };
+
+    std::unordered_map<str, AssetEntry> Assets;  // Source path -> entry
+    std::unordered_map<str, FileStamp> Files;    // Canonical path -> stamp
 
     BuildCache() = default;
 
-    explicit BuildCache(const char* filename) {
-        this->Assets.clear();
-        pugi::xml_document doc;
-        const auto parseResult = doc.load_file(filename);
-        if (!parseResult) { Panic("Failed to parse XML file"); }
-
-        const auto cacheRoot = doc.child("BuildCache");
-        for (auto& asset : cacheRoot.children("Asset")) {
-            const auto& source   = asset.attribute("source").value();
-            const auto& checksum = asset.text().as_string();
-            this->Assets.insert_or_assign(source, checksum);
+    /// @brief A cache that is missing, from an older format or damaged loads as empty, which
+    /// rebuilds everything once.
+    explicit BuildCache(const std::filesystem::path& filename) {
+        const auto bytes = IO::ReadBytes(filename);
+        if (!bytes) { return; }
+        if (!Parse(*bytes)) {
+            std::cout << "  | Ignoring unreadable build cache: " << filename.string() << '\n';
+            Clear();
         }
     }
 
-    void SaveToFile(const str& rootDir) {
-        pugi::xml_document doc;
-        auto rootNode = doc.append_child("BuildCache");
-        for (const auto& [source, checksum] : this->Assets) {
-            auto assetNode  = rootNode.append_child("Asset");
-            auto sourceAttr = assetNode.append_attribute("source");
-            sourceAttr.set_value(source.c_str());
-            assetNode.text().set(checksum.c_str());
+    void SaveToFile(const std::filesystem::path& rootDir) {
+        std::vector<AssetRecord> assets;
+        std::vector<FileRecord> files;
+        str names;
+        const auto addName = [&](const str& name, u32& offset, u32& length) {
+            offset = CAST<u32>(names.size());
+            length = CAST<u32>(name.size());
+            names += name;
+        };
+        for (const auto& [source, entry] : this->Assets) {
+            if (!entry.Used) { continue; }
+            AssetRecord& record     = assets.emplace_back();
+            record.Type             = entry.Type;
+            record.ProcessorVersion = entry.ProcessorVersion;
+            record.Source           = entry.Source;
+            record.Settings         = entry.Settings;
+            record.Pak              = entry.Pak;
+            record.Metadata         = entry.Metadata;
+            addName(source, record.NameOffset, record.NameLength);
+        }
+        for (const auto& [path, stamp] : this->Files) {
+            if (!stamp.Used) { continue; }
+            FileRecord& record = files.emplace_back();
+            record.Size        = stamp.Size;
+            record.MTime       = stamp.MTime;
+            record.Inode       = stamp.Inode;
+            record.Checksum    = stamp.Checksum;
+            addName(path, record.NameOffset, record.NameLength);
+        }
+
+        Header header {};
+        memcpy(header.Magic, kMagic, 4);
+        header.Version    = kVersion;
+        header.AssetCount = CAST<u32>(assets.size());
+        header.FileCount  = CAST<u32>(files.size());
+        header.NamesSize  = names.size();
+
+        const auto outFile  = rootDir / kCacheName;
+        const auto tempFile = rootDir / (str(kCacheName) + ".tmp");
+        {
+            std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+            out.write(RCAST<const char*>(&header), sizeof(header));
+            out.write(RCAST<const char*>(assets.data()),
+                      CAST<std::streamsize>(assets.size() * sizeof(AssetRecord)));
+            out.write(RCAST<const char*>(files.data()),
+                      CAST<std::streamsize>(files.size() * sizeof(FileRecord)));
+            out.write(names.data(), CAST<std::streamsize>(names.size()));
+            out.close();
+            if (!out.good()) { Panic("Failed to save build cache"); }
         }
-        const auto outFile = std::filesystem::path(rootDir) / ".build_cache";
-        if (!doc.save_file(outFile.string().c_str())) { Panic("Failed to save build cache"); }
+        std::error_code error;
+        std::filesystem::rename(tempFile, outFile, error);
+        if (error) { Panic("Failed to save build cache: %s", error.message().c_str()); }
     }
 
-    std::optional<str> GetChecksum(const str& key) {
+    /// @brief The entry recorded for `key`, or nullptr. Keeps the entry when the cache is saved.
+    AssetEntry* Find(const str& key) {
         const auto it = Assets.find(key);
-        if (it != Assets.end()) return it->second;
-        return std::nullopt;
+        if (it == Assets.end()) { return nullptr; }
+        it->second.Used = true;
+        return &it->second;
     }
 
-    [[nodiscard]] static str CalculateChecksum(const str& filename) {
-        std::ifstream file(filename, std::ios::binary);
-        if (!file) { Panic("Failed to open file"); }
+    /// @brief Checksum of `filename`, read from the stamp recorded for it when the file is
+    /// unchanged and computed (and stamped) otherwise. Empty if the file can't be read. Safe to
+    /// call from several threads.
+    [[nodiscard]] std::optional<ContentHash>
+    GetFileChecksum(const std::filesystem::path& filename) {
+        const auto key     = filename.string();
+        const auto current = Stamp(filename);
+        if (!current) { return std::nullopt; }
+        {
+            std::lock_guard lock(mFilesMutex);
+            const auto it = Files.find(key);
+            if (it != Files.end() && it->second == *current) {
+                it->second.Used = true;
+                return it->second.Checksum;
+            }
+        }
 
-        SHA256 sha256;
-        std::vector<char> buffer(4096);
-        while (file.read(buffer.data(), CAST<std::streamsize>(buffer.size())) ||
-               file.gcount() > 0) {
-            // Only update SHA256 if there's data read
-            sha256.add(buffer.data(), file.gcount());
+        // Called from the build's worker pools, which already use every core
+        const auto checksum = ContentHash::File(filename, 1);
+        if (!checksum) { return std::nullopt; }
+        // A file written in the last couple of seconds could change again without its mtime
+        // moving, so it is hashed again next time rather than trusted
+        const auto settled = std::chrono::file_clock::now() - std::chrono::seconds(2);
+        if (current->MTime < settled.time_since_epoch().count()) {
+            std::lock_guard lock(mFilesMutex);
+            auto& stamp    = Files[key];
+            stamp          = *current;
+            stamp.Checksum = *checksum;
+            stamp.Used     = true;
         }
+        return checksum;
+    }
 
-        u8 hash[32];
-        sha256.getHash(hash);
+    /// @brief Checksum of a source file. Throws BuildError if it can't be read.
+    [[nodiscard]] ContentHash CalculateChecksum(const std::filesystem::path& filename) {
+        const auto checksum = GetFileChecksum(filename);
+        if (!checksum) { throw BuildError("Failed to open file: %s", filename.string().c_str()); }
+        return *checksum;
+    }
 
-        std::ostringstream result;
-        result << std::hex << std::setfill('0');
-        for (const u8 byte : hash) {
-            result << std::setw(2) << CAST<int>(byte);
+    /// @brief Combined checksum for a multi-file asset. Covers each member's path relative to
+    /// `root` as well as its contents, so adding, removing or renaming a member also changes it.
+    [[nodiscard]] ContentHash CalculateChecksum(const std::vector<std::filesystem::path>& members,
+                                                const std::filesystem::path& root) {
+        std::vector<u8> listing;
+        for (const auto& member : members) {
+            const auto name = std::filesystem::relative(member, root).generic_string();
+            const auto hash = CalculateChecksum(member);
+            listing.insert(listing.end(), name.c_str(), name.c_str() + name.size() + 1);
+            listing.insert(listing.end(), RCAST<const u8*>(&hash), RCAST<const u8*>(&hash + 1));
         }
-
-        return result.str();
+        return ContentHash::Bytes(listing);
     }
 
-    void Update(const str& key, const str& value) {
-        this->Assets.insert_or_assign(key, value);
+    void Update(const str& key, const AssetEntry& entry) {
+        auto& stored = this->Assets[key];
+        stored       = entry;
+        stored.Used  = true;
     }
 
     void Clear() {
         this->Assets.clear();
+        this->Files.clear();
+    }
+
+private:
+    struct Header {
+        char Magic[4];
+        u32 Version;
+        u32 AssetCount;
+        u32 FileCount;
+        u64 NamesSize;
+    };
+
+    struct AssetRecord {
+        u32 NameOffset;
+        u32 NameLength;
+        u32 Type;
+        u32 ProcessorVersion;
+        ContentHash Source;
+        ContentHash Settings;
+        ContentHash Pak;
+        ContentHash Metadata;
+    };
+
+    struct FileRecord {
+        u32 NameOffset;
+        u32 NameLength;
+        u64 Size;
+        i64 MTime;
+        u64 Inode;
+        ContentHash Checksum;
+    };
+
+    static_assert(sizeof(Header) == 24);
+    static_assert(sizeof(AssetRecord) == 80);
+    static_assert(sizeof(FileRecord) == 48);
+
+    std::mutex mFilesMutex;
+
+    bool Parse(const std::vector<u8>& bytes) {
+        Header header;
+        if (bytes.size() < sizeof(header)) { return false; }
+        memcpy(&header, bytes.data(), sizeof(header));
+        if (memcmp(header.Magic, kMagic, 4) != 0 || header.Version != kVersion) { return false; }
+
+        const u64 assetsSize = CAST<u64>(header.AssetCount) * sizeof(AssetRecord);
+        const u64 filesSize  = CAST<u64>(header.FileCount) * sizeof(FileRecord);
+        if (bytes.size() != sizeof(header) + assetsSize + filesSize + header.NamesSize) {
+            return false;
+        }
+        const u8* assets = bytes.data() + sizeof(header);
+        const u8* files  = assets + assetsSize;
+        const std::string_view names(RCAST<const char*>(files + filesSize), header.NamesSize);
+        const auto name = [&](u32 offset, u32 length) -> std::optional<str> {
+            if (CAST<u64>(offset) + length > names.size()) { return std::nullopt; }
+            return str(names.substr(offset, length));
+        };
+
+        Assets.reserve(header.AssetCount);
+        for (u32 i = 0; i < header.AssetCount; ++i) {
+            AssetRecord record;
+            memcpy(&record, assets + CAST<size_t>(i) * sizeof(record), sizeof(record));
+            auto source = name(record.NameOffset, record.NameLength);
+            if (!source) { return false; }
+            AssetEntry entry;
+            entry.Source           = record.Source;
+            entry.Type             = record.Type;
+            entry.ProcessorVersion = record.ProcessorVersion;
+            entry.Settings         = record.Settings;
+            entry.Pak              = record.Pak;
+            entry.Metadata         = record.Metadata;
+            Assets.insert_or_assign(std::move(*source), entry);
+        }
+        Files.reserve(header.FileCount);
+        for (u32 i = 0; i < header.FileCount; ++i) {
+            FileRecord record;
+            memcpy(&record, files + CAST<size_t>(i) * sizeof(record), sizeof(record));
+            auto path = name(record.NameOffset, record.NameLength);
+            if (!path) { return false; }
+            FileStamp stamp;
+            stamp.Size     = record.Size;
+            stamp.MTime    = record.MTime;
+            stamp.Inode    = record.Inode;
+            stamp.Checksum = record.Checksum;
+            Files.insert_or_assign(std::move(*path), stamp);
+        }
+        return true;
+    }
+
+    static std::optional<FileStamp> Stamp(const std::filesystem::path& filename) {
+        std::error_code error;
+        FileStamp stamp;
+        stamp.Size = std::filesystem::file_size(filename, error);
+        if (error) { return std::nullopt; }
+        stamp.MTime = std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+        if (error) { return std::nullopt; }
+#ifndef _WIN32
+        struct stat info {};
+        if (stat(filename.c_str(), &info) == 0) { stamp.Inode = CAST<u64>(info.st_ino); }
+#endif
+        return stamp;
     }
 };
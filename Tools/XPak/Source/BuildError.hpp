@@ -0,0 +1,53 @@
+// Author: Jake Rieger
+// Created: 12/10/2024.
+//
+
+#pragma once
+
+#include <Types.hpp>
+#include <charconv>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+/// @brief A problem with one asset's source or settings, such as an image that doesn't decode
+/// or a codec that doesn't exist. The build reports it and leaves that asset out instead of
+/// stopping, so a half-saved file can't take down `XPak watch`. Problems with the build itself
+/// still Panic.
+class BuildError : public std::runtime_error {
+public:
+    explicit BuildError(const char* message) : std::runtime_error(message) {}
+
+    /// @brief printf-style, like Panic.
+    template<typename... Args>
+    BuildError(const char* fmt, Args... args) : std::runtime_error(Format(fmt, args...)) {}
+
+private:
+    template<typename... Args>
+    static str Format(const char* fmt, Args... args) {
+        char message[1024];
+        snprintf(message, sizeof(message), fmt, args...);
+        return message;
+    }
+};
+
+/// @brief Parses a whole decimal number from an asset's settings or source. Surrounding
+/// whitespace is allowed; anything else, or a value above `max`, throws BuildError naming
+/// `what`.
+inline u32 ParseUInt(std::string_view value,
+                     const char* what,
+                     u32 max = std::numeric_limits<u32>::max()) {
+    const auto first = value.find_first_not_of(" \t\r\n");
+    const auto last  = value.find_last_not_of(" \t\r\n");
+    if (first != std::string_view::npos) { value = value.substr(first, last - first + 1); }
+    u32 result        = 0;
+    const auto parsed = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (value.empty() || parsed.ec != std::errc() || parsed.ptr != value.data() + value.size()) {
+        throw BuildError("Invalid %s: '%s'", what, str(value).c_str());
+    }
+    if (result > max) {
+        throw BuildError("Invalid %s: %u is above the maximum of %u", what, result, max);
+    }
+    return result;
+}
@@ -0,0 +1,281 @@
+// Author: Jake Rieger
+// Created: 12/9/2024.
+//
+
+#pragma once
+
+#include "BuildPool.hpp"
+
+#include <Types.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/// @brief Moves items through a fixed sequence of stages, each with its own worker threads and a
+/// bounded queue in front of it. Different items occupy different stages at once, so one asset
+/// is read from disk while another is decoded and a third compressed. A full queue holds back the
+/// stage feeding it. Each item's estimated bytes count against the memory budget from when it
+/// enters the first stage until it leaves the pipeline or is deferred, which bounds how much is
+/// in flight. Deferred items are not counted while they wait: they can only move on once every
+/// item has passed their stage, so holding their budget could leave those items unable to start.
+/// What deferred items hold is therefore on top of the budget.
+class BuildPipeline {
+public:
+    static constexpr size_t kDefaultQueueCapacity = 8;
+
+    enum class Result {
+        Next,   // On to the next stage
+        Drop,   // Out of the pipeline
+        Defer,  // Held back until every item has passed this stage, then on to the next. Not
+                // counted against the memory budget while held
+    };
+
+    struct Stage {
+        const char* Name;
+        u32 Workers;
+        std::function<Result(size_t)> Run;
+        /// @brief Optional. Called once every item has passed the stage, with the items it
+        /// deferred, before those move on.
+        std::function<void(const std::vector<size_t>&)> Drain;
+    };
+
+    struct Item {
+        size_t Index;
+        u64 Bytes;  // Estimated peak memory
+    };
+
+    BuildPipeline(std::vector<Stage> stages,
+                  u64 memoryBudget,
+                  size_t queueCapacity = kDefaultQueueCapacity)
+        : mStages(std::move(stages)), mMemory(memoryBudget), mQueueCapacity(queueCapacity),
+          mStates(mStages.size()) {}
+
+    /// @brief Runs every item through the stages in the given order and returns once all have
+    /// left, showing `label` on the progress bar and printing how busy each stage was.
+    /// Rethrows the first exception a stage threw; nothing new starts after one fails.
+    void Run(const char* label, const std::vector<Item>& items) {
+        if (items.empty()) { return; }
+        const auto start = Clock::now();
+        mProgress.Start(label, items.size());
+
+        std::vector<std::thread> threads;
+        for (size_t stage = 0; stage < mStages.size(); ++stage) {
+            mStates[stage].Running = std::max(1u, mStages[stage].Workers);
+            for (u32 i = 0; i < mStates[stage].Running; ++i) {
+                threads.emplace_back([this, stage] { WorkerLoop(stage); });
+            }
+        }
+        for (const auto& item : items) {
+            if (!mMemory.Acquire(item.Bytes)) { break; }
+            if (!Push(0, item)) {
+                mMemory.Release(item.Bytes);
+                break;
+            }
+        }
+        Close(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        mProgress.Stop();
+        PrintReport(Seconds(Clock::now() - start));
+        if (mError) { std::rethrow_exception(mError); }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief A stage's input queue and counters.
+    struct State {
+        std::mutex Mutex;
+        std::condition_variable NotEmpty;
+        std::condition_variable NotFull;
+        std::deque<Item> Queue;
+        bool Closed = false;
+        u32 Running = 0;             // Workers that haven't exited
+        std::vector<Item> Deferred;  // Guarded by Mutex
+        std::atomic<u64> Items   = 0;
+        std::atomic<u64> BusyNs  = 0;  // Inside Run
+        std::atomic<u64> StallNs = 0;  // Waiting for room in the next stage's queue
+    };
+
+    std::vector<Stage> mStages;
+    BuildMemory mMemory;
+    size_t mQueueCapacity;
+    std::vector<State> mStates;
+    BuildProgress mProgress;
+
+    std::mutex mErrorMutex;
+    std::exception_ptr mError;  // The first a stage threw
+    std::atomic<bool> mFailed = false;
+
+    static f64 Seconds(Clock::duration duration) {
+        return std::chrono::duration<f64>(duration).count();
+    }
+
+    static u64 Nanoseconds(Clock::duration duration) {
+        return CAST<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    void WorkerLoop(size_t stage) {
+        auto& state     = mStates[stage];
+        const bool last = stage + 1 == mStages.size();
+        while (const auto item = Pop(stage)) {
+            std::ostringstream log;
+            auto result = Result::Drop;
+            std::exception_ptr error;
+            const auto begin = Clock::now();
+            try {
+                BuildLog::Capture(log, [&] { result = mStages[stage].Run(item->Index); });
+            } catch (...) { error = std::current_exception(); }
+            state.BusyNs += Nanoseconds(Clock::now() - begin);
+            ++state.Items;
+            if (error) {
+                Fail(error);
+                result = Result::Drop;
+            }
+
+            if (result == Result::Defer && !last) {
+                // Held items stop counting against the budget; waiting on them must not stall
+                // the items still to come
+                mMemory.Release(item->Bytes);
+                {
+                    std::lock_guard lock(state.Mutex);
+                    state.Deferred.push_back({item->Index, 0});
+                }
+                mProgress.Print(log.str(), false);
+                continue;
+            }
+            if (result == Result::Next && !last) {
+                const auto waitStart = Clock::now();
+                const bool pushed    = Push(stage + 1, *item);
+                state.StallNs += Nanoseconds(Clock::now() - waitStart);
+                if (pushed) {
+                    mProgress.Print(log.str(), false);
+                    continue;
+                }
+            }
+            mMemory.Release(item->Bytes);
+            mProgress.Print(log.str(), true);
+        }
+
+        // The last worker out passes the deferred items on and closes the next stage's queue
+        std::vector<Item> deferred;
+        {
+            std::lock_guard lock(state.Mutex);
+            if (--state.Running > 0) { return; }
+            deferred.swap(state.Deferred);
+        }
+        if (last) { return; }
+        if (!deferred.empty() && !mFailed) {
+            if (mStages[stage].Drain) {
+                std::vector<size_t> indices;
+                for (const auto& item : deferred) {
+                    indices.push_back(item.Index);
+                }
+                std::ostringstream log;
+                try {
+                    BuildLog::Capture(log, [&] { mStages[stage].Drain(indices); });
+                } catch (...) { Fail(std::current_exception()); }
+                mProgress.Print(log.str(), false);
+            }
+            for (const auto& item : deferred) {
+                if (!Push(stage + 1, item)) { break; }
+            }
+        }
+        Close(stage + 1);
+    }
+
+    /// @brief Blocks while the queue is full. False once the pipeline has failed.
+    bool Push(size_t stage, const Item& item) {
+        auto& state = mStates[stage];
+        {
+            std::unique_lock lock(state.Mutex);
+            state.NotFull.wait(lock, [&] {
+                return mFailed || state.Queue.size() < mQueueCapacity;
+            });
+            if (mFailed) { return false; }
+            state.Queue.push_back(item);
+        }
+        state.NotEmpty.notify_one();
+        return true;
+    }
+
+    /// @brief Blocks until an item arrives. Empty once the queue is closed and drained, or the
+    /// pipeline has failed.
+    std::optional<Item> Pop(size_t stage) {
+        auto& state = mStates[stage];
+        std::optional<Item> item;
+        {
+            std::unique_lock lock(state.Mutex);
+            state.NotEmpty.wait(lock, [&] {
+                return mFailed || state.Closed || !state.Queue.empty();
+            });
+            if (mFailed || state.Queue.empty()) { return std::nullopt; }
+            item = state.Queue.front();
+            state.Queue.pop_front();
+        }
+        state.NotFull.notify_one();
+        return item;
+    }
+
+    void Close(size_t stage) {
+        auto& state = mStates[stage];
+        {
+            std::lock_guard lock(state.Mutex);
+            state.Closed = true;
+        }
+        state.NotEmpty.notify_all();
+    }
+
+    /// @brief Records the first error and wakes everything that waits, so every thread exits.
+    void Fail(const std::exception_ptr& error) {
+        {
+            std::lock_guard lock(mErrorMutex);
+            if (!mError) { mError = error; }
+        }
+        mFailed = true;
+        mMemory.Cancel();
+        for (auto& state : mStates) {
+            // Taking the lock orders the flag before any waiter re-checks it
+            { std::lock_guard lock(state.Mutex); }
+            state.NotEmpty.notify_all();
+            state.NotFull.notify_all();
+        }
+    }
+
+    /// @brief Utilization is the share of the stage's worker time spent running items; blocked
+    /// is the share spent waiting for room downstream. The rest was spent waiting for input. A
+    /// stage near full utilization is the bottleneck and wants more workers; one that is mostly
+    /// blocked has more than the stages after it can take.
+    void PrintReport(f64 wall) const {
+        std::cout << "  | " << std::left << std::setw(10) << "Stage" << std::right
+                  << std::setw(8) << "Workers" << std::setw(8) << "Items" << std::setw(10)
+                  << "Busy (s)" << std::setw(13) << "Utilization" << std::setw(9) << "Blocked"
+                  << '\n'
+                  << std::fixed;
+        for (size_t stage = 0; stage < mStages.size(); ++stage) {
+            const auto& state  = mStates[stage];
+            const auto workers = std::max(1u, mStages[stage].Workers);
+            const auto busy    = CAST<f64>(state.BusyNs.load()) / 1e9;
+            const auto stalled = CAST<f64>(state.StallNs.load()) / 1e9;
+            const auto total   = std::max(wall * workers, 1e-9);
+            std::cout << "  | " << std::left << std::setw(10) << mStages[stage].Name
+                      << std::right << std::setw(8) << workers << std::setw(8)
+                      << state.Items.load() << std::setw(10) << std::setprecision(2) << busy
+                      << std::setw(12) << std::setprecision(0) << 100.0 * busy / total << '%'
+                      << std::setw(8) << 100.0 * stalled / total << "%\n";
+        }
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+};
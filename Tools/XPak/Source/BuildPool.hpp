@@ -0,0 +1,254 @@
+// Author: Jake Rieger
+// Created: 12/8/2024.
+//
+
+#pragma once
+
+#include <Types.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+/// @brief Console output of build tasks. A task's output is collected while it runs and written
+/// in one piece when it finishes, so parallel tasks never interleave.
+class BuildLog {
+public:
+    /// @brief The running task's buffer on a build thread, std::cout anywhere else.
+    static std::ostream& Out() {
+        return sCurrent ? *sCurrent : std::cout;
+    }
+
+    /// @brief Runs `fn` with Out() on this thread writing to `log`.
+    template<typename Fn>
+    static void Capture(std::ostringstream& log, Fn&& fn) {
+        struct Restore {
+            std::ostringstream* Previous;
+            ~Restore() {
+                sCurrent = Previous;
+            }
+        } restore {sCurrent};
+        sCurrent = &log;
+        fn();
+    }
+
+private:
+    static inline thread_local std::ostringstream* sCurrent = nullptr;
+};
+
+/// @brief Progress bar for a parallel build phase, drawn on the last console line while stdout
+/// is a terminal. Finished tasks print their logs above it.
+class BuildProgress {
+public:
+    BuildProgress() {
+#ifdef _WIN32
+        mShowProgress = _isatty(_fileno(stdout)) != 0;
+#else
+        mShowProgress = isatty(fileno(stdout)) != 0;
+#endif
+    }
+
+    void Start(const char* label, size_t total) {
+        std::lock_guard lock(mMutex);
+        mLabel    = label;
+        mTotal    = total;
+        mFinished = 0;
+        Draw();
+    }
+
+    /// @brief Prints `log` above the bar, and counts a task as finished if `advance` is set.
+    void Print(const str& log, bool advance) {
+        std::lock_guard lock(mMutex);
+        if (advance) { ++mFinished; }
+        if (mShowProgress) { std::cout << '\r' << str(kBarWidth + 32, ' ') << '\r'; }
+        std::cout << log;
+        Draw();
+    }
+
+    void Stop() const {
+        if (mShowProgress) { std::cout << std::endl; }
+    }
+
+private:
+    static constexpr i32 kBarWidth = 40;
+
+    bool mShowProgress = false;
+    std::mutex mMutex;
+    const char* mLabel = "";
+    size_t mTotal      = 0;
+    size_t mFinished   = 0;
+
+    /// @brief Called with mMutex held.
+    void Draw() const {
+        if (!mShowProgress) { return; }
+        const auto filled = CAST<i32>(kBarWidth * mFinished / std::max<size_t>(mTotal, 1));
+        std::cout << '\r' << "  [" << str(filled, '#') << str(kBarWidth - filled, '.') << "] "
+                  << mFinished << '/' << mTotal << ' ' << mLabel << std::flush;
+    }
+};
+
+/// @brief Estimated bytes held by build work in flight. Work waits for room before it starts; work
+/// too large for the whole budget starts once nothing else holds any, so it runs alone.
+class BuildMemory {
+public:
+    explicit BuildMemory(u64 budget) : mBudget(budget) {}
+
+    /// @brief Blocks until `bytes` fit. False if Cancel() was called first.
+    bool Acquire(u64 bytes) {
+        std::unique_lock lock(mMutex);
+        mCondition.wait(lock, [&] {
+            return mCancelled || mInUse == 0 || mInUse + bytes <= mBudget;
+        });
+        if (mCancelled) { return false; }
+        mInUse += bytes;
+        return true;
+    }
+
+    void Release(u64 bytes) {
+        {
+            std::lock_guard lock(mMutex);
+            mInUse -= bytes;
+        }
+        mCondition.notify_all();
+    }
+
+    /// @brief Wakes every waiting Acquire, which then fails.
+    void Cancel() {
+        {
+            std::lock_guard lock(mMutex);
+            mCancelled = true;
+        }
+        mCondition.notify_all();
+    }
+
+private:
+    u64 mBudget;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    u64 mInUse      = 0;
+    bool mCancelled = false;
+};
+
+/// @brief Fixed-size pool for build tasks. Each batch is dealt out largest first across
+/// per-thread queues; a thread that runs dry steals the smallest remaining task from another,
+/// so big assets start early and small ones fill in around them. A task only starts while the
+/// estimated bytes of everything running fit the memory budget (one task too big for it runs
+/// alone), which bounds how much decoded data is alive at once.
+class BuildPool {
+public:
+    static constexpr u64 kDefaultMemoryBudget = 2ull << 30;
+
+    struct Task {
+        u64 Weight;  // Larger tasks start first
+        u64 Bytes;   // Estimated peak memory, counted against the budget
+        std::function<void()> Run;
+    };
+
+    /// @brief `threads` = 0 uses every core.
+    explicit BuildPool(u32 threads = 0, u64 memoryBudget = kDefaultMemoryBudget)
+        : mThreadCount(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+          mMemory(memoryBudget), mQueues(mThreadCount) {}
+
+    [[nodiscard]] u32 GetThreadCount() const {
+        return mThreadCount;
+    }
+
+    /// @brief Runs every task and returns once all have finished, showing `label` on the
+    /// progress bar. Rethrows the first exception a task threw; tasks not yet started are
+    /// skipped after one fails.
+    void Run(const char* label, std::vector<Task> tasks) {
+        if (tasks.empty()) { return; }
+        std::ranges::sort(tasks, [](const Task& a, const Task& b) { return a.Weight > b.Weight; });
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            mQueues[i % mThreadCount].Tasks.push_back(&tasks[i]);
+        }
+        mError = nullptr;
+        mProgress.Start(label, tasks.size());
+
+        std::vector<std::thread> threads;
+        const auto count = std::min<size_t>(mThreadCount, tasks.size());
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([this, i] { WorkerLoop(i); });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (auto& queue : mQueues) {
+            queue.Tasks.clear();  // Left over only if a task failed
+        }
+
+        mProgress.Stop();
+        if (mError) { std::rethrow_exception(mError); }
+    }
+
+private:
+    struct Queue {
+        std::mutex Mutex;
+        std::deque<Task*> Tasks;  // Largest at the front
+    };
+
+    u32 mThreadCount;
+    BuildMemory mMemory;
+    std::vector<Queue> mQueues;
+    BuildProgress mProgress;
+
+    std::mutex mErrorMutex;
+    std::exception_ptr mError;  // The first a task threw
+
+    void WorkerLoop(size_t index) {
+        while (Task* task = Next(index)) {
+            mMemory.Acquire(task->Bytes);
+            std::ostringstream log;
+            std::exception_ptr error;
+            try {
+                BuildLog::Capture(log, task->Run);
+            } catch (...) { error = std::current_exception(); }
+            mMemory.Release(task->Bytes);
+            if (error) {
+                std::lock_guard lock(mErrorMutex);
+                if (!mError) { mError = error; }
+            }
+            mProgress.Print(log.str(), true);
+        }
+    }
+
+    /// @brief Own queue from the front (largest), then other queues from the back (smallest).
+    Task* Next(size_t index) {
+        {
+            std::lock_guard lock(mErrorMutex);
+            if (mError) { return nullptr; }
+        }
+        {
+            auto& own = mQueues[index];
+            std::lock_guard lock(own.Mutex);
+            if (!own.Tasks.empty()) {
+                Task* task = own.Tasks.front();
+                own.Tasks.pop_front();
+                return task;
+            }
+        }
+        for (size_t offset = 1; offset < mQueues.size(); ++offset) {
+            auto& victim = mQueues[(index + offset) % mQueues.size()];
+            std::lock_guard lock(victim.Mutex);
+            if (!victim.Tasks.empty()) {
+                Task* task = victim.Tasks.back();
+                victim.Tasks.pop_back();
+                return task;
+            }
+        }
+        return nullptr;  // Batches never grow, so every queue is done
+    }
+};
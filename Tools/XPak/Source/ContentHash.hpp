@@ -0,0 +1,82 @@
+// Author: Jake Rieger
+// Created: 12/8/2024.
+//
+
+#pragma once
+
+#include <MappedFile.hpp>
+#include <Types.hpp>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+#include <xxhash.h>
+
+/// @brief 128-bit XXH3 digest of a source file's contents, which the build cache compares to
+/// tell whether a source changed. Not cryptographic; it only has to notice edits.
+struct ContentHash {
+    /// @brief Data larger than this is hashed as independent chunks on several threads, then
+    /// the chunk digests are hashed together. The result does not depend on the thread count.
+    static constexpr size_t kChunkSize = 16 * 1024 * 1024;
+
+    u64 Low  = 0;
+    u64 High = 0;
+
+    bool operator==(const ContentHash& other) const = default;
+
+    /// @brief `threads` = 0 uses every core.
+    static ContentHash Bytes(std::span<const u8> data, u32 threads = 0) {
+        if (data.size() <= kChunkSize) { return From(XXH3_128bits(data.data(), data.size())); }
+
+        const size_t count = (data.size() + kChunkSize - 1) / kChunkSize;
+        std::vector<XXH128_canonical_t> digests(count);
+        std::atomic<size_t> next = 0;
+        const auto worker        = [&] {
+            for (size_t i = next++; i < count; i = next++) {
+                const auto chunk = data.subspan(i * kChunkSize,
+                                                std::min(kChunkSize, data.size() - i * kChunkSize));
+                XXH128_canonicalFromHash(&digests[i], XXH3_128bits(chunk.data(), chunk.size()));
+            }
+        };
+
+        if (threads == 0) { threads = std::max(1u, std::thread::hardware_concurrency()); }
+        std::vector<std::thread> pool;
+        const size_t helpers = std::min<size_t>(threads, count) - 1;
+        for (size_t i = 0; i < helpers; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        return From(XXH3_128bits(digests.data(), digests.size() * sizeof(XXH128_canonical_t)));
+    }
+
+    /// @brief Hashes the file through a read-only mapping. Empty if it can't be opened.
+    static std::optional<ContentHash> File(const std::filesystem::path& filename, u32 threads = 0) {
+        const auto file = MappedFile::Open(filename);
+        if (file) { return Bytes({file->Data(), file->Size()}, threads); }
+        // Empty files can't be mapped
+        std::error_code error;
+        if (std::filesystem::file_size(filename, error) == 0 && !error) { return Bytes({}); }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] str ToString() const {
+        static constexpr char kDigits[] = "0123456789abcdef";
+        str result(32, '0');
+        for (i32 i = 0; i < 16; ++i) {
+            result[15 - i] = kDigits[(High >> (i * 4)) & 0xF];
+            result[31 - i] = kDigits[(Low >> (i * 4)) & 0xF];
+        }
+        return result;
+    }
+
+private:
+    static ContentHash From(const XXH128_hash_t& hash) {
+        return {hash.low64, hash.high64};
+    }
+};
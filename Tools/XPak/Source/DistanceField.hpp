@@ -0,0 +1,135 @@
+// Author: Jake Rieger
+// Created: 12/3/2024.
+//
+
+#pragma once
+
+#include <Types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/// @brief Exact Euclidean distance transforms (Felzenszwalb & Huttenlocher) used to turn
+/// coverage bitmaps into signed distance fields. Runs in linear time in the pixel count.
+class DistanceField {
+public:
+    /// @brief Converts a `width` x `height` coverage bitmap (>= 128 is inside) into a signed
+    /// distance field downsampled by `scale`. The output is `outWidth` x `outHeight`, where the
+    /// source bitmap is placed `padding` output pixels in from the top-left. Distances are in
+    /// output pixels and encoded as 128 + d * 127 / spread, clamped to [0, 255].
+    static std::vector<u8> Generate(const std::vector<u8>& coverage,
+                                    u32 width,
+                                    u32 height,
+                                    u32 scale,
+                                    u32 padding,
+                                    u32 outWidth,
+                                    u32 outHeight,
+                                    f32 spread) {
+        // Work on a high-resolution grid that covers the whole (padded) output
+        const u32 gridWidth  = outWidth * scale;
+        const u32 gridHeight = outHeight * scale;
+        const u32 offset     = padding * scale;
+        const size_t cells   = CAST<size_t>(gridWidth) * gridHeight;
+
+        std::vector<f32> toInside(cells, kInfinity);
+        std::vector<f32> toOutside(cells, 0.f);
+        for (u32 y = 0; y < height && y + offset < gridHeight; ++y) {
+            for (u32 x = 0; x < width && x + offset < gridWidth; ++x) {
+                if (coverage[CAST<size_t>(y) * width + x] < 128) { continue; }
+                const size_t cell = CAST<size_t>(y + offset) * gridWidth + (x + offset);
+                toInside[cell]    = 0.f;
+                toOutside[cell]   = kInfinity;
+            }
+        }
+        Transform2D(toInside, gridWidth, gridHeight);
+        Transform2D(toOutside, gridWidth, gridHeight);
+
+        // Average the signed distance over each output texel's footprint
+        std::vector<u8> result(CAST<size_t>(outWidth) * outHeight);
+        const f32 invScale  = 1.f / CAST<f32>(scale);
+        const f32 invSample = 1.f / CAST<f32>(scale * scale);
+        for (u32 oy = 0; oy < outHeight; ++oy) {
+            for (u32 ox = 0; ox < outWidth; ++ox) {
+                f32 sum = 0.f;
+                for (u32 sy = 0; sy < scale; ++sy) {
+                    const size_t row = CAST<size_t>(oy * scale + sy) * gridWidth;
+                    for (u32 sx = 0; sx < scale; ++sx) {
+                        const size_t cell = row + ox * scale + sx;
+                        // Half a pixel puts the edge between an inside and outside texel
+                        sum += toOutside[cell] > 0.f ? std::sqrt(toOutside[cell]) - 0.5f
+                                                     : 0.5f - std::sqrt(toInside[cell]);
+                    }
+                }
+                const f32 distance = sum * invSample * invScale;
+                const f32 encoded  = 128.f + distance * 127.f / spread;
+                result[CAST<size_t>(oy) * outWidth + ox] =
+                  CAST<u8>(std::clamp(std::lround(encoded), 0l, 255l));
+            }
+        }
+
+        return result;
+    }
+
+private:
+    static constexpr f32 kInfinity = 1e20f;
+
+    /// @brief In-place squared distance transform of a sampled function (0 = feature,
+    /// kInfinity = background), columns first then rows.
+    static void Transform2D(std::vector<f32>& grid, u32 width, u32 height) {
+        const u32 longest = std::max(width, height);
+        std::vector<f32> f(longest), d(longest), z(longest + 1);
+        std::vector<i32> v(longest);
+
+        for (u32 x = 0; x < width; ++x) {
+            for (u32 y = 0; y < height; ++y) {
+                f[y] = grid[CAST<size_t>(y) * width + x];
+            }
+            Transform1D(f.data(), d.data(), v.data(), z.data(), height);
+            for (u32 y = 0; y < height; ++y) {
+                grid[CAST<size_t>(y) * width + x] = d[y];
+            }
+        }
+
+        for (u32 y = 0; y < height; ++y) {
+            f32* row = grid.data() + CAST<size_t>(y) * width;
+            std::copy_n(row, width, f.data());
+            Transform1D(f.data(), d.data(), v.data(), z.data(), width);
+            std::copy_n(d.data(), width, row);
+        }
+    }
+
+    /// @brief 1D squared distance transform via the lower envelope of parabolas.
+    static void Transform1D(const f32* f, f32* d, i32* v, f32* z, u32 n) {
+        if (n == 0) { return; }
+        const auto intersect = [&](i32 q, i32 p) {
+            return ((f[q] + CAST<f32>(q * q)) - (f[p] + CAST<f32>(p * p))) /
+                   CAST<f32>(2 * q - 2 * p);
+        };
+
+        i32 k = 0;
+        v[0]  = 0;
+        z[0]  = -kInfinity;
+        z[1]  = kInfinity;
+        for (i32 q = 1; q < CAST<i32>(n); ++q) {
+            // z[0] is -infinity, so this always stops at k = 0
+            f32 s = intersect(q, v[k]);
+            while (s <= z[k]) {
+                --k;
+                s = intersect(q, v[k]);
+            }
+            ++k;
+            v[k]     = q;
+            z[k]     = s;
+            z[k + 1] = kInfinity;
+        }
+
+        k = 0;
+        for (i32 q = 0; q < CAST<i32>(n); ++q) {
+            while (z[k + 1] < CAST<f32>(q)) {
+                ++k;
+            }
+            const f32 delta = CAST<f32>(q - v[k]);
+            d[q]            = delta * delta + f[v[k]];
+        }
+    }
+};
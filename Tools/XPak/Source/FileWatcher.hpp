@@ -0,0 +1,248 @@
+// Author: Jake Rieger
+// Created: 12/10/2024.
+//
+
+#pragma once
+
+#include <Types.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <ranges>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+/// @brief Reports paths that change under a directory tree. On Linux this is inotify, which
+/// wakes as soon as a file is written and closed. Elsewhere, or when inotify is unavailable or
+/// out of watches, the tree is rescanned every kPollInterval and compared by size and
+/// modification time.
+class FileWatcher {
+public:
+    static constexpr auto kPollInterval = std::chrono::milliseconds(250);
+    /// @brief Changes closer together than this are reported together, so an editor saving
+    /// through a temporary file and a rename, or a tool exporting several files, triggers one
+    /// rebuild.
+    static constexpr auto kSettleTime = std::chrono::milliseconds(30);
+
+    /// @brief Watches everything under `root` except the `excluded` directories, which keeps
+    /// the build's own outputs from waking it.
+    FileWatcher(const std::filesystem::path& root, std::vector<std::filesystem::path> excluded)
+        : mRoot(Normalize(root)) {
+        for (const auto& path : excluded) {
+            mExcluded.push_back(Normalize(path));
+        }
+#ifdef __linux__
+        mInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (mInotify >= 0 && AddWatches(mRoot, nullptr)) { return; }
+        StopInotify();
+#endif
+        Scan(mSnapshot);
+    }
+
+    ~FileWatcher() {
+#ifdef __linux__
+        StopInotify();
+#endif
+    }
+
+    FileWatcher(const FileWatcher&)            = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    [[nodiscard]] bool IsPolling() const {
+#ifdef __linux__
+        return mInotify < 0;
+#else
+        return true;
+#endif
+    }
+
+    /// @brief Blocks up to `timeout` for something to change, then returns every path created,
+    /// written, removed or renamed until things settle. A directory in the result means
+    /// anything under it may have changed. Empty on timeout.
+    std::vector<std::filesystem::path> Wait(std::chrono::milliseconds timeout) {
+#ifdef __linux__
+        if (!IsPolling()) {
+            if (!Poll(timeout)) { return {}; }
+            std::set<std::filesystem::path> changed;
+            bool complete = true;
+            do {
+                complete &= ReadEvents(changed);
+            } while (Poll(kSettleTime));
+            if (mExhausted) {
+                // New directories can't be watched, so everything is polled from now on
+                StopInotify();
+                Scan(mSnapshot);
+            }
+            // Some events were lost, so anything may have changed
+            if (!complete) { return {mRoot}; }
+            return {changed.begin(), changed.end()};
+        }
+#endif
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (;;) {
+            auto changed = Rescan();
+            if (!changed.empty()) { return changed; }
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) { return {}; }
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+              kPollInterval,
+              deadline - now));
+        }
+    }
+
+private:
+    struct Stamp {
+        std::uintmax_t Size;
+        std::filesystem::file_time_type MTime;
+
+        bool operator==(const Stamp& other) const = default;
+    };
+
+    std::filesystem::path mRoot;
+    std::vector<std::filesystem::path> mExcluded;
+    std::unordered_map<str, Stamp> mSnapshot;  // Path -> stamp, when polling
+#ifdef __linux__
+    int mInotify    = -1;
+    bool mExhausted = false;  // Ran out of inotify watches
+    std::unordered_map<int, std::filesystem::path> mWatches;  // Watch descriptor -> directory
+#endif
+
+    static std::filesystem::path Normalize(const std::filesystem::path& path) {
+        auto normal = std::filesystem::absolute(path).lexically_normal();
+        if (!normal.has_filename()) { normal = normal.parent_path(); }  // Trailing separator
+        return normal;
+    }
+
+    [[nodiscard]] bool IsExcluded(const std::filesystem::path& path) const {
+        return std::ranges::any_of(mExcluded, [&](const std::filesystem::path& excluded) {
+            const auto [end, _] =
+              std::mismatch(excluded.begin(), excluded.end(), path.begin(), path.end());
+            return end == excluded.end();
+        });
+    }
+
+    /// @brief Size and modification time of every file under the root.
+    void Scan(std::unordered_map<str, Stamp>& files) const {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(mRoot, error);
+             it != std::filesystem::recursive_directory_iterator();
+             it.increment(error)) {
+            if (error) { break; }
+            if (IsExcluded(it->path())) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (!it->is_regular_file(error)) { continue; }
+            const Stamp stamp {it->file_size(error), it->last_write_time(error)};
+            files.insert_or_assign(it->path().string(), stamp);
+        }
+    }
+
+    std::vector<std::filesystem::path> Rescan() {
+        std::unordered_map<str, Stamp> current;
+        Scan(current);
+        std::vector<std::filesystem::path> changed;
+        for (const auto& [path, stamp] : current) {
+            const auto previous = mSnapshot.find(path);
+            if (previous == mSnapshot.end() || !(previous->second == stamp)) {
+                changed.push_back(path);
+            }
+        }
+        for (const auto& path : mSnapshot | std::views::keys) {
+            if (!current.contains(path)) { changed.push_back(path); }
+        }
+        mSnapshot = std::move(current);
+        return changed;
+    }
+
+#ifdef __linux__
+    static constexpr u32 kEvents =
+      IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+    void StopInotify() {
+        if (mInotify >= 0) { close(mInotify); }
+        mInotify = -1;
+        mWatches.clear();
+    }
+
+    /// @brief Watches `directory` and every directory below it, adding the files found to
+    /// `found` if given (they may have been written before their directory was watched). False
+    /// when out of watches.
+    bool AddWatches(const std::filesystem::path& directory,
+                    std::set<std::filesystem::path>* found) {
+        const auto watch = [&](const std::filesystem::path& path) {
+            const int descriptor = inotify_add_watch(mInotify, path.c_str(), kEvents);
+            // A directory removed while being walked is no loss
+            if (descriptor < 0) { return errno != ENOSPC && errno != ENOMEM; }
+            mWatches.insert_or_assign(descriptor, path);
+            return true;
+        };
+        if (!watch(directory)) { return false; }
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+             it != std::filesystem::recursive_directory_iterator();
+             it.increment(error)) {
+            if (error) { break; }
+            if (IsExcluded(it->path())) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (it->is_directory(error)) {
+                if (!watch(it->path())) { return false; }
+            } else if (found) {
+                found->insert(it->path());
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool Poll(std::chrono::milliseconds timeout) const {
+        pollfd descriptor {mInotify, POLLIN, 0};
+        return poll(&descriptor, 1, CAST<int>(timeout.count())) > 0;
+    }
+
+    /// @brief Adds the paths named by every pending event to `changed`. False if the kernel
+    /// dropped events or a new directory couldn't be watched, so some changes went unseen.
+    bool ReadEvents(std::set<std::filesystem::path>& changed) {
+        alignas(inotify_event) char buffer[64 * 1024];
+        bool complete = true;
+        for (;;) {
+            const auto length = read(mInotify, buffer, sizeof(buffer));
+            if (length <= 0) { return complete; }
+            for (const char* next = buffer; next < buffer + length;) {
+                const auto* event = RCAST<const inotify_event*>(next);
+                next += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    complete = false;
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    mWatches.erase(event->wd);  // Its directory is gone
+                    continue;
+                }
+                const auto directory = mWatches.find(event->wd);
+                if (directory == mWatches.end()) { continue; }
+                auto path = directory->second;
+                if (event->len > 0) { path /= event->name; }
+                if (IsExcluded(path)) { continue; }
+                changed.insert(path);
+                if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                    if (!AddWatches(path, &changed)) {
+                        mExhausted = true;
+                        complete   = false;
+                    }
+                }
+            }
+        }
+    }
+#endif
+};
@@ -0,0 +1,230 @@
+// Author: Jake Rieger
+// Created: 12/3/2024.
+//
+
+#pragma once
+
+#include "BuildError.hpp"
+#include "DistanceField.hpp"
+#include "RectPacker.hpp"
+
+#include <FontFormat.hpp>
+#include <Panic.hpp>
+#include <Types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/// @brief Builds a signed-distance-field glyph atlas from a TrueType/OpenType font. Glyphs are
+/// rasterized serially (FreeType faces are not thread-safe) at `kSuperSample` times the target
+/// size, then converted to distance fields in parallel and packed into a single R8 page.
+class FontAtlas {
+public:
+    static constexpr u32 kSuperSample  = 4;
+    static constexpr u32 kMaxCodepoint = 0x10FFFF;
+
+    /// @brief Parses a charset of the form "32-126,160-255,8364" into a sorted list of unique
+    /// codepoints. Throws BuildError for a malformed or reversed range.
+    static std::vector<u32> ParseCharset(const str& charset) {
+        std::vector<u32> codepoints;
+        std::stringstream stream(charset);
+        str range;
+        while (std::getline(stream, range, ',')) {
+            if (range.empty()) { continue; }
+            const auto dash = range.find('-');
+            const auto end  = dash == str::npos ? range : range.substr(dash + 1);
+            const u32 first = ParseUInt(range.substr(0, dash), "charset codepoint", kMaxCodepoint);
+            const u32 last  = ParseUInt(end, "charset codepoint", kMaxCodepoint);
+            if (last < first) { throw BuildError("Invalid charset range: '%s'", range.c_str()); }
+            for (u32 cp = first; cp <= last; ++cp) {
+                codepoints.push_back(cp);
+            }
+        }
+        std::ranges::sort(codepoints);
+        codepoints.erase(std::ranges::unique(codepoints).begin(), codepoints.end());
+        return codepoints;
+    }
+
+    /// @brief `font` is the font file's contents.
+    static std::vector<u8> Build(std::span<const u8> font,
+                                 u32 size,
+                                 u32 spread,
+                                 const std::vector<u32>& codepoints,
+                                 std::unordered_map<str, str>& metadata) {
+        FT_Library library;
+        if (FT_Init_FreeType(&library)) { Panic("Failed to initialize FreeType"); }
+        FT_Face face;
+        if (FT_New_Memory_Face(library, font.data(), CAST<FT_Long>(font.size()), 0, &face)) {
+            FT_Done_FreeType(library);
+            throw BuildError("Failed to load font");
+        }
+        FT_Set_Pixel_Sizes(face, 0, size * kSuperSample);
+
+        const f32 invScale   = 1.f / CAST<f32>(kSuperSample);
+        const f32 lineHeight = CAST<f32>(face->size->metrics.height) / 64.f * invScale;
+        const f32 ascender   = CAST<f32>(face->size->metrics.ascender) / 64.f * invScale;
+        const f32 descender  = CAST<f32>(face->size->metrics.descender) / 64.f * invScale;
+
+        std::vector<Glyph> glyphs;
+        glyphs.reserve(codepoints.size());
+        for (const auto cp : codepoints) {
+            if (FT_Load_Char(face, cp, FT_LOAD_RENDER) != 0) { continue; }
+            const auto* slot = face->glyph;
+            const auto& bmp  = slot->bitmap;
+
+            Glyph glyph {};
+            glyph.Codepoint = cp;
+            glyph.Advance   = CAST<f32>(slot->advance.x) / 64.f * invScale;
+            glyph.Left      = CAST<f32>(slot->bitmap_left) * invScale;
+            glyph.Top       = CAST<f32>(slot->bitmap_top) * invScale;
+            glyph.HiWidth   = bmp.width;
+            glyph.HiHeight  = bmp.rows;
+            glyph.Coverage.resize(CAST<size_t>(bmp.width) * bmp.rows);
+            for (u32 row = 0; row < bmp.rows; ++row) {
+                const u8* src = bmp.buffer + CAST<i64>(row) * bmp.pitch;
+                std::copy_n(src, bmp.width, glyph.Coverage.data() + CAST<size_t>(row) * bmp.width);
+            }
+            glyphs.push_back(std::move(glyph));
+        }
+        FT_Done_Face(face);
+        FT_Done_FreeType(library);
+
+        if (glyphs.empty()) { throw BuildError("Font contains none of the requested glyphs"); }
+
+        // Distance fields dominate build time. They're generated on the calling build worker,
+        // since the build already runs one transform per -j worker
+        for (auto& glyph : glyphs) {
+            GenerateField(glyph, spread);
+        }
+
+        // Pack tallest first (ties broken by codepoint) so the layout is deterministic
+        std::vector<Glyph*> order;
+        for (auto& glyph : glyphs) {
+            order.push_back(&glyph);
+        }
+        std::ranges::sort(order, [](const Glyph* a, const Glyph* b) {
+            if (a->Height != b->Height) { return a->Height > b->Height; }
+            return a->Codepoint < b->Codepoint;
+        });
+
+        u32 atlasWidth  = 128;
+        u32 atlasHeight = 128;
+        while (!TryPack(order, atlasWidth, atlasHeight)) {
+            if (atlasWidth <= atlasHeight) {
+                atlasWidth *= 2;
+            } else {
+                atlasHeight *= 2;
+            }
+            if (atlasWidth > 16384) { throw BuildError("Font atlas exceeds 16384x16384"); }
+        }
+
+        // Write glyphs top-down, then flip rows so V = 0 is the bottom of the texture
+        std::vector<u8> atlas(CAST<size_t>(atlasWidth) * atlasHeight, 0);
+        std::vector<FontFormat::GlyphMetrics> metrics;
+        metrics.reserve(glyphs.size());
+        const f32 invWidth  = 1.f / CAST<f32>(atlasWidth);
+        const f32 invHeight = 1.f / CAST<f32>(atlasHeight);
+        for (const auto& glyph : glyphs) {
+            for (u32 row = 0; row < glyph.Height; ++row) {
+                const u32 flipped = atlasHeight - 1 - (glyph.Y + row);
+                std::copy_n(glyph.Field.data() + CAST<size_t>(row) * glyph.Width,
+                            glyph.Width,
+                            atlas.data() + CAST<size_t>(flipped) * atlasWidth + glyph.X);
+            }
+
+            FontFormat::GlyphMetrics glyphMetrics {};
+            glyphMetrics.Codepoint = glyph.Codepoint;
+            glyphMetrics.Advance   = glyph.Advance;
+            glyphMetrics.OffsetX   = glyph.Left - CAST<f32>(spread);
+            glyphMetrics.OffsetY   = glyph.Top + CAST<f32>(spread);
+            glyphMetrics.Width     = CAST<f32>(glyph.Width);
+            glyphMetrics.Height    = CAST<f32>(glyph.Height);
+            glyphMetrics.U0        = CAST<f32>(glyph.X) * invWidth;
+            glyphMetrics.U1        = CAST<f32>(glyph.X + glyph.Width) * invWidth;
+            glyphMetrics.V0        = CAST<f32>(atlasHeight - glyph.Y - glyph.Height) * invHeight;
+            glyphMetrics.V1        = CAST<f32>(atlasHeight - glyph.Y) * invHeight;
+            metrics.push_back(glyphMetrics);
+        }
+
+        FontFormat::FontHeader header {};
+        std::copy_n(FontFormat::kMagic, 4, header.Magic);
+        header.GlyphCount  = CAST<u32>(metrics.size());
+        header.AtlasWidth  = atlasWidth;
+        header.AtlasHeight = atlasHeight;
+        header.Size        = CAST<f32>(size);
+        header.Spread      = CAST<f32>(spread);
+        header.LineHeight  = lineHeight;
+        header.Ascender    = ascender;
+        header.Descender   = descender;
+
+        const size_t metricsBytes = metrics.size() * sizeof(FontFormat::GlyphMetrics);
+        std::vector<u8> result(sizeof(header) + metricsBytes + atlas.size());
+        memcpy(result.data(), &header, sizeof(header));
+        memcpy(result.data() + sizeof(header), metrics.data(), metricsBytes);
+        memcpy(result.data() + sizeof(header) + metricsBytes, atlas.data(), atlas.size());
+
+        metadata.insert_or_assign("width", std::to_string(atlasWidth));
+        metadata.insert_or_assign("height", std::to_string(atlasHeight));
+        metadata.insert_or_assign("glyphs", std::to_string(metrics.size()));
+        metadata.insert_or_assign("size", std::to_string(size));
+        metadata.insert_or_assign("spread", std::to_string(spread));
+
+        return result;
+    }
+
+private:
+    struct Glyph {
+        u32 Codepoint;
+        f32 Advance;
+        f32 Left;
+        f32 Top;
+        u32 HiWidth;
+        u32 HiHeight;
+        std::vector<u8> Coverage;  // Super-sampled FreeType bitmap
+        u32 Width;                 // Distance field size, including spread padding
+        u32 Height;
+        std::vector<u8> Field;
+        u32 X;  // Atlas position (top-down)
+        u32 Y;
+    };
+
+    static void GenerateField(Glyph& glyph, u32 spread) {
+        // Whitespace has an advance but nothing to draw, so it takes no atlas space
+        if (glyph.HiWidth == 0 || glyph.HiHeight == 0) { return; }
+
+        const u32 width  = (glyph.HiWidth + kSuperSample - 1) / kSuperSample;
+        const u32 height = (glyph.HiHeight + kSuperSample - 1) / kSuperSample;
+        glyph.Width      = width + 2 * spread;
+        glyph.Height     = height + 2 * spread;
+        glyph.Field      = DistanceField::Generate(glyph.Coverage,
+                                              glyph.HiWidth,
+                                              glyph.HiHeight,
+                                              kSuperSample,
+                                              spread,
+                                              glyph.Width,
+                                              glyph.Height,
+                                              CAST<f32>(spread));
+        glyph.Coverage.clear();
+        glyph.Coverage.shrink_to_fit();
+    }
+
+    static bool TryPack(const std::vector<Glyph*>& glyphs, u32 width, u32 height) {
+        // One texel of padding keeps bilinear filtering from bleeding between glyphs
+        SkylinePacker packer(width, height);
+        for (auto* glyph : glyphs) {
+            if (glyph->Width == 0) { continue; }
+            const auto rect = packer.Insert(glyph->Width + 1, glyph->Height + 1);
+            if (!rect.has_value()) { return false; }
+            glyph->X = rect->X;
+            glyph->Y = rect->Y;
+        }
+        return true;
+    }
+};
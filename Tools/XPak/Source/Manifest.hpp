@@ -4,37 +4,83 @@
 
 #pragma once
 
+#include "ArchiveFile.hpp"
+#include "ArtifactStore.hpp"
 #include "Asset.hpp"
 #include "BuildCache.hpp"
+#include "BuildError.hpp"
+#include "BuildPipeline.hpp"
+#include "BuildPool.hpp"
 #include "MetadataFile.hpp"
 #include "PakFile.hpp"
 #include "Processors.inl"
 
 #include <Types.hpp>
 #include <Compression.hpp>
-#include <future>
-#include <ranges>
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <numeric>
+#include <sha256.h>
 #include <thread>
+#include <unordered_set>
 #include <filesystem>
 
 namespace fs = std::filesystem;
 
 class Manifest {
 public:
+    static constexpr size_t kDefaultDictionarySize = 64 * 1024;
+    static constexpr std::array<const char*, 5> kStages = {
+      "read", "decode", "transform", "compress", "write"};
+    static constexpr u32 kIoWorkers = 2;
+
     fs::path RootDir;
     fs::path OutputDir;
-    bool Compress;
+    str Archive;  // When set, every asset is also linked into <OutputDir>/<Archive>.xpak
+    /// @brief Codec for assets without their own <Codec> setting or a <Codecs> entry for their
+    /// type. The legacy <Compress>true</Compress> means LZMA.
+    CodecSettings DefaultCodec;
+    std::unordered_map<AssetType, CodecSettings> TypeCodecs;
+    /// @brief Capacity of each trained dictionary, for assets using the zstd-dict codec.
+    size_t DictionarySize = kDefaultDictionarySize;
+    /// @brief Build threads; 0 uses every core.
+    u32 Jobs = 0;
+    /// @brief Cap on the estimated bytes held by assets being built at the same time. Assets
+    /// compressed against a trained dictionary wait for training with their processed payloads
+    /// held outside the budget (see BuildPipeline).
+    u64 MemoryBudget = BuildPool::kDefaultMemoryBudget;
+    /// @brief Built assets shared with other machines, consulted before processing anything.
+    /// Null builds everything locally.
+    Shared<IArtifactStore> Artifacts;
+    /// @brief Threads per build stage (see BuildAssets) by stage name. Stages not listed get
+    /// kIoWorkers for reading and writing, and Jobs for the rest.
+    std::unordered_map<str, u32> StageWorkers;
+    /// @brief Assets waiting in front of each build stage before the stage feeding it blocks.
+    size_t QueueCapacity = BuildPipeline::kDefaultQueueCapacity;
     std::vector<Asset> Assets;
 
-    explicit Manifest(const str& filename) : Compress(false) {
+    explicit Manifest(const str& filename) {
         Assets.clear();
         pugi::xml_document doc;
         const pugi::xml_parse_result result = doc.load_file(filename.c_str());
-        if (!result) { Panic("Failed to load manifest file"); }
+        if (!result) { throw BuildError("Failed to load manifest file: %s", filename.c_str()); }
         RootDir                     = fs::canonical(filename).parent_path();
         const auto& rootNode        = doc.child("PakManifest");
         OutputDir                   = fs::path(rootNode.child_value("OutputDir"));
-        Compress                    = rootNode.child("Compress").text().as_bool();
+        Archive                     = rootNode.child_value("Archive");
+        if (rootNode.child("Compress").text().as_bool()) { DefaultCodec.Type = Codec::LZMA; }
+        if (const auto codecNode = rootNode.child("Codec")) {
+            DefaultCodec = ParseCodec(codecNode.text().as_string());
+        }
+        for (const auto& typeNode : rootNode.child("Codecs").children()) {
+            TypeCodecs.insert_or_assign(GetAssetTypeFromString(typeNode.name()),
+                                        ParseCodec(typeNode.text().as_string()));
+        }
+        if (const auto sizeNode = rootNode.child("DictionarySize")) {
+            DictionarySize = sizeNode.text().as_ullong(kDefaultDictionarySize);
+        }
+        mContentDir                 = RootDir / OutputDir;
         const auto& contentNode     = rootNode.child("Content");
         const auto& contentChildren = contentNode.children("Asset");
         const i64 assetCount        = std::distance(contentChildren.begin(), contentChildren.end());
@@ -43,75 +89,201 @@ public:
             const auto& assetName   = asset.attribute("name").as_string();
             const auto& assetType   = asset.child_value("Type");
             const auto& assetSource = asset.child_value("Source");
-            Assets.emplace_back(assetName, assetType, assetSource);
+            auto& entry             = Assets.emplace_back(assetName, assetType, assetSource);
+            for (const auto& setting : asset.children()) {
+                const str key = setting.name();
+                if (key == "Type" || key == "Source") { continue; }
+                entry.Settings.insert_or_assign(key, setting.text().as_string());
+            }
         }
 
-        // Load build cache if it exists
-        const auto cacheFile = RootDir / ".build_cache";
-        if (exists(cacheFile)) {
-            mCache = std::make_unique<BuildCache>(cacheFile.string().c_str());
-        } else {
-            mCache = std::make_unique<BuildCache>();
-        }
+        mCache = std::make_unique<BuildCache>(RootDir / BuildCache::kCacheName);
     }
 
     ~Manifest() {
         mCache.reset();
     }
 
-    void Build() const {
-        std::vector<std::pair<const Asset*, fs::path>> assetsToBuild;
+    struct UpdateResult {
+        std::vector<str> Updated;  // Names of the assets whose outputs were written or fetched
+        size_t Failed = 0;         // Assets left out over a BuildError or a failed write
+    };
+
+    /// @brief False if any asset failed to build; the rest are built and archived regardless.
+    bool Build() const {
+        std::vector<size_t> all(Assets.size());
+        std::iota(all.begin(), all.end(), 0);
+        const auto result = Update(all);
+        if (!Archive.empty()) { WriteArchive(); }
+        if (result.Failed > 0) { std::cout << result.Failed << " assets failed to build\n"; }
+        return result.Failed == 0;
+    }
+
+    /// @brief Brings the assets at `indices` up to date without touching the archive. An asset
+    /// that fails keeps its previous outputs. The cache entries of the other assets are kept as
+    /// they are.
+    UpdateResult Update(const std::vector<size_t>& indices) const {
+        BuildPool pool(Jobs, MemoryBudget);
         for (const auto& asset : Assets) {
-            fs::path sourceFile = RootDir / asset.Source;
-            bool rebuild        = false;
-            if (auto checksum = mCache->GetChecksum(asset.Source)) {
-                auto currentHash = BuildCache::CalculateChecksum(canonical(sourceFile).string());
-                if (currentHash != checksum) {
-                    mCache->Update(asset.Source, currentHash);
-                    rebuild = true;
-                }
-            } else {
-                auto currentHash = BuildCache::CalculateChecksum(canonical(sourceFile).string());
-                mCache->Update(asset.Source, currentHash);
-                rebuild = true;
+            mCache->Find(asset.Source);
+        }
+
+        // An asset rebuilds unless its source, type, processor version and settings match the
+        // cache and its outputs are still what was written. Only files whose size, mtime or
+        // inode moved since the last build are read; those are hashed in parallel, biggest first
+        std::vector<BuildCache::AssetEntry> current(Assets.size());
+        std::vector<const BuildCache::AssetEntry*> previous(Assets.size());
+        std::vector<u8> upToDate(Assets.size(), 0);
+        std::vector<u8> failed(Assets.size(), 0);
+        const auto check = [&](size_t i, const fs::path& sourceFile) {
+            const auto& asset = Assets[i];
+            auto& entry       = current[i];
+            try {
+                // Atlases are sourced from a directory and only repack when a member changes
+                entry.Source =
+                  asset.Type == AssetType::Atlas
+                    ? mCache->CalculateChecksum(AtlasBuilder::ListMembers(sourceFile), sourceFile)
+                    : mCache->CalculateChecksum(sourceFile);
+                // Resolves the codec, so an unknown one is caught here too
+                entry.Settings = HashSettings(asset);
+            } catch (const BuildError& error) {
+                BuildLog::Out() << "  |  [ERROR] Not building asset: " << asset.Name << " ("
+                                << error.what() << ")\n";
+                failed[i] = 1;
+                return;
+            }
+            entry.Type             = CAST<u32>(asset.Type);
+            entry.ProcessorVersion = Processors::kVersion;
+            if (!previous[i] || !previous[i]->SameInputs(entry)) { return; }
+            upToDate[i] = mCache->GetFileChecksum(GetOutputFile(asset, ".xpkf")) ==
+                            previous[i]->Pak &&
+                          mCache->GetFileChecksum(GetOutputFile(asset, ".xmdf")) ==
+                            previous[i]->Metadata;
+        };
+        std::vector<BuildPool::Task> tasks;
+        for (const auto i : indices) {
+            previous[i] = mCache->Find(Assets[i].Source);
+            std::error_code error;
+            auto sourceFile = fs::canonical(RootDir / Assets[i].Source, error);
+            if (error) {
+                std::cout << "  |  [ERROR] Not building asset: " << Assets[i].Name
+                          << " (source not found)\n";
+                failed[i] = 1;
+                continue;
             }
+            const auto weight =
+              fs::is_directory(sourceFile) ? ~0ull : CAST<u64>(fs::file_size(sourceFile, error));
+            tasks.push_back({weight, 0, [&, i, sourceFile = std::move(sourceFile)] {
+                                 check(i, sourceFile);
+                             }});
+        }
+        pool.Run("checked", std::move(tasks));
 
-            if (rebuild) {
-                assetsToBuild.emplace_back(&asset, sourceFile);
-            } else {
+        std::vector<std::pair<const Asset*, fs::path>> assetsToBuild;
+        std::vector<BuildCache::AssetEntry> entries;
+        for (const auto i : indices) {
+            const auto& asset = Assets[i];
+            if (failed[i]) { continue; }
+            if (upToDate[i]) {
                 std::cout << "  | Skipping unchanged asset: " << asset.Name << '\n';
+                continue;
             }
+            assetsToBuild.emplace_back(&asset, RootDir / asset.Source);
+            entries.push_back(current[i]);
         }
+        UpdateResult result;
+        result.Failed = std::ranges::count(failed, 1);
+        if (Artifacts) { result.Updated = FetchArtifacts(pool, assetsToBuild, entries); }
 
-        std::vector<std::future<void>> futures;
-        for (const auto& asset : assetsToBuild | std::views::keys) {
-            futures.emplace_back(std::async(std::launch::async, [&]() {
-                static std::atomic<i32> assetId = 1;
-                const int localId               = assetId.fetch_add(1);
-                std::cout << "  | [" << localId << "/" << assetsToBuild.size()
-                          << "] Building asset: " << asset->Name << '\n';
-                BuildAsset(mContentDir, *asset, std::filesystem::path(asset->Source), Compress);
-            }));
+        std::cout << "  | Building " << assetsToBuild.size() << " assets\n";
+        const auto written = BuildAssets(assetsToBuild, entries);
+
+        // Assets that failed to build stay out of the cache so the next build retries them. The
+        // settings are hashed again now that any dictionaries they use exist.
+        for (size_t i = 0; i < assetsToBuild.size(); ++i) {
+            if (!written[i]) {
+                ++result.Failed;
+                continue;
+            }
+            entries[i].Settings = HashSettings(*assetsToBuild[i].first);
+            mCache->Update(assetsToBuild[i].first->Source, entries[i]);
+            result.Updated.push_back(assetsToBuild[i].first->Name);
         }
+        mCache->SaveToFile(RootDir);
+        if (Artifacts) { Artifacts->Trim(); }
+        return result;
+    }
 
-        // Wait for all the tasks to complete
-        for (auto& future : futures) {
-            if (future.valid()) future.get();
+    /// @brief Indices of the assets built from any of the `changed` paths: their source file, a
+    /// file inside an atlas's directory, or a directory holding their source. Assets whose
+    /// source is gone are left out, keeping their last outputs.
+    [[nodiscard]] std::vector<size_t>
+    FindAffected(const std::vector<fs::path>& changed) const {
+        const auto contains = [](const fs::path& directory, const fs::path& path) {
+            const auto [end, _] =
+              std::mismatch(directory.begin(), directory.end(), path.begin(), path.end());
+            return end == directory.end();
+        };
+        std::vector<fs::path> paths;
+        for (const auto& path : changed) {
+            paths.push_back(Normalize(path));
         }
 
-        mCache->SaveToFile(RootDir.string());
+        std::vector<size_t> affected;
+        for (size_t i = 0; i < Assets.size(); ++i) {
+            const auto& asset = Assets[i];
+            const auto source = Normalize(RootDir / asset.Source);
+            const bool hit    = std::ranges::any_of(paths, [&](const fs::path& path) {
+                return contains(path, source) ||
+                       (asset.Type == AssetType::Atlas && contains(source, path));
+            });
+            if (!hit) { continue; }
+            if (!fs::exists(source)) {
+                std::cout << "  |  [WARNING] Source of asset '" << asset.Name
+                          << "' is missing: " << source.string() << '\n';
+                continue;
+            }
+            affected.push_back(i);
+        }
+        return affected;
     }
 
-    void Rebuild() {
+    bool Rebuild() {
         Clean();
-        Build();
+        return Build();
     }
 
     void Clean() {
         mContentDir         = CreateOutputDir();
-        const auto cacheFile = RootDir / ".build_cache";
+        const auto cacheFile = RootDir / BuildCache::kCacheName;
         if (exists(cacheFile)) { remove(cacheFile); }
-        mCache->Assets.clear();
+        mCache->Clear();
+    }
+
+    /// @brief Links every built asset and dictionary into <OutputDir>/<Archive>.xpak.
+    void WriteArchive() const {
+        std::vector<ArchiveFile::Input> inputs;
+        for (const auto& asset : Assets) {
+            const auto pakFile      = GetOutputFile(asset, ".xpkf");
+            const auto metadataFile = GetOutputFile(asset, ".xmdf");
+            if (!fs::exists(pakFile)) {
+                std::cout << "  |  [WARNING] Not archiving unbuilt asset: " << asset.Name << '\n';
+                continue;
+            }
+            inputs.push_back({asset.Name, pakFile, metadataFile});
+        }
+
+        std::vector<fs::path> dictionaries;
+        for (const auto& entry : fs::directory_iterator(mContentDir)) {
+            if (entry.path().extension() == ".xdict") { dictionaries.push_back(entry.path()); }
+        }
+        std::ranges::sort(dictionaries);
+
+        const auto archiveFile = mContentDir / (Archive + ".xpak");
+        std::cout << "  | Writing archive: " << archiveFile.string() << '\n';
+        if (!ArchiveFile::Write(inputs, dictionaries, archiveFile)) {
+            std::cout << "  |  [ERROR] Writing archive failed.\n";
+        }
     }
 
 private:
@@ -130,50 +302,479 @@ private:
         return contentDir;
     }
 
-    static void BuildAsset(const fs::path& outputDir,
-                           const Asset& asset,
-                           const fs::path& sourceFile,
-                           const bool compress = false) {
-        auto outputFile = outputDir / sourceFile;
-        outputFile.replace_extension(".xpkf");
-        if (fs::exists(outputFile)) { fs::remove(outputFile); }
-        fs::create_directories(outputFile.parent_path());
+    /// @brief Where an asset's outputs come from when its payload matches an earlier asset's.
+    /// The first to reach the compress stage owns it and writes its outputs; the others copy
+    /// them once written.
+    struct SharedOutput {
+        size_t Owner;
+        bool Written = false;
+        std::vector<size_t> Waiting;  // Reached the write stage before the owner was written
+    };
+
+    /// @brief An asset on its way through the build pipeline. Data holds the source file after
+    /// reading, the decoded data after decoding, the processed payload after transforming and
+    /// the payload as stored after compressing.
+    struct ProcessedAsset {
+        std::vector<u8> Data;
+        std::unordered_map<str, str> Metadata;
+        str Hash;  // Of the processor version and processed Data; also stored as "hash"
+        i32 Width            = 0;  // Of a decoded image
+        i32 Height           = 0;
+        size_t ProcessedSize = 0;  // Of the payload before compression
+        Codec StoredCodec    = Codec::None;
+        SharedOutput* Output = nullptr;
+    };
+
+    /// @brief Assets using zstd-dict share a dictionary per category: their <Dictionary>
+    /// setting, or their type.
+    static str GetDictionaryCategory(const Asset& asset) {
+        return asset.GetSetting("Dictionary", AssetTypeToString(asset.Type));
+    }
+
+    /// @brief Loads the dictionary for every category used by the assets at `indices`, training
+    /// the ones that don't exist yet from those assets. Existing dictionaries are kept so
+    /// unchanged assets compressed against them stay decodable; a clean rebuild retrains them.
+    [[nodiscard]] std::unordered_map<str, std::vector<u8>> PrepareDictionaries(
+      const std::vector<std::pair<const Asset*, fs::path>>& assets,
+      const std::vector<ProcessedAsset>& processed,
+      const std::vector<size_t>& indices) const {
+        std::unordered_map<str, std::vector<std::span<const u8>>> samples;
+        std::unordered_set<str> sampled;  // Duplicates would skew training
+        for (const auto i : indices) {
+            const auto& asset = *assets[i].first;
+            if (ResolveCodec(asset).Type != Codec::ZstdDict || processed[i].Data.empty()) {
+                continue;
+            }
+            const auto category = GetDictionaryCategory(asset);
+            if (!sampled.insert(category + '/' + processed[i].Hash).second) { continue; }
+            samples[category].emplace_back(processed[i].Data);
+        }
+
+        std::unordered_map<str, std::vector<u8>> dictionaries;
+        for (const auto& [category, categorySamples] : samples) {
+            const auto dictionaryFile = mContentDir / (category + ".xdict");
+            if (auto existing = IO::ReadBytes(dictionaryFile)) {
+                dictionaries.emplace(category, std::move(*existing));
+                continue;
+            }
+
+            BuildLog::Out() << "  | Training dictionary: " << category << " ("
+                            << categorySamples.size() << " samples)\n";
+            auto dictionary = Zstd::Train(categorySamples, DictionarySize);
+            if (!dictionary) {
+                BuildLog::Out() << "  |  [WARNING] Not enough data to train dictionary '"
+                                << category << "'; using zstd\n";
+                continue;
+            }
+            fs::create_directories(mContentDir);
+            std::ofstream out(dictionaryFile, std::ios::binary | std::ios::trunc);
+            out.write(RCAST<const char*>(dictionary->data()),
+                      CAST<std::streamsize>(dictionary->size()));
+            if (!out.good()) {
+                BuildLog::Out() << "  |  [ERROR] Writing dictionary failed: " << category
+                                << '\n';
+                continue;
+            }
+            dictionaries.emplace(category, std::move(*dictionary));
+        }
+        return dictionaries;
+    }
+
+    static CodecSettings ParseCodec(const str& value) {
+        const auto settings = Codecs::FromString(value);
+        if (!settings) { throw BuildError("Invalid codec: '%s'", value.c_str()); }
+        return *settings;
+    }
+
+    /// @brief An asset's own <Codec> wins over its type's entry in <Codecs>, which wins over the
+    /// manifest default.
+    [[nodiscard]] CodecSettings ResolveCodec(const Asset& asset) const {
+        const auto setting = asset.GetSetting("Codec");
+        if (!setting.empty()) { return ParseCodec(setting); }
+        if (const auto it = TypeCodecs.find(asset.Type); it != TypeCodecs.end()) {
+            return it->second;
+        }
+        return DefaultCodec;
+    }
+
+    /// @brief Absolute and without "." or ".." parts or a trailing separator, so paths from the
+    /// watcher and from the manifest compare component by component.
+    static fs::path Normalize(const fs::path& path) {
+        auto normal = fs::absolute(path).lexically_normal();
+        if (!normal.has_filename()) { normal = normal.parent_path(); }
+        return normal;
+    }
+
+    [[nodiscard]] fs::path GetOutputFile(const Asset& asset, const char* extension) const {
+        auto outputFile = mContentDir / asset.Source;
+        outputFile.replace_extension(extension);
+        return outputFile;
+    }
+
+    /// @brief Everything besides the source that decides an asset's output: its own settings,
+    /// the codec it resolves to and, for zstd-dict, the dictionary it would be compressed with.
+    [[nodiscard]] ContentHash HashSettings(const Asset& asset) const {
+        std::vector<std::pair<str, str>> settings(asset.Settings.begin(), asset.Settings.end());
+        std::ranges::sort(settings);
+        str text;
+        for (const auto& [key, value] : settings) {
+            text += key + '=' + value + '\n';
+        }
+        const auto codec = ResolveCodec(asset);
+        text += "codec=" + Codecs::ToString(codec.Type) + ':' + std::to_string(codec.Level) + '\n';
+        if (codec.Type == Codec::ZstdDict) {
+            // A missing dictionary reads as a change, so everything that used it rebuilds and
+            // the retrained one sees all of their samples
+            const auto dictionary = mContentDir / (GetDictionaryCategory(asset) + ".xdict");
+            const auto checksum   = mCache->GetFileChecksum(dictionary).value_or(ContentHash {});
+            text += "dictionary=" + std::to_string(DictionarySize) + ':' + checksum.ToString();
+        }
+        return ContentHash::Bytes({RCAST<const u8*>(text.data()), text.size()});
+    }
 
-        std::vector<u8> data;
-        std::unordered_map<str, str> metadata;
+    /// @brief Stores the hashes of `asset`'s freshly written outputs in `entry`. False if either
+    /// is missing.
+    bool RecordOutputs(const Asset& asset, BuildCache::AssetEntry& entry) const {
+        const auto pak      = mCache->GetFileChecksum(GetOutputFile(asset, ".xpkf"));
+        const auto metadata = mCache->GetFileChecksum(GetOutputFile(asset, ".xmdf"));
+        if (!pak || !metadata) { return false; }
+        entry.Pak      = *pak;
+        entry.Metadata = *metadata;
+        return true;
+    }
+
+    /// @brief Zstd-dict outputs only decode with the dictionary this project trained, so they
+    /// are never shared.
+    [[nodiscard]] bool IsShareable(const Asset& asset) const {
+        return ResolveCodec(asset).Type != Codec::ZstdDict;
+    }
+
+    /// @brief Copies the outputs of every asset the artifact store already has into place, drops
+    /// those assets from the build and returns their names.
+    std::vector<str> FetchArtifacts(BuildPool& pool,
+                        std::vector<std::pair<const Asset*, fs::path>>& assetsToBuild,
+                        std::vector<BuildCache::AssetEntry>& entries) const {
+        std::vector<u8> fetched(assetsToBuild.size(), 0);
+        std::vector<BuildPool::Task> tasks;
+        for (size_t i = 0; i < assetsToBuild.size(); ++i) {
+            const auto& asset = *assetsToBuild[i].first;
+            if (!IsShareable(asset)) { continue; }
+            tasks.push_back({0, 0, [&, i] {
+                                 const auto& target = *assetsToBuild[i].first;
+                                 fetched[i] = Artifacts->Fetch(entries[i].InputHash(),
+                                                               GetOutputFile(target, ".xpkf"),
+                                                               GetOutputFile(target, ".xmdf")) &&
+                                              RecordOutputs(target, entries[i]);
+                                 if (fetched[i]) {
+                                     BuildLog::Out() << "  | Fetched asset: " << target.Name
+                                                     << '\n';
+                                 }
+                             }});
+        }
+        pool.Run("fetched", std::move(tasks));
+
+        std::vector<str> names;
+        size_t kept = 0;
+        for (size_t i = 0; i < assetsToBuild.size(); ++i) {
+            if (fetched[i]) {
+                mCache->Update(assetsToBuild[i].first->Source, entries[i]);
+                names.push_back(assetsToBuild[i].first->Name);
+                continue;
+            }
+            assetsToBuild[kept] = assetsToBuild[i];
+            entries[kept]       = entries[i];
+            ++kept;
+        }
+        assetsToBuild.resize(kept);
+        entries.resize(kept);
+        return names;
+    }
+
+    /// @brief Rough peak memory of processing `asset`. Decoded images dominate, so textures and
+    /// atlases are estimated from their dimensions (RGBA8, mip chain and converted copy);
+    /// everything else from its size on disk.
+    static u64 EstimateProcessingBytes(const Asset& asset, const fs::path& sourceFile) {
+        const auto imageBytes = [](const fs::path& filename) -> u64 {
+            i32 width = 0, height = 0, channels = 0;
+            if (!stbi_info(filename.string().c_str(), &width, &height, &channels)) { return 0; }
+            return CAST<u64>(width) * CAST<u64>(height) * 4 * 3;
+        };
+        if (asset.Type == AssetType::Texture) {
+            if (const auto bytes = imageBytes(sourceFile)) { return bytes; }
+        } else if (asset.Type == AssetType::Atlas) {
+            u64 total = 0;
+            for (const auto& member : AtlasBuilder::ListMembers(sourceFile)) {
+                total += imageBytes(member);
+            }
+            return total;
+        }
+        std::error_code error;
+        const auto size = fs::file_size(sourceFile, error);
+        return error ? 0 : CAST<u64>(size) * 4;
+    }
+
+    /// @brief Runs the assets that are out of date through the build pipeline:
+    ///  - read:      loads the source file (atlas members are loaded while packing)
+    ///  - decode:    images to RGBA8 pixels, audio to samples and tilemaps to tile indices
+    ///  - transform: mips and pixel formats, atlas packing and font distance fields
+    ///  - compress:  encodes the payload, once for all assets whose payloads match
+    ///  - write:     streams the pak and metadata files out
+    /// Zstd-dict assets wait after transform until every asset has been transformed, since
+    /// their dictionaries are trained on all of them. Returns which assets were written.
+    std::vector<u8> BuildAssets(const std::vector<std::pair<const Asset*, fs::path>>& assets,
+                                std::vector<BuildCache::AssetEntry>& entries) const {
+        using Result = BuildPipeline::Result;
+        std::vector<ProcessedAsset> processed(assets.size());
+        std::vector<u8> written(assets.size(), 0);
+        std::unordered_map<str, std::vector<u8>> dictionaries;
+        std::mutex sharedMutex;
+        std::unordered_map<str, SharedOutput> shared;  // Payload hash and codec -> output
+
+        const auto read = [&](size_t i) -> Result {
+            const auto& [asset, sourceFile] = assets[i];
+            BuildLog::Out() << "  | Building asset: " << asset->Name << '\n';
+            if (asset->Type == AssetType::Atlas) { return Result::Next; }
+            auto bytes = IO::ReadBytes(sourceFile);
+            if (!bytes) {
+                throw BuildError("Failed to open file: %s", sourceFile.string().c_str());
+            }
+            processed[i].Data = std::move(*bytes);
+            return Result::Next;
+        };
+        const auto decode = [&](size_t i) -> Result {
+            const auto& asset = *assets[i].first;
+            DecodeAsset(asset, processed[i]);
+            if (processed[i].Data.empty() && asset.Type != AssetType::Atlas) {
+                BuildLog::Out() << "  |  [ERROR] Not building asset: " << asset.Name << '\n';
+                return Result::Drop;
+            }
+            return Result::Next;
+        };
+        const auto transform = [&](size_t i) -> Result {
+            const auto& [asset, sourceFile] = assets[i];
+            TransformAsset(*asset, sourceFile, processed[i]);
+            if (processed[i].Data.empty()) {
+                BuildLog::Out() << "  |  [ERROR] Not building asset: " << asset->Name << '\n';
+                return Result::Drop;
+            }
+            return ResolveCodec(*asset).Type == Codec::ZstdDict ? Result::Defer : Result::Next;
+        };
+        const auto train = [&](std::vector<size_t> deferred) {
+            std::ranges::sort(deferred);  // Same samples in the same order trains the same bytes
+            dictionaries = PrepareDictionaries(assets, processed, deferred);
+        };
+        const auto compress = [&](size_t i) -> Result {
+            const auto& asset = *assets[i].first;
+            auto& item        = processed[i];
+            auto codec        = ResolveCodec(asset);
+            str dictionary    = codec.Type == Codec::ZstdDict ? GetDictionaryCategory(asset) : "";
+            if (!dictionary.empty() && !dictionaries.contains(dictionary)) {
+                codec.Type = Codec::Zstd;  // Too little data to train on
+                dictionary.clear();
+            }
+            item.ProcessedSize = item.Data.size();
+            {
+                std::lock_guard lock(sharedMutex);
+                const auto key = item.Hash + '/' + Codecs::ToString(codec.Type) + ':' +
+                                 std::to_string(codec.Level) + '/' + dictionary;
+                item.Output = &shared.try_emplace(key, SharedOutput {i}).first->second;
+            }
+            if (item.Output->Owner != i) {
+                BuildLog::Out() << "  |  -  " << asset.Name << " shares the output of "
+                                << assets[item.Output->Owner].first->Name << '\n';
+                std::vector<u8>().swap(item.Data);
+                return Result::Next;
+            }
+            if (codec.Type != Codec::None) {
+                BuildLog::Out() << "  | Compressing asset: " << asset.Name << " ("
+                                << Codecs::ToString(codec.Type) << ")\n";
+            }
+            std::span<const u8> dictionaryData;
+            if (!dictionary.empty()) { dictionaryData = dictionaries.at(dictionary); }
+            item.StoredCodec = CompressPayload(item.Data, codec, dictionaryData);
+            return Result::Next;
+        };
+
+        const auto finish = [&](size_t i) {
+            const auto& asset = *assets[i].first;
+            written[i]        = RecordOutputs(asset, entries[i]);
+            if (written[i] && Artifacts && IsShareable(asset)) {
+                Artifacts->Publish(entries[i].InputHash(),
+                                   GetOutputFile(asset, ".xpkf"),
+                                   GetOutputFile(asset, ".xmdf"));
+            }
+        };
+        const auto copy = [&](size_t from, size_t to) {
+            const auto& asset  = *assets[to].first;
+            const auto pakFile = GetOutputFile(asset, ".xpkf");
+            fs::create_directories(pakFile.parent_path());
+            std::error_code error;
+            fs::copy_file(GetOutputFile(*assets[from].first, ".xpkf"),
+                          pakFile,
+                          fs::copy_options::overwrite_existing,
+                          error);
+            if (error || !MetadataFile::Write(GetOutputFile(asset, ".xmdf"),
+                                              processed[to].Metadata)) {
+                BuildLog::Out() << "  |  [ERROR] Writing asset failed: " << asset.Name << '\n';
+                return;
+            }
+            finish(to);
+        };
+        const auto write = [&](size_t i) -> Result {
+            auto& item   = processed[i];
+            auto& output = *item.Output;
+            if (output.Owner != i) {
+                {
+                    std::lock_guard lock(sharedMutex);
+                    if (!output.Written) {
+                        output.Waiting.push_back(i);
+                        return Result::Next;
+                    }
+                }
+                copy(output.Owner, i);
+                return Result::Next;
+            }
+
+            const auto& asset = *assets[i].first;
+            WriteAsset(GetOutputFile(asset, ".xpkf"),
+                       item.Data,
+                       item.StoredCodec,
+                       item.ProcessedSize,
+                       item.Metadata);
+            std::vector<u8>().swap(item.Data);
+            finish(i);
+            std::vector<size_t> waiting;
+            {
+                std::lock_guard lock(sharedMutex);
+                output.Written = true;
+                waiting.swap(output.Waiting);
+            }
+            for (const auto index : waiting) {
+                copy(i, index);
+            }
+            return Result::Next;
+        };
+
+        // A bad source or setting costs only its own asset
+        const auto guard = [&](const auto& stage) {
+            return [&](size_t i) -> Result {
+                try {
+                    return stage(i);
+                } catch (const BuildError& error) {
+                    BuildLog::Out() << "  |  [ERROR] Not building asset: " << assets[i].first->Name
+                                    << " (" << error.what() << ")\n";
+                    return Result::Drop;
+                }
+            };
+        };
+
+        const u32 cores    = Jobs ? Jobs : std::max(1u, std::thread::hardware_concurrency());
+        const auto workers = [&](const char* stage, u32 fallback) {
+            const auto it = StageWorkers.find(stage);
+            return it != StageWorkers.end() && it->second > 0 ? it->second : fallback;
+        };
+        BuildPipeline pipeline({{"read", workers("read", kIoWorkers), guard(read)},
+                                {"decode", workers("decode", cores), guard(decode)},
+                                {"transform", workers("transform", cores), guard(transform), train},
+                                {"compress", workers("compress", cores), compress},
+                                {"write", workers("write", kIoWorkers), write}},
+                               MemoryBudget,
+                               QueueCapacity);
+
+        // Largest first, so big assets start early and small ones fill in around them
+        std::vector<BuildPipeline::Item> items;
+        for (size_t i = 0; i < assets.size(); ++i) {
+            items.push_back({i, EstimateProcessingBytes(*assets[i].first, assets[i].second)});
+        }
+        std::ranges::sort(items, [](const auto& a, const auto& b) { return a.Bytes > b.Bytes; });
+        pipeline.Run("built", items);
+        return written;
+    }
+
+    static void DecodeAsset(const Asset& asset, ProcessedAsset& item) {
+        auto& data = item.Data;
         switch (asset.Type) {
             case AssetType::Texture:
-                data = Processors::ProcessTexture(sourceFile, metadata);
+                data = Processors::DecodeTexture(data, item.Width, item.Height);
                 break;
             case AssetType::Audio:
-                data = Processors::ProcessAudio(sourceFile, metadata);
+                data = Processors::ProcessAudio(data, item.Metadata);
                 break;
-            case AssetType::Data:
-                data = Processors::ProcessData(sourceFile, metadata);
+            case AssetType::Tilemap:
+                data = Processors::ProcessTilemap(data, item.Metadata);
+                break;
+            default:
                 break;
         }
+    }
 
+    static void TransformAsset(const Asset& asset,
+                               const fs::path& sourceFile,
+                               ProcessedAsset& item) {
+        auto& data     = item.Data;
+        auto& metadata = item.Metadata;
+        switch (asset.Type) {
+            case AssetType::Texture:
+                data = Processors::ProcessTexture(std::move(data),
+                                                  item.Width,
+                                                  item.Height,
+                                                  asset,
+                                                  metadata);
+                break;
+            case AssetType::Font:
+                data = Processors::ProcessFont(data, asset, metadata);
+                break;
+            case AssetType::Atlas:
+                data = Processors::ProcessAtlas(sourceFile, asset, metadata);
+                break;
+            case AssetType::Data:
+                data = Processors::ProcessData(std::move(data), metadata);
+                break;
+            default:
+                break;
+        }
+        // Lets the runtime tell which payloads it can drop once they reach the GPU
+        metadata.insert_or_assign("type", AssetTypeToString(asset.Type));
         if (data.empty()) { return; }
 
-        const auto originalSize = data.size();
-        if (compress) {
-            std::cout << "  |  -  Compressing...\n";
-            const auto result = LZMA::Compress(data);
-            if (result.has_value()) {
-                const auto& compressedData = result.value();
-                data.assign(compressedData.begin(), compressedData.end());
-                data.shrink_to_fit();  // probably not necessary
-            }
-        }
+        // Lets the runtime share one payload between assets with identical content
+        SHA256 sha256;
+        sha256.add(&Processors::kVersion, sizeof(Processors::kVersion));
+        sha256.add(data.data(), data.size());
+        item.Hash = sha256.getHash();
+        metadata.insert_or_assign("hash", item.Hash);
+    }
+
+    /// @brief Compresses `data` in place and returns the codec it is stored with. Payloads that
+    /// don't shrink are cheaper to store as-is.
+    static Codec CompressPayload(std::vector<u8>& data,
+                                 const CodecSettings& codec,
+                                 std::span<const u8> dictionary) {
+        if (codec.Type == Codec::None) { return Codec::None; }
+        // One thread: compress jobs already run one per worker, within the memory budget
+        auto result = Codecs::Compress(data, codec, dictionary, 1);
+        if (!result.has_value() || result->size() >= data.size()) { return Codec::None; }
+        data = std::move(*result);
+        return codec.Type;
+    }
+
+    static void WriteAsset(const fs::path& pakFile,
+                           std::span<const u8> payload,
+                           const Codec codec,
+                           const size_t originalSize,
+                           const std::unordered_map<str, str>& metadata) {
+        if (fs::exists(pakFile)) { fs::remove(pakFile); }
+        fs::create_directories(pakFile.parent_path());
 
-        if (!PakFile::Write(data, outputFile, compress, originalSize)) {
-            std::cout << "  |  [ERROR] Writing to Pak file failed.\n";
+        if (!PakFile::Write(payload, pakFile, codec, originalSize)) {
+            BuildLog::Out() << "  |  [ERROR] Writing to Pak file failed.\n";
         }
 
-        const auto metadataFile = outputFile.replace_extension(".xmdf");
+        auto metadataFile = pakFile;
+        metadataFile.replace_extension(".xmdf");
         if (fs::exists(metadataFile)) { fs::remove(metadataFile); }
         if (!MetadataFile::Write(metadataFile, metadata)) {
-            std::cout << "  |  [ERROR] Writing to metadata file failed.\n";
+            BuildLog::Out() << "  |  [ERROR] Writing to metadata file failed.\n";
         }
     }
 };
\ No newline at end of file
@@ -0,0 +1,148 @@
+// Author: Jake Rieger
+// Created: 12/5/2024.
+//
+
+#pragma once
+
+#include <Types.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XPAK_MIPS_SSE 1
+#endif
+
+/// @brief Builds full mip chains for RGBA8 sRGB images.
+///
+/// Filtering happens in linear light with premultiplied alpha: averaging sRGB values directly
+/// darkens every level, and averaging straight alpha lets fully transparent texels bleed their
+/// (usually black) color into edges. Each level is reduced from the previous level's float data,
+/// so quantization error doesn't compound down the chain.
+class MipGenerator {
+public:
+    static u32 GetLevelCount(u32 width, u32 height) {
+        u32 levels = 1;
+        while (width > 1 || height > 1) {
+            width  = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+            ++levels;
+        }
+        return levels;
+    }
+
+    /// @brief Appends every mip level below `image`'s base level, tightly packed and in order.
+    /// `image` must hold exactly width * height RGBA8 texels. Returns the total level count.
+    static u32 Generate(std::vector<u8>& image, u32 width, u32 height) {
+        const auto& tables = GetTables();
+        const u32 levels   = GetLevelCount(width, height);
+
+        size_t chainSize = 0;
+        for (u32 w = width, h = height, level = 0; level < levels; ++level) {
+            chainSize += CAST<size_t>(w) * h * 4;
+            w = std::max(1u, w / 2);
+            h = std::max(1u, h / 2);
+        }
+        image.reserve(chainSize);
+
+        // Linear, premultiplied RGBA; one f32x4 per texel
+        std::vector<f32> source(CAST<size_t>(width) * height * 4);
+        for (size_t i = 0; i < source.size(); i += 4) {
+            const f32 alpha = CAST<f32>(image[i + 3]) * (1.f / 255.f);
+            source[i + 0]   = tables.ToLinear[image[i + 0]] * alpha;
+            source[i + 1]   = tables.ToLinear[image[i + 1]] * alpha;
+            source[i + 2]   = tables.ToLinear[image[i + 2]] * alpha;
+            source[i + 3]   = alpha;
+        }
+
+        std::vector<f32> target;
+        for (u32 level = 1; level < levels; ++level) {
+            const u32 targetWidth  = std::max(1u, width / 2);
+            const u32 targetHeight = std::max(1u, height / 2);
+            target.resize(CAST<size_t>(targetWidth) * targetHeight * 4);
+            Downsample(source.data(), width, height, target.data(), targetWidth, targetHeight);
+
+            const size_t offset = image.size();
+            image.resize(offset + target.size());
+            Encode(target.data(), image.data() + offset, target.size() / 4, tables);
+
+            source.swap(target);
+            width  = targetWidth;
+            height = targetHeight;
+        }
+
+        return levels;
+    }
+
+private:
+    static constexpr u32 kEncodeSteps = 4096;
+
+    struct Tables {
+        std::array<f32, 256> ToLinear;
+        std::array<u8, kEncodeSteps + 1> ToSrgb;  // Indexed by linear value * kEncodeSteps
+    };
+
+    static const Tables& GetTables() {
+        static const Tables tables = [] {
+            Tables result {};
+            for (u32 i = 0; i < 256; ++i) {
+                const f32 c = CAST<f32>(i) / 255.f;
+                result.ToLinear[i] =
+                  c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (u32 i = 0; i <= kEncodeSteps; ++i) {
+                const f32 l = CAST<f32>(i) / CAST<f32>(kEncodeSteps);
+                const f32 c =
+                  l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+                result.ToSrgb[i] = CAST<u8>(std::lround(std::clamp(c, 0.f, 1.f) * 255.f));
+            }
+            return result;
+        }();
+        return tables;
+    }
+
+    /// @brief 2x2 box filter. Odd source edges clamp, so the last row/column folds into its
+    /// neighbour rather than reading out of bounds.
+    static void Downsample(const f32* source,
+                           u32 sourceWidth,
+                           u32 sourceHeight,
+                           f32* target,
+                           u32 targetWidth,
+                           u32 targetHeight) {
+        for (u32 y = 0; y < targetHeight; ++y) {
+            const u32 y0  = std::min(y * 2, sourceHeight - 1);
+            const u32 y1  = std::min(y * 2 + 1, sourceHeight - 1);
+            const f32* r0 = source + CAST<size_t>(y0) * sourceWidth * 4;
+            const f32* r1 = source + CAST<size_t>(y1) * sourceWidth * 4;
+            f32* out      = target + CAST<size_t>(y) * targetWidth * 4;
+            for (u32 x = 0; x < targetWidth; ++x, out += 4) {
+                const u32 x0 = std::min(x * 2, sourceWidth - 1) * 4;
+                const u32 x1 = std::min(x * 2 + 1, sourceWidth - 1) * 4;
+#ifdef XPAK_MIPS_SSE
+                const __m128 top    = _mm_add_ps(_mm_loadu_ps(r0 + x0), _mm_loadu_ps(r0 + x1));
+                const __m128 bottom = _mm_add_ps(_mm_loadu_ps(r1 + x0), _mm_loadu_ps(r1 + x1));
+                _mm_storeu_ps(out, _mm_mul_ps(_mm_add_ps(top, bottom), _mm_set1_ps(0.25f)));
+#else
+                for (u32 c = 0; c < 4; ++c) {
+                    out[c] = (r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c]) * 0.25f;
+                }
+#endif
+            }
+        }
+    }
+
+    static void Encode(const f32* texels, u8* out, size_t count, const Tables& tables) {
+        constexpr auto steps = CAST<f32>(kEncodeSteps);
+        for (size_t i = 0; i < count; ++i, texels += 4, out += 4) {
+            const f32 alpha = texels[3];
+            const f32 scale = alpha > 0.f ? steps / alpha : 0.f;
+            for (u32 c = 0; c < 3; ++c) {
+                const f32 linear = std::min(texels[c] * scale, steps);
+                out[c]           = tables.ToSrgb[CAST<u32>(linear + 0.5f)];
+            }
+            out[3] = CAST<u8>(std::lround(std::clamp(alpha, 0.f, 1.f) * 255.f));
+        }
+    }
+};
@@ -3,7 +3,13 @@
 //
 
 #pragma once
+#include <Compression.hpp>
+#include <Types.hpp>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
 
 // Pak File Structure
 //
@@ -14,30 +20,35 @@
 // +---------------+---------+--------+
 // | Padding       | 3       | 4      |
 // +---------------+---------+--------+
-// | Compress      | 1       | 7      |
+// | Codec         | 1       | 7      |
 // +---------------+---------+--------+
 // | Original Size | 8       | 8      |
 // +---------------+---------+--------+
 // | Data          | Dynamic | 16     |
 // +---------------+---------+--------+
+//
+// Codec is a `Codec` value (Compression.hpp); paks from before codecs were selectable store 0
+// or 1 there, which are None and LZMA.
 class PakFile {
 public:
-    static bool
-    Write(std::vector<u8>& data, const std::filesystem::path& outPath, const bool compress, const size_t originalSize) {
-        constexpr char magic[4]   = {'X', 'P', 'A', 'K'};
-        constexpr char padding[3] = {0x0, 0x0, 0x0};
+    /// @brief Writes the header, then streams `data` straight to the file.
+    static bool Write(std::span<const u8> data,
+                      const std::filesystem::path& outPath,
+                      const Codec codec,
+                      const size_t originalSize) {
+        constexpr char magic[4] = {'X', 'P', 'A', 'K'};
 
-        std::vector<u8> pak(data.size() + 16);
-        memcpy(pak.data(), magic, 4);
-        memcpy(pak.data() + 4, padding, 3);
-        memcpy(pak.data() + 7, (u8*)&compress, 1);
-        memcpy(pak.data() + 8, &originalSize, 8);
-        std::ranges::copy(data, pak.data() + 16);
+        u8 header[16] = {};
+        memcpy(header, magic, 4);
+        header[7]      = CAST<u8>(codec);
+        const u64 size = originalSize;
+        memcpy(header + 8, &size, 8);
 
         std::ofstream outFile(outPath, std::ios::binary);
-        outFile.write(reinterpret_cast<char*>(pak.data()), (std::streamsize)pak.size());
+        outFile.write(RCAST<const char*>(header), sizeof(header));
+        outFile.write(RCAST<const char*>(data.data()), CAST<std::streamsize>(data.size()));
         outFile.close();
 
-        return true;
+        return outFile.good();
     }
 };
\ No newline at end of file
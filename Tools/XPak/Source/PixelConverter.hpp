@@ -0,0 +1,227 @@
+// Author: Jake Rieger
+// Created: 12/6/2024.
+//
+
+#pragma once
+
+#include <Panic.hpp>
+#include <TextureFormat.hpp>
+#include <Types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XPAK_PIXELS_SSE 1
+#endif
+
+/// @brief Repacks RGBA8 mip chains into the smaller uncompressed formats in TextureFormat.hpp.
+class PixelConverter {
+public:
+    /// @brief Picks the smallest format that stores `image` without loss: R8 for opaque gray,
+    /// RG8 for gray with alpha, then RGB565 / RGBA4444 for content (typically pixel art) whose
+    /// colors already sit on those grids. Anything else stays RGBA8; the lossy 16-bit formats
+    /// are only used when a manifest asks for them.
+    static TextureFormat ChooseFormat(const std::vector<u8>& image) {
+        bool gray = true, opaque = true, fits565 = true, fits4444 = true;
+        for (size_t i = 0; i < image.size(); i += 4) {
+            const u8 r = image[i], g = image[i + 1], b = image[i + 2], a = image[i + 3];
+            gray &= r == g && g == b;
+            opaque &= a == 255;
+            fits565 &= IsExact(r, 31) && IsExact(g, 63) && IsExact(b, 31);
+            fits4444 &= IsExact(r, 15) && IsExact(g, 15) && IsExact(b, 15) && IsExact(a, 15);
+            if (!gray && !fits565 && !fits4444) { break; }
+        }
+        if (gray) { return opaque ? TextureFormat::R8 : TextureFormat::RG8; }
+        if (fits565 && opaque) { return TextureFormat::RGB565; }
+        if (fits4444) { return TextureFormat::RGBA4444; }
+        return TextureFormat::RGBA8;
+    }
+
+    /// @brief Converts `levels` RGBA8 levels stored back to back. `dither` applies a 4x4 ordered
+    /// dither when quantizing to RGB565/RGBA4444, trading banding in gradients for a fixed,
+    /// compression-friendly pattern; it has no effect on the lossless formats.
+    static std::vector<u8> Convert(const std::vector<u8>& image,
+                                   u32 width,
+                                   u32 height,
+                                   u32 levels,
+                                   TextureFormat format,
+                                   bool dither) {
+        if (format == TextureFormat::RGBA8) { return image; }
+        if (TextureFormats::IsBlockCompressed(format)) {
+            Panic("PixelConverter does not handle block-compressed formats");
+        }
+        const auto sourceSize =
+          TextureFormats::GetChainSize(TextureFormat::RGBA8, width, height, levels);
+        if (image.size() < sourceSize) { Panic("Texture data is smaller than its mip chain"); }
+
+        std::vector<u8> result(TextureFormats::GetChainSize(format, width, height, levels));
+        const u32 unitSize = TextureFormats::GetUnitSize(format);
+        const u8* source   = image.data();
+        u8* target         = result.data();
+        for (u32 level = 0; level < std::max(levels, 1u); ++level) {
+            for (u32 y = 0; y < height; ++y) {
+                const u8* in = source + CAST<size_t>(y) * width * 4;
+                u8* out      = target + CAST<size_t>(y) * width * unitSize;
+                switch (format) {
+                    case TextureFormat::R8:
+                        ConvertR8(in, out, width);
+                        break;
+                    case TextureFormat::RG8:
+                        ConvertRG8(in, out, width);
+                        break;
+                    case TextureFormat::RGB565:
+                        ConvertPacked(in, out, width, y, kLayout565, dither);
+                        break;
+                    case TextureFormat::RGBA4444:
+                    default:
+                        ConvertPacked(in, out, width, y, kLayout4444, dither);
+                        break;
+                }
+            }
+            source += TextureFormats::GetLevelSize(TextureFormat::RGBA8, width, height);
+            target += TextureFormats::GetLevelSize(format, width, height);
+            width  = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+        return result;
+    }
+
+private:
+    /// @brief Per-channel maximum quantized value and bit position within the packed u16.
+    struct Layout {
+        u16 Max[4];
+        u16 Scale[4];  // 1 << shift
+    };
+
+    static constexpr Layout kLayout565  = {{31, 63, 31, 0}, {1 << 11, 1 << 5, 1, 0}};
+    static constexpr Layout kLayout4444 = {{15, 15, 15, 15}, {1 << 12, 1 << 8, 1 << 4, 1}};
+
+    // 4x4 Bayer matrix
+    static constexpr u16 kBayer[4][4] = {
+      {0, 8, 2, 10},
+      {12, 4, 14, 6},
+      {3, 11, 1, 9},
+      {15, 7, 13, 5},
+    };
+
+    /// @brief Whether `value` survives a round trip through a `max`-step unorm channel.
+    static bool IsExact(u8 value, u32 max) {
+        const u32 q = (value * max + 128) / 255;
+        return CAST<u32>(std::lround(CAST<f32>(q) * 255.f / CAST<f32>(max))) == value;
+    }
+
+    /// @brief Rounding bias added before dividing by 255: 128 rounds to nearest, and the Bayer
+    /// thresholds spread that same mean over a 4x4 tile.
+    static u16 GetBias(u32 x, u32 y, bool dither) {
+        return dither ? CAST<u16>(kBayer[y & 3][x & 3] * 16 + 8) : 128;
+    }
+
+    static void ConvertR8(const u8* in, u8* out, u32 width) {
+        u32 x = 0;
+#ifdef XPAK_PIXELS_SSE
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        for (; x + 4 <= width; x += 4) {
+            const __m128i texels = _mm_loadu_si128(RCAST<const __m128i*>(in + x * 4));
+            __m128i gray         = _mm_and_si128(texels, mask);
+            gray                 = _mm_packs_epi32(gray, gray);
+            gray                 = _mm_packus_epi16(gray, gray);
+            const i32 packed     = _mm_cvtsi128_si32(gray);
+            memcpy(out + x, &packed, 4);
+        }
+#endif
+        for (; x < width; ++x) {
+            out[x] = in[x * 4];
+        }
+    }
+
+    static void ConvertRG8(const u8* in, u8* out, u32 width) {
+        u32 x = 0;
+#ifdef XPAK_PIXELS_SSE
+        for (; x + 4 <= width; x += 4) {
+            const __m128i texels = _mm_loadu_si128(RCAST<const __m128i*>(in + x * 4));
+            // Gray in bits 0-7, alpha moved from 24-31 down to 8-15
+            __m128i pairs = _mm_or_si128(_mm_and_si128(texels, _mm_set1_epi32(0xFF)),
+                                         _mm_and_si128(_mm_srli_epi32(texels, 16),
+                                                       _mm_set1_epi32(0xFF00)));
+            // Sign-extend so the saturating pack keeps the bit pattern
+            pairs = _mm_srai_epi32(_mm_slli_epi32(pairs, 16), 16);
+            pairs = _mm_packs_epi32(pairs, pairs);
+            _mm_storel_epi64(RCAST<__m128i*>(out + x * 2), pairs);
+        }
+#endif
+        for (; x < width; ++x) {
+            out[x * 2 + 0] = in[x * 4 + 0];
+            out[x * 2 + 1] = in[x * 4 + 3];
+        }
+    }
+
+    /// @brief Quantizes one row to a packed 16-bit format: q = (c * max + bias) / 255 per
+    /// channel, shifted into place.
+    static void ConvertPacked(const u8* in,
+                              u8* out,
+                              u32 width,
+                              u32 y,
+                              const Layout& layout,
+                              bool dither) {
+        u32 x = 0;
+#ifdef XPAK_PIXELS_SSE
+        // Two texels per register in 16-bit lanes; x is a multiple of 4 so the biases repeat
+        const auto perTexel = [](const u16* v) {
+            return _mm_setr_epi16(CAST<i16>(v[0]),
+                                  CAST<i16>(v[1]),
+                                  CAST<i16>(v[2]),
+                                  CAST<i16>(v[3]),
+                                  CAST<i16>(v[0]),
+                                  CAST<i16>(v[1]),
+                                  CAST<i16>(v[2]),
+                                  CAST<i16>(v[3]));
+        };
+        const __m128i max   = perTexel(layout.Max);
+        const __m128i scale = perTexel(layout.Scale);
+        const auto bias     = [&](u32 first) {
+            const i16 b0 = CAST<i16>(GetBias(first, y, dither));
+            const i16 b1 = CAST<i16>(GetBias(first + 1, y, dither));
+            return _mm_setr_epi16(b0, b0, b0, b0, b1, b1, b1, b1);
+        };
+        const __m128i biasLow  = bias(0);
+        const __m128i biasHigh = bias(2);
+        const __m128i zero     = _mm_setzero_si128();
+        const __m128i one      = _mm_set1_epi16(1);
+
+        const auto quantize = [&](__m128i texels, __m128i texelBias) {
+            __m128i v = _mm_add_epi16(_mm_mullo_epi16(texels, max), texelBias);
+            // Exact v / 255 for v < 65535: (v + 1 + ((v + 1) >> 8)) >> 8
+            v         = _mm_add_epi16(v, one);
+            v         = _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+            v         = _mm_mullo_epi16(v, scale);
+            // Channels occupy disjoint bits, so OR-ing the four lanes of each texel packs it
+            v         = _mm_or_si128(v, _mm_srli_epi64(v, 32));
+            v         = _mm_or_si128(v, _mm_srli_epi64(v, 16));
+            return v;
+        };
+
+        for (; x + 4 <= width; x += 4) {
+            const __m128i texels = _mm_loadu_si128(RCAST<const __m128i*>(in + x * 4));
+            const __m128i low    = quantize(_mm_unpacklo_epi8(texels, zero), biasLow);
+            const __m128i high   = quantize(_mm_unpackhi_epi8(texels, zero), biasHigh);
+            const u16 packed[4]  = {CAST<u16>(_mm_extract_epi16(low, 0)),
+                                    CAST<u16>(_mm_extract_epi16(low, 4)),
+                                    CAST<u16>(_mm_extract_epi16(high, 0)),
+                                    CAST<u16>(_mm_extract_epi16(high, 4))};
+            memcpy(out + x * 2, packed, sizeof(packed));
+        }
+#endif
+        for (; x < width; ++x) {
+            const u32 bias = GetBias(x, y, dither);
+            u32 packed     = 0;
+            for (u32 c = 0; c < 4; ++c) {
+                packed += (in[x * 4 + c] * layout.Max[c] + bias) / 255 * layout.Scale[c];
+            }
+            const auto value = CAST<u16>(packed);
+            memcpy(out + x * 2, &value, 2);
+        }
+    }
+};
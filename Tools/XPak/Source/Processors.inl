@@ -4,41 +4,101 @@
 
 #pragma once
 
+#include "Asset.hpp"
+#include "AtlasBuilder.hpp"
+#include "BuildError.hpp"
+#include "BuildPool.hpp"
+#include "FontAtlas.hpp"
+#include "MipGenerator.hpp"
+#include "PixelConverter.hpp"
+#include "TextureEncoder.hpp"
+
 #include <stb_image.h>
 #include <AudioFile.h>
+#include <pugixml.hpp>
+#include <span>
+#include <sstream>
 #include <vector>
 #include <filesystem>
 
 class Processors {
 public:
+    /// @brief Bump whenever a processor's output changes for the same source and settings. It
+    /// is part of every asset's content hash.
+    static constexpr u32 kVersion = 1;
+
     // TODO: Write the actual implementations for these
 
-    static std::vector<u8> ProcessTexture(const std::filesystem::path& filename,
-                                          std::unordered_map<str, str>& metadata) {
-        int width, height, channels;
+    /// @brief Decodes an image file to RGBA8 pixels, bottom-up for OpenGL.
+    static std::vector<u8> DecodeTexture(std::span<const u8> source, i32& width, i32& height) {
+        i32 channels;
         stbi_set_flip_vertically_on_load(true);  // needed for OpenGL
-        const stbi_uc* data =
-          stbi_load(filename.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
-        if (!data) { Panic("Failed to load image"); }
-        std::vector<u8> result(width * height * channels);
-        memcpy(result.data(), data, width * height * channels);
+        stbi_uc* data = stbi_load_from_memory(source.data(),
+                                              CAST<i32>(source.size()),
+                                              &width,
+                                              &height,
+                                              &channels,
+                                              STBI_rgb_alpha);
+        if (!data) { throw BuildError("Failed to load image"); }
+        // stb expands to the requested 4 channels regardless of what the file contains
+        std::vector<u8> result(data, data + CAST<size_t>(width) * height * 4);
+        stbi_image_free(data);
+        return result;
+    }
+
+    /// @brief Builds the full mip chain of decoded pixels offline with a gamma-correct filter and
+    /// converts them to the stored format. Settings:
+    ///  - <Mipmaps>false</Mipmaps> stores only the base level, for UI and pixel art that is never
+    ///    minified.
+    ///  - <Format> is Auto (default), RGBA8, R8, RG8, RGB565, RGBA4444, BC1, BC3 or BC7. Auto
+    ///    picks the smallest lossless format (see PixelConverter::ChooseFormat).
+    ///  - <Dither>true</Dither> ordered-dithers RGB565/RGBA4444 to hide banding.
+    ///  - <Quality> (fast, normal, high) trades build time for block compression quality.
+    static std::vector<u8> ProcessTexture(std::vector<u8> result,
+                                          i32 width,
+                                          i32 height,
+                                          const Asset& asset,
+                                          std::unordered_map<str, str>& metadata) {
+        u32 mips = 1;
+        if (asset.GetSetting("Mipmaps", "true") == "true") {
+            mips = MipGenerator::Generate(result, width, height);
+        }
+
+        const auto formatName = asset.GetSetting("Format", "Auto");
+        const auto format     = formatName == "Auto" ? PixelConverter::ChooseFormat(result)
+                                                     : TextureFormats::FromString(formatName);
+        const auto quality = TextureEncoder::ParseQuality(asset.GetSetting("Quality", "normal"));
+        const bool dither  = asset.GetSetting("Dither", "false") == "true";
+        if (!format) { throw BuildError("Unknown texture format: %s", formatName.c_str()); }
+        if (!quality) {
+            throw BuildError("Unknown texture quality: %s", asset.GetSetting("Quality").c_str());
+        }
+        if (TextureFormats::IsBlockCompressed(*format)) {
+            // One thread: the build already runs a transform per worker, sized by -j
+            result = TextureEncoder::Encode(result, width, height, mips, *format, *quality, 1);
+        } else if (*format != TextureFormat::RGBA8) {
+            result = PixelConverter::Convert(result, width, height, mips, *format, dither);
+        }
 
         metadata.insert_or_assign("width", std::to_string(width));
         metadata.insert_or_assign("height", std::to_string(height));
-        metadata.insert_or_assign("channels", std::to_string(channels));
+        metadata.insert_or_assign("channels",
+                                  std::to_string(TextureFormats::GetChannelCount(*format)));
+        metadata.insert_or_assign("mips", std::to_string(mips));
+        metadata.insert_or_assign("format", TextureFormats::ToString(*format));
 
         return result;
     }
 
-    static std::vector<u8> ProcessAudio(const std::filesystem::path& filename,
+    static std::vector<u8> ProcessAudio(std::vector<u8>& source,
                                         std::unordered_map<str, str>& metadata) {
         AudioFile<f32> audio;
-        if (!audio.load(filename.string())) {
-            std::cerr << "Failed to load audio file: " << filename.string() << std::endl;
+        if (!audio.loadFromMemory(source)) {
+            BuildLog::Out() << "  |  [ERROR] Failed to load audio file\n";
             return {};
         }
         if (audio.getNumChannels() != 2) {
-            std::cerr << "Audio file does not have two channels (stereo)" << std::endl;
+            BuildLog::Out() << "  |  [ERROR] Audio file does not have two channels (stereo)\n";
             return {};
         }
 
@@ -60,24 +120,88 @@ public:
         return result;
     }
 
-    static std::vector<u8> ProcessData(const std::filesystem::path& filename,
+    /// @brief Converts a tilemap description into a flat array of little-endian u16 tile indices
+    /// (row-major, row 0 at the top). Expected source format:
+    ///
+    /// <Tilemap width="512" height="512" columns="8" rows="8">
+    ///     <Tiles>1,1,0,2,...</Tiles>
+    /// </Tilemap>
+    ///
+    /// `columns`/`rows` describe the grid of the tileset texture. Tile 0 is empty; indices are
+    /// stored as u16, so ones above 65535 are rejected.
+    static std::vector<u8> ProcessTilemap(std::span<const u8> source,
+                                          std::unordered_map<str, str>& metadata) {
+        pugi::xml_document doc;
+        if (!doc.load_buffer(source.data(), source.size())) {
+            throw BuildError("Failed to parse tilemap");
+        }
+
+        const auto root    = doc.child("Tilemap");
+        const u32 width    = root.attribute("width").as_uint();
+        const u32 height   = root.attribute("height").as_uint();
+        const u32 columns  = root.attribute("columns").as_uint(1);
+        const u32 rows     = root.attribute("rows").as_uint(1);
+        const size_t count = CAST<size_t>(width) * height;
+        if (count == 0) { throw BuildError("Tilemap has no tiles"); }
+
+        std::vector<u16> tiles;
+        tiles.reserve(count);
+        std::stringstream stream(root.child_value("Tiles"));
+        str token;
+        while (std::getline(stream, token, ',') && tiles.size() < count) {
+            if (token.find_first_not_of(" \t\r\n") == str::npos) { continue; }
+            tiles.push_back(
+              CAST<u16>(ParseUInt(token, "tile index", std::numeric_limits<u16>::max())));
+        }
+        if (tiles.size() != count) {
+            throw BuildError("Tile count does not match 'width' * 'height'");
+        }
+
+        std::vector<u8> result(count * sizeof(u16));
+        memcpy(result.data(), tiles.data(), result.size());
+
+        metadata.insert_or_assign("width", std::to_string(width));
+        metadata.insert_or_assign("height", std::to_string(height));
+        metadata.insert_or_assign("columns", std::to_string(columns));
+        metadata.insert_or_assign("rows", std::to_string(rows));
+
+        return result;
+    }
+
+    /// @brief Generates a signed distance field glyph atlas plus packed glyph metrics (see
+    /// FontFormat.hpp). Settings: <Size> in pixels (default 48), <Spread> in pixels (default 6)
+    /// and <Charset> as comma-separated codepoint ranges (default "32-126").
+    static std::vector<u8> ProcessFont(std::span<const u8> source,
+                                       const Asset& asset,
                                        std::unordered_map<str, str>& metadata) {
-        const auto data = ReadFile(filename);
-        metadata.insert_or_assign("size", std::to_string(data.size()));
-        return data;
+        const u32 size     = ParseUInt(asset.GetSetting("Size", "48"), "Size");
+        const u32 spread   = ParseUInt(asset.GetSetting("Spread", "6"), "Spread");
+        const auto charset = FontAtlas::ParseCharset(asset.GetSetting("Charset", "32-126"));
+        if (size == 0 || spread == 0) { throw BuildError("Font size and spread must be non-zero"); }
+        return FontAtlas::Build(source, size, spread, charset, metadata);
     }
 
-private:
-    static std::vector<u8> ReadFile(const std::filesystem::path& filename) {
-        if (!exists(filename)) { Panic("File not found"); }
-        std::ifstream file(filename, std::ios::binary | std::ios::ate);  // ate -> seeks to end
-        if (!file.is_open()) { Panic("Failed to open file"); }
-        const std::streamsize fileSize = file.tellg();
-        if (fileSize <= 0) { Panic("File size invalid ( <= zero )"); }
-        std::vector<u8> buffer(fileSize);
-        file.seekg(0, std::ios::beg);  // Move back to beginning of file
-        if (!file.read(RCAST<char*>(buffer.data()), fileSize)) { Panic("Failed to read file"); }
-        file.close();
-        return buffer;
+    /// @brief Packs every image under a directory into RGBA8 atlas pages (see AtlasBuilder.hpp
+    /// for the layout). Settings: <Padding> in pixels between sprites (default 2), <Trim> to crop
+    /// transparent borders (default true), <MaxSize> for the page edge (default 2048) and
+    /// <Mipmaps> as for textures, applied to each page.
+    static std::vector<u8> ProcessAtlas(const std::filesystem::path& directory,
+                                        const Asset& asset,
+                                        std::unordered_map<str, str>& metadata) {
+        if (!std::filesystem::is_directory(directory)) {
+            throw BuildError("Atlas source must be a directory: %s", directory.string().c_str());
+        }
+        const u32 padding = ParseUInt(asset.GetSetting("Padding", "2"), "Padding");
+        const bool trim   = asset.GetSetting("Trim", "true") == "true";
+        const u32 maxSize = ParseUInt(asset.GetSetting("MaxSize", "2048"), "MaxSize");
+        const bool mips   = asset.GetSetting("Mipmaps", "true") == "true";
+        return AtlasBuilder::Build(directory, padding, trim, maxSize, mips, metadata);
+    }
+
+    static std::vector<u8> ProcessData(std::vector<u8> source,
+                                       std::unordered_map<str, str>& metadata) {
+        if (source.empty()) { throw BuildError("File size invalid ( <= zero )"); }
+        metadata.insert_or_assign("size", std::to_string(source.size()));
+        return source;
     }
 };
\ No newline at end of file
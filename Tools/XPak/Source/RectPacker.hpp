@@ -0,0 +1,118 @@
+// Author: Jake Rieger
+// Created: 12/3/2024.
+//
+
+#pragma once
+
+#include <Types.hpp>
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <vector>
+
+struct PackedRect {
+    u32 X;
+    u32 Y;
+    u32 Width;
+    u32 Height;
+};
+
+/// @brief Skyline bottom-left rectangle packer. Tracks the top edge of the packed area as a list
+/// of horizontal segments and places each rect where it ends up lowest. Fully deterministic:
+/// the same sequence of inserts always produces the same layout.
+class SkylinePacker {
+public:
+    SkylinePacker(u32 width, u32 height) : mWidth(width), mHeight(height) {
+        mSkyline.push_back({0, 0, width});
+    }
+
+    [[nodiscard]] u32 GetWidth() const {
+        return mWidth;
+    }
+
+    [[nodiscard]] u32 GetHeight() const {
+        return mHeight;
+    }
+
+    std::optional<PackedRect> Insert(u32 width, u32 height) {
+        if (width == 0 || height == 0) { return PackedRect {0, 0, width, height}; }
+
+        size_t bestIndex = std::numeric_limits<size_t>::max();
+        u32 bestTop      = std::numeric_limits<u32>::max();
+        u32 bestWidth    = std::numeric_limits<u32>::max();
+        u32 bestY        = 0;
+        for (size_t i = 0; i < mSkyline.size(); ++i) {
+            const auto y = Fit(i, width, height);
+            if (!y.has_value()) { continue; }
+            const u32 top = *y + height;
+            if (top < bestTop || (top == bestTop && mSkyline[i].Width < bestWidth)) {
+                bestIndex = i;
+                bestTop   = top;
+                bestWidth = mSkyline[i].Width;
+                bestY     = *y;
+            }
+        }
+        if (bestIndex == std::numeric_limits<size_t>::max()) { return std::nullopt; }
+
+        const PackedRect rect {mSkyline[bestIndex].X, bestY, width, height};
+        AddSegment(bestIndex, rect);
+        return rect;
+    }
+
+private:
+    struct Segment {
+        u32 X;
+        u32 Y;
+        u32 Width;
+    };
+
+    u32 mWidth;
+    u32 mHeight;
+    std::vector<Segment> mSkyline;
+
+    /// @brief Returns the Y a rect would rest at if its left edge sat on segment `index`.
+    [[nodiscard]] std::optional<u32> Fit(size_t index, u32 width, u32 height) const {
+        const u32 x = mSkyline[index].X;
+        if (x + width > mWidth) { return std::nullopt; }
+
+        u32 y              = 0;
+        u32 remainingWidth = width;
+        for (size_t i = index; remainingWidth > 0; ++i) {
+            if (i >= mSkyline.size()) { return std::nullopt; }
+            y = std::max(y, mSkyline[i].Y);
+            if (y + height > mHeight) { return std::nullopt; }
+            remainingWidth -= std::min(remainingWidth, mSkyline[i].Width);
+        }
+        return y;
+    }
+
+    void AddSegment(size_t index, const PackedRect& rect) {
+        mSkyline.insert(mSkyline.begin() + CAST<i64>(index),
+                        {rect.X, rect.Y + rect.Height, rect.Width});
+
+        // Trim or remove the segments now covered by the new one
+        const u32 right = rect.X + rect.Width;
+        for (size_t i = index + 1; i < mSkyline.size();) {
+            auto& segment = mSkyline[i];
+            if (segment.X >= right) { break; }
+            const u32 overlap = right - segment.X;
+            if (overlap >= segment.Width) {
+                mSkyline.erase(mSkyline.begin() + CAST<i64>(i));
+                continue;
+            }
+            segment.X += overlap;
+            segment.Width -= overlap;
+            break;
+        }
+
+        // Merge neighbours at the same height
+        for (size_t i = 0; i + 1 < mSkyline.size();) {
+            if (mSkyline[i].Y == mSkyline[i + 1].Y) {
+                mSkyline[i].Width += mSkyline[i + 1].Width;
+                mSkyline.erase(mSkyline.begin() + CAST<i64>(i + 1));
+            } else {
+                ++i;
+            }
+        }
+    }
+};
@@ -0,0 +1,167 @@
+// Author: Jake Rieger
+// Created: 12/5/2024.
+//
+
+#pragma once
+
+#include "BlockCompression.hpp"
+
+#include <Panic.hpp>
+#include <TextureFormat.hpp>
+#include <Types.hpp>
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/// @brief Converts an RGBA8 mip chain (as produced by MipGenerator) into a block-compressed
+/// chain with the layout described in TextureFormat.hpp.
+class TextureEncoder {
+public:
+    static std::optional<EncodeQuality> ParseQuality(const str& name) {
+        if (name == "fast") { return EncodeQuality::Fast; }
+        if (name == "normal") { return EncodeQuality::Normal; }
+        if (name == "high") { return EncodeQuality::High; }
+        return std::nullopt;
+    }
+
+    /// @brief Encodes `levels` RGBA8 levels stored back to back in `image`. Work is split into
+    /// rows of blocks that each write to a fixed offset, so the output is identical for any
+    /// `threads` count (0 means one per hardware thread).
+    static std::vector<u8> Encode(const std::vector<u8>& image,
+                                  u32 width,
+                                  u32 height,
+                                  u32 levels,
+                                  TextureFormat format,
+                                  EncodeQuality quality,
+                                  u32 threads = 0) {
+        if (!TextureFormats::IsBlockCompressed(format)) { return image; }
+        const auto sourceSize =
+          TextureFormats::GetChainSize(TextureFormat::RGBA8, width, height, levels);
+        if (image.size() < sourceSize) { Panic("Texture data is smaller than its mip chain"); }
+
+        struct Job {
+            const u8* Source;
+            u8* Target;
+            u32 Width;
+            u32 Height;
+            u32 Row;
+        };
+
+        std::vector<u8> result(TextureFormats::GetChainSize(format, width, height, levels));
+        std::vector<Job> jobs;
+        const u8* source = image.data();
+        u8* target       = result.data();
+        for (u32 level = 0; level < std::max(levels, 1u); ++level) {
+            for (u32 row = 0; row < (height + 3) / 4; ++row) {
+                jobs.push_back({source, target, width, height, row});
+            }
+            source += TextureFormats::GetLevelSize(TextureFormat::RGBA8, width, height);
+            target += TextureFormats::GetLevelSize(format, width, height);
+            width  = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+
+        const auto encode = [format, quality](const Job& job) {
+            const u32 unitSize = TextureFormats::GetUnitSize(format);
+            const u32 columns  = (job.Width + 3) / 4;
+            u8* out            = job.Target + CAST<size_t>(job.Row) * columns * unitSize;
+            u8 texels[64];
+            for (u32 column = 0; column < columns; ++column, out += unitSize) {
+                GatherBlock(job.Source, job.Width, job.Height, column * 4, job.Row * 4, texels);
+                switch (format) {
+                    case TextureFormat::BC1:
+                        BlockCompression::EncodeBC1(texels, out, quality);
+                        break;
+                    case TextureFormat::BC3:
+                        BlockCompression::EncodeBC3(texels, out, quality);
+                        break;
+                    case TextureFormat::BC7:
+                    default:
+                        BlockCompression::EncodeBC7(texels, out, quality);
+                        break;
+                }
+            }
+        };
+
+        if (threads == 0) { threads = std::max(1u, std::thread::hardware_concurrency()); }
+        threads = std::min(threads, CAST<u32>(jobs.size()));
+        std::vector<std::future<void>> futures;
+        for (u32 worker = 1; worker < threads; ++worker) {
+            futures.emplace_back(std::async(std::launch::async, [&, worker]() {
+                for (size_t i = worker; i < jobs.size(); i += threads) {
+                    encode(jobs[i]);
+                }
+            }));
+        }
+        for (size_t i = 0; i < jobs.size(); i += threads) {
+            encode(jobs[i]);
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+
+        return result;
+    }
+
+    /// @brief Expands a block-compressed chain back to RGBA8, for verification and tooling.
+    static std::vector<u8> Decode(const std::vector<u8>& data,
+                                  u32 width,
+                                  u32 height,
+                                  u32 levels,
+                                  TextureFormat format) {
+        if (!TextureFormats::IsBlockCompressed(format)) { return data; }
+
+        std::vector<u8> result(
+          TextureFormats::GetChainSize(TextureFormat::RGBA8, width, height, levels));
+        const u8* source   = data.data();
+        u8* target         = result.data();
+        const u32 unitSize = TextureFormats::GetUnitSize(format);
+        for (u32 level = 0; level < std::max(levels, 1u); ++level) {
+            u8 texels[64];
+            for (u32 y = 0; y < height; y += 4) {
+                for (u32 x = 0; x < width; x += 4, source += unitSize) {
+                    switch (format) {
+                        case TextureFormat::BC1:
+                            BlockCompression::DecodeBC1(source, texels);
+                            break;
+                        case TextureFormat::BC3:
+                            BlockCompression::DecodeBC3(source, texels);
+                            break;
+                        case TextureFormat::BC7:
+                        default:
+                            BlockCompression::DecodeBC7(source, texels);
+                            break;
+                    }
+                    for (u32 row = 0; row < 4 && y + row < height; ++row) {
+                        const u32 count = std::min(4u, width - x) * 4;
+                        memcpy(target + ((CAST<size_t>(y) + row) * width + x) * 4,
+                               texels + row * 16,
+                               count);
+                    }
+                }
+            }
+            target += TextureFormats::GetLevelSize(TextureFormat::RGBA8, width, height);
+            width  = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+        return result;
+    }
+
+private:
+    /// @brief Copies the 4x4 block at (x, y), replicating the last row/column for blocks that
+    /// overhang the level so the padding doesn't pull endpoints toward black.
+    static void GatherBlock(const u8* level, u32 width, u32 height, u32 x, u32 y, u8* texels) {
+        for (u32 row = 0; row < 4; ++row) {
+            const u32 sy = std::min(y + row, height - 1);
+            for (u32 column = 0; column < 4; ++column) {
+                const u32 sx = std::min(x + column, width - 1);
+                memcpy(texels + (row * 4 + column) * 4,
+                       level + (CAST<size_t>(sy) * width + sx) * 4,
+                       4);
+            }
+        }
+    }
+};
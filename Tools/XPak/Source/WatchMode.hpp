@@ -0,0 +1,138 @@
+// Author: Jake Rieger
+// Created: 12/10/2024.
+//
+
+#pragma once
+
+#include "FileWatcher.hpp"
+#include "Manifest.hpp"
+
+#include <Panic.hpp>
+#include <ReloadChannel.hpp>
+#include <Types.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <ranges>
+#include <unordered_map>
+
+/// @brief `XPak watch`: builds the manifest, then rebuilds the assets whose sources change and
+/// tells running games which ones to reload (see ReloadChannel.hpp). Games reload from the loose
+/// outputs in this build's output directory, wherever their own content was copied to, so they
+/// are told before the archive is rewritten.
+class WatchMode {
+public:
+    /// @brief Games that haven't subscribed again for this long are assumed to have exited.
+    static constexpr auto kSubscriberTimeout = std::chrono::seconds(5);
+
+    /// @brief `load` creates the manifest with the command line's options applied. It is called
+    /// again whenever the manifest file itself changes.
+    WatchMode(fs::path manifestFile, std::function<Unique<Manifest>()> load, u16 port)
+        : mManifestFile(std::move(manifestFile)), mLoad(std::move(load)), mPort(port) {}
+
+    /// @brief Runs until the process is stopped.
+    [[noreturn]] void Run() {
+        auto channel = ReloadChannel::Open(mPort);
+        if (!channel) { Panic("Unable to listen for games on port %u", CAST<u32>(mPort)); }
+        mChannel = std::move(*channel);
+
+        Load();
+        mManifest->Build();
+        std::cout << "Watching " << mManifest->RootDir.string()
+                  << (mWatcher->IsPolling() ? " (polling)" : "")
+                  << " for changes; games connect on port " << mPort << std::endl;
+
+        for (;;) {
+            AcceptSubscribers();
+            const auto changed = mWatcher->Wait(kSubscriberCheckInterval);
+            if (changed.empty()) { continue; }
+            // A bad manifest edit or a build failure is reported and the next save retried
+            try {
+                Rebuild(changed);
+            } catch (const std::exception& error) {
+                std::cout << "  |  [ERROR] Rebuild failed: " << error.what() << std::endl;
+            }
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief How long to wait for file changes before checking for new games.
+    static constexpr auto kSubscriberCheckInterval = std::chrono::milliseconds(100);
+
+    fs::path mManifestFile;
+    std::function<Unique<Manifest>()> mLoad;
+    u16 mPort;
+    Unique<Manifest> mManifest;
+    fs::path mManifestPath;  // As the watcher reports it
+    Unique<FileWatcher> mWatcher;
+    ReloadChannel mChannel;
+    std::unordered_map<u16, Clock::time_point> mSubscribers;  // Port -> last heard from
+
+    void Load() {
+        mManifest     = mLoad();
+        mManifestPath = mManifest->RootDir / mManifestFile.filename();
+        // Writing outputs must not wake the watcher
+        mWatcher = std::make_unique<FileWatcher>(
+          mManifest->RootDir,
+          std::vector<fs::path> {mManifest->RootDir / mManifest->OutputDir});
+    }
+
+    void Rebuild(const std::vector<fs::path>& changed) {
+        const auto start = Clock::now();
+        Manifest::UpdateResult result;
+        if (std::ranges::find(changed, mManifestPath) != changed.end()) {
+            if (pugi::xml_document doc; !doc.load_file(mManifestPath.c_str())) {
+                std::cout << "  |  [WARNING] Ignoring unreadable manifest: "
+                          << mManifestPath.string() << std::endl;
+                return;
+            }
+            std::cout << "Manifest changed, reloading..." << std::endl;
+            Load();
+            std::vector<size_t> all(mManifest->Assets.size());
+            std::iota(all.begin(), all.end(), 0);
+            result = mManifest->Update(all);
+        } else {
+            const auto affected = mManifest->FindAffected(changed);
+            if (affected.empty()) { return; }
+            result = mManifest->Update(affected);
+        }
+        if (result.Failed > 0) {
+            std::cout << "  | " << result.Failed << " assets failed; watching for fixes"
+                      << std::endl;
+        }
+        if (result.Updated.empty()) { return; }
+
+        AcceptSubscribers();
+        const auto notified = Notify(result.Updated);
+        const auto elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+        std::cout << "  | Rebuilt " << result.Updated.size() << " assets in " << elapsed.count()
+                  << " ms; notified " << notified << " games" << std::endl;
+        if (!mManifest->Archive.empty()) { mManifest->WriteArchive(); }
+    }
+
+    void AcceptSubscribers() {
+        while (const auto datagram = mChannel.Receive(std::chrono::milliseconds(0))) {
+            if (datagram->Kind != ReloadChannel::Message::Subscribe) { continue; }
+            const auto [_, added] = mSubscribers.insert_or_assign(datagram->From, Clock::now());
+            if (added) { std::cout << "  | Game connected from port " << datagram->From << '\n'; }
+        }
+    }
+
+    /// @brief Sends `names` to every game still subscribed and returns how many there were.
+    size_t Notify(const std::vector<str>& names) {
+        const auto expired = Clock::now() - kSubscriberTimeout;
+        std::erase_if(mSubscribers, [&](const auto& subscriber) {
+            return subscriber.second < expired;
+        });
+        const auto outputDir = (mManifest->RootDir / mManifest->OutputDir).lexically_normal();
+        for (const auto& port : mSubscribers | std::views::keys) {
+            mChannel.SendReload(port, outputDir.string(), names);
+        }
+        return mSubscribers.size();
+    }
+};
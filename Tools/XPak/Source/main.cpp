@@ -2,12 +2,18 @@
 // Created: 11/14/2024.
 //
 
+#include "ArtifactStore.hpp"
 #include "Asset.hpp"
 #include "Manifest.hpp"
 #include "BuildCache.hpp"
+#include "BuildError.hpp"
+#include "BuildPipeline.hpp"
+#include "BuildPool.hpp"
 #include "Processors.inl"
+#include "WatchMode.hpp"
 
 #include <CLI/CLI.hpp>
+#include <algorithm>
 
 int main(int argc, char* argv[]) {
     CLI::App app("XEN Engine asset management and packing tool.", "XPak");
@@ -15,6 +21,43 @@ int main(int argc, char* argv[]) {
 
     str manifestFilename;
     app.add_option("-m,--manifest", manifestFilename, "Path to manifest file")->required();
+    u32 jobs = 0;
+    app.add_option("-j,--jobs", jobs, "Build threads (defaults to the number of cores)");
+    u64 memoryMiB = BuildPool::kDefaultMemoryBudget >> 20;
+    app.add_option("--memory",
+                   memoryMiB,
+                   "Memory budget for assets in flight, in MiB (excludes zstd-dict assets "
+                   "waiting for dictionary training)")
+      ->capture_default_str();
+    std::vector<str> stageWorkers;
+    const auto isStageCount = [](const str& value) -> str {
+        const auto separator = value.find('=');
+        if (separator == str::npos ||
+            std::ranges::find(Manifest::kStages, value.substr(0, separator)) ==
+              Manifest::kStages.end()) {
+            return "Expected <stage>=<count>: " + value;
+        }
+        return {};
+    };
+    app.add_option("--stage-workers",
+                   stageWorkers,
+                   "Threads per build stage as <stage>=<count>; the stages are read, decode, "
+                   "transform, compress and write")
+      ->delimiter(',')
+      ->check(isStageCount);
+    size_t queueCapacity = BuildPipeline::kDefaultQueueCapacity;
+    app.add_option("--queue-size", queueCapacity, "Assets queued in front of each build stage")
+      ->capture_default_str();
+    str artifactCache;
+    app.add_option("--artifact-cache",
+                   artifactCache,
+                   "Directory of built assets shared between machines")
+      ->envname("XPAK_ARTIFACT_CACHE");
+    u64 artifactCacheMiB = DirectoryArtifactStore::kDefaultMaxSize >> 20;
+    app.add_option("--artifact-cache-size",
+                   artifactCacheMiB,
+                   "Size the artifact cache is trimmed to, in MiB")
+      ->capture_default_str();
     app.add_flag_callback(
       "-v, --version",
       [&]() {
@@ -26,6 +69,7 @@ int main(int argc, char* argv[]) {
     bool build   = false;
     bool rebuild = false;
     bool clean   = false;
+    bool watch   = false;
 
     auto* buildCmd =
       app.add_subcommand("build", "Build manifest.")->callback([&]() { build = true; });
@@ -33,25 +77,58 @@ int main(int argc, char* argv[]) {
       app.add_subcommand("rebuild", "Rebuild manifest.")->callback([&]() { rebuild = true; });
     auto* cleanCmd =
       app.add_subcommand("clean", "Clean manifest.")->callback([&]() { clean = true; });
+    auto* watchCmd =
+      app.add_subcommand("watch", "Build manifest, then rebuild assets as their sources change.")
+        ->callback([&]() { watch = true; });
+    u16 watchPort = ReloadChannel::kDefaultPort;
+    watchCmd->add_option("-p,--port", watchPort, "Port running games connect to for reloads")
+      ->capture_default_str();
 
     app.require_subcommand(1);
     buildCmd->group("Action");
     rebuildCmd->group("Action");
     cleanCmd->group("Action");
+    watchCmd->group("Action");
 
     CLI11_PARSE(app, argc, argv);
 
-    Manifest manifest(manifestFilename);
-
-    if (build) {
-        std::cout << "Building manifest..." << std::endl;
-        manifest.Build();
-    } else if (rebuild) {
-        std::cout << "Rebuilding manifest..." << std::endl;
-        manifest.Rebuild();
-    } else if (clean) {
-        std::cout << "Clean manifest..." << std::endl;
-        manifest.Clean();
+    const auto load = [&] {
+        auto manifest           = std::make_unique<Manifest>(manifestFilename);
+        manifest->Jobs          = jobs;
+        manifest->MemoryBudget  = memoryMiB << 20;
+        manifest->QueueCapacity = std::max<size_t>(queueCapacity, 1);
+        for (const auto& entry : stageWorkers) {
+            const auto separator = entry.find('=');
+            manifest->StageWorkers.insert_or_assign(entry.substr(0, separator),
+                                                    ToUInt(entry.substr(separator + 1)));
+        }
+        if (!artifactCache.empty()) {
+            manifest->Artifacts =
+              std::make_shared<DirectoryArtifactStore>(artifactCache, artifactCacheMiB << 20);
+        }
+        return manifest;
+    };
+
+    try {
+        if (watch) {
+            std::cout << "Watching manifest..." << std::endl;
+            WatchMode(manifestFilename, load, watchPort).Run();
+        }
+
+        const auto manifest = load();
+        if (build) {
+            std::cout << "Building manifest..." << std::endl;
+            if (!manifest->Build()) { return 1; }
+        } else if (rebuild) {
+            std::cout << "Rebuilding manifest..." << std::endl;
+            if (!manifest->Rebuild()) { return 1; }
+        } else if (clean) {
+            std::cout << "Clean manifest..." << std::endl;
+            manifest->Clean();
+        }
+    } catch (const BuildError& error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 1;
     }
 
     return 0;